@@ -1138,6 +1138,10 @@ create_port_range_data_reset (create_port_range_data_t *data)
  */
 typedef struct
 {
+  report_binary_reader_t *binary; ///< Reader for binary report, if binary.
+  int binary_format;              ///< Whether the report is binary.
+  gint binary_state;              ///< Base64 decoder state for binary report.
+  guint binary_save;              ///< Base64 decoder save for binary report.
   char *detail_name;              ///< Name of current host detail.
   char *detail_value;             ///< Value of current host detail.
   char *detail_source_name;       ///< Name of source of current host detail.
@@ -1180,6 +1184,7 @@ typedef struct
 static void
 create_report_data_reset (create_report_data_t *data)
 {
+  report_binary_reader_free (data->binary);
   if (data->details)
     {
       guint index = data->details->len;
@@ -4819,11 +4824,6 @@ xml_context = NULL;
  */
 static GMarkupParser xml_parser;
 
-/**
- * @brief The nvt synchronization script for this daemon.
- */
-static const gchar *nvt_sync_script = SBINDIR "/greenbone-nvt-sync";
-
 
 /* Client state. */
 
@@ -8469,6 +8469,11 @@ gmp_xml_handle_start_element (/* unused */ GMarkupParseContext* context,
               {
                 /* Assume this is the wrapper REPORT. */
                 create_report_data->wrapper = 1;
+                if (strcmp (attribute, REPORT_BINARY_FORMAT_UUID) == 0)
+                  {
+                    create_report_data->binary_format = 1;
+                    create_report_data->binary = report_binary_reader_new ();
+                  }
                 set_client_state (CLIENT_CREATE_REPORT_REPORT);
               }
             else
@@ -10112,25 +10117,24 @@ buffer_overrides_xml (GString *buffer, iterator_t *overrides,
  * @brief Buffer XML for the NVT preference of a config.
  *
  * @param[in]  buffer  Buffer.
- * @param[in]  prefs   NVT preference iterator.
- * @param[in]  config  Config.
+ * @param[in]  prefs   NVT preference iterator, initialised with the config.
  * @param[in]  hide_passwords  Whether to hide passwords.
  */
 void
 buffer_config_preference_xml (GString *buffer, iterator_t *prefs,
-                              config_t config, int hide_passwords)
+                              int hide_passwords)
 {
-  char *real_name, *type, *value, *oid, *nvt = NULL;
-  const char *default_value;
+  char *real_name, *type, *value, *oid;
+  const char *default_value, *nvt = NULL;
 
   oid = nvt_preference_iterator_oid (prefs);
   type = nvt_preference_iterator_type (prefs);
   real_name = nvt_preference_iterator_real_name (prefs);
   default_value = nvt_preference_iterator_value (prefs);
-  value = nvt_preference_iterator_config_value (prefs, config);
+  value = nvt_preference_iterator_config_value (prefs);
 
   if (oid)
-    nvt = nvt_name (oid);
+    nvt = nvt_preference_iterator_nvt_name (prefs);
   buffer_xml_append_printf (buffer,
                             "<preference>"
                             "<nvt oid=\"%s\"><name>%s</name></nvt>"
@@ -10190,7 +10194,6 @@ buffer_config_preference_xml (GString *buffer, iterator_t *prefs,
   g_free (real_name);
   g_free (type);
   g_free (value);
-  g_free (nvt);
   g_free (oid);
 }
 
@@ -13261,22 +13264,23 @@ handle_get_configs (gmp_parser_t *gmp_parser, GError **error)
           int max_nvt_count = 0, known_nvt_count = 0;
 
           SENDF_TO_CLIENT_OR_FAIL ("<families>");
-          init_family_iterator (&families, config_families_growing, selector,
-                                1);
+          init_selector_family_iterator (&families, config_families_growing,
+                                         selector);
           while (next (&families))
             {
               int family_growing, family_max;
               int family_selected_count;
               const char *family;
 
-              family = family_iterator_name (&families);
+              family = selector_family_iterator_name (&families);
               if (family)
                 {
-                  family_growing = nvt_selector_family_growing
-                                    (selector, family, config_families_growing);
-                  family_max = family_nvt_count (family);
+                  family_growing
+                    = selector_family_iterator_growing (&families);
+                  family_max
+                    = selector_family_iterator_max_nvt_count (&families);
                   family_selected_count
-                    = nvt_selector_nvt_count (selector, family, family_growing);
+                    = selector_family_iterator_nvt_count (&families);
                   known_nvt_count += family_selected_count;
                 }
               else
@@ -13414,11 +13418,11 @@ handle_get_configs (gmp_parser_t *gmp_parser, GError **error)
             }
           cleanup_iterator (&prefs);
 
-          init_nvt_preference_iterator (&prefs, NULL);
+          init_nvt_preference_iterator (&prefs, NULL, config);
           while (next (&prefs))
             {
               GString *buffer = g_string_new ("");
-              buffer_config_preference_xml (buffer, &prefs, config, 1);
+              buffer_config_preference_xml (buffer, &prefs, 1);
               SEND_TO_CLIENT_OR_FAIL (buffer->str);
               g_string_free (buffer, TRUE);
             }
@@ -13810,179 +13814,43 @@ feed_type_name (int feed_type)
 static void
 get_nvt_feed (gmp_parser_t *gmp_parser, GError **error)
 {
-  gchar *feed_description, *feed_identification, *feed_version;
-
-  feed_description = NULL;
-  feed_identification = NULL;
-  feed_version = NULL;
+  gchar *feed_name, *feed_description, *feed_version, *sync_error;
 
-  if (gvm_get_sync_script_description (nvt_sync_script, &feed_description)
-      && gvm_get_sync_script_identification (nvt_sync_script,
-                                             &feed_identification,
-                                             NVT_FEED)
-      && gvm_get_sync_script_feed_version (nvt_sync_script,
-                                           &feed_version))
+  switch (manage_feed_info (NVT_FEED, &feed_name, &feed_version,
+                            &feed_description, &sync_error))
     {
-      gchar **ident = g_strsplit (feed_identification, "|", 6);
-      gchar *selftest_result = NULL;
-
-      if (ident[0] == NULL || ident[1] == NULL
-          || ident[2] == NULL || ident[3] == NULL)
-        {
-          g_strfreev (ident);
-          SEND_TO_CLIENT_OR_FAIL (XML_INTERNAL_ERROR ("get_feeds"));
-        }
-      else
-        {
-          SENDF_TO_CLIENT_OR_FAIL
-           ("<feed>"
-            "<type>NVT</type>"
-            "<name>%s</name>"
-            "<version>%s</version>"
-            "<description>%s</description>",
-            ident[3],
-            feed_version,
-            feed_description);
-          g_strfreev (ident);
-          if (gvm_sync_script_perform_selftest (nvt_sync_script,
-                                                &selftest_result)
-              == FALSE)
-            {
-              SENDF_TO_CLIENT_OR_FAIL ("<sync_not_available>"
-                                       "<error>%s</error>"
-                                       "</sync_not_available>",
-                                       selftest_result ? selftest_result : "");
-              g_free (selftest_result);
-            }
-
-          SEND_TO_CLIENT_OR_FAIL ("</feed>");
-        }
-
-      g_free (feed_version);
-    }
-  g_free (feed_identification);
-  g_free (feed_description);
-}
-
-/**
- * @brief Parse feed info entity.
- *
- * @param[in]  entity       Config XML.
- * @param[in]  config_path  Path to config XML file.
- * @param[out] name         Name of feed.
- * @param[out] version      Version of feed.
- * @param[out] description  Description of feed.
- *
- * @return 0 success, -1 error.
- */
-static int
-get_feed_info_parse (entity_t entity, const gchar *config_path,
-                     gchar **name, gchar **version, gchar **description)
-{
-  entity_t child;
-
-  assert (name && version && description);
-
-  child = entity_child (entity, "name");
-  if (child == NULL)
-    {
-      g_warning ("%s: Missing name in '%s'", __FUNCTION__, config_path);
-      return -1;
-    }
-  *name = entity_text (child);
-
-  child = entity_child (entity, "description");
-  if (child == NULL)
-    {
-      g_warning ("%s: Missing description in '%s'",
-                 __FUNCTION__, config_path);
-      return -1;
-    }
-  *description = entity_text (child);
-
-  child = entity_child (entity, "version");
-  if (child == NULL)
-    {
-      g_warning ("%s: Missing version in '%s'", __FUNCTION__, config_path);
-      return -1;
-    }
-  *version = entity_text (child);
-
-  return 0;
-}
-
-/**
- * @brief Get feed info.
- *
- * @param[in]  feed_type         Type of feed.
- * @param[out] feed_name         Name of feed.
- * @param[out] feed_version      Version of feed.
- * @param[out] feed_description  Description of feed.
- *
- * @return 0 success, -1 error.
- */
-static int
-get_feed_info (int feed_type, gchar **feed_name, gchar **feed_version,
-               gchar **feed_description)
-{
-  GError *error;
-  gchar *config_path, *xml, *name, *version, *description;
-  gsize xml_len;
-  entity_t entity;
-
-  assert (feed_type == SCAP_FEED || feed_type == CERT_FEED);
-
-  config_path = g_build_filename (feed_type == SCAP_FEED
-                                   ? GVM_SCAP_DATA_DIR
-                                   : GVM_CERT_DATA_DIR,
-                                  "feed.xml",
-                                  NULL);
-  g_debug ("%s: config_path: %s", __FUNCTION__, config_path);
-
-  /* Read the file in. */
-
-  error = NULL;
-  g_file_get_contents (config_path, &xml, &xml_len, &error);
-  if (error)
-    {
-      g_warning ("%s: Failed to read '%s': %s",
-                  __FUNCTION__,
-                 config_path,
-                 error->message);
-      g_error_free (error);
-      g_free (config_path);
-      return -1;
-    }
-
-  /* Parse it as XML. */
-
-  if (parse_entity (xml, &entity))
-    {
-      g_warning ("%s: Failed to parse '%s'", __FUNCTION__, config_path);
-      g_free (config_path);
-      return -1;
+      case 0:
+        break;
+      case -2:
+        SEND_TO_CLIENT_OR_FAIL (XML_INTERNAL_ERROR ("get_feeds"));
+        return;
+      default:
+        return;
     }
 
-  /* Get the report format properties from the XML. */
+  SENDF_TO_CLIENT_OR_FAIL
+   ("<feed>"
+    "<type>NVT</type>"
+    "<name>%s</name>"
+    "<version>%s</version>"
+    "<description>%s</description>",
+    feed_name,
+    feed_version,
+    feed_description);
+  g_free (feed_name);
+  g_free (feed_version);
+  g_free (feed_description);
 
-  if (get_feed_info_parse (entity, config_path, &name, &version, &description))
+  if (sync_error)
     {
-      g_free (config_path);
-      free_entity (entity);
-      return -1;
+      SENDF_TO_CLIENT_OR_FAIL ("<sync_not_available>"
+                               "<error>%s</error>"
+                               "</sync_not_available>",
+                               sync_error);
+      g_free (sync_error);
     }
-  g_free (config_path);
-
-  if (feed_name)
-    *feed_name = g_strdup (name);
-  if (feed_description)
-    *feed_description = g_strdup (description);
-  if (feed_version)
-    *feed_version = g_strdup (version);
 
-  free_entity (entity);
-
-  return 0;
+  SEND_TO_CLIENT_OR_FAIL ("</feed>");
 }
 
 /**
@@ -14004,7 +13872,8 @@ get_feed (gmp_parser_t *gmp_parser, GError **error, int feed_type)
       return;
     }
 
-  if (get_feed_info (feed_type, &feed_name, &feed_version, &feed_description))
+  if (manage_feed_info (feed_type, &feed_name, &feed_version,
+                        &feed_description, NULL))
     return;
 
   SENDF_TO_CLIENT_OR_FAIL
@@ -15641,7 +15510,7 @@ handle_get_preferences (gmp_parser_t *gmp_parser, GError **error)
       SEND_TO_CLIENT_OR_FAIL ("<get_preferences_response"
                               " status=\"" STATUS_OK "\""
                               " status_text=\"" STATUS_OK_TEXT "\">");
-      init_nvt_preference_iterator (&prefs, nvt_oid);
+      init_nvt_preference_iterator (&prefs, nvt_oid, config);
       if (get_preferences_data->preference)
         while (next (&prefs))
           {
@@ -15652,7 +15521,7 @@ handle_get_preferences (gmp_parser_t *gmp_parser, GError **error)
                          == 0))
               {
                 GString *buffer = g_string_new ("");
-                buffer_config_preference_xml (buffer, &prefs, config, 1);
+                buffer_config_preference_xml (buffer, &prefs, 1);
                 SEND_TO_CLIENT_OR_FAIL (buffer->str);
                 g_string_free (buffer, TRUE);
                 break;
@@ -15662,7 +15531,7 @@ handle_get_preferences (gmp_parser_t *gmp_parser, GError **error)
         while (next (&prefs))
           {
             GString *buffer = g_string_new ("");
-            buffer_config_preference_xml (buffer, &prefs, config, 1);
+            buffer_config_preference_xml (buffer, &prefs, 1);
             SEND_TO_CLIENT_OR_FAIL (buffer->str);
             g_string_free (buffer, TRUE);
           }
@@ -18875,11 +18744,11 @@ handle_get_tasks (gmp_parser_t *gmp_parser, GError **error)
           if (first_report_id && (get_tasks_data->get.trash == 0))
             {
               // TODO Could skip this count for tasks page.
-              if (report_counts (first_report_id,
-                                 &debugs, &holes_2, &infos_2, &logs,
-                                 &warnings_2, &false_positives,
-                                 &severity_2, apply_overrides,
-                                 0, min_qod))
+              if (report_summary_counts (first_report_id,
+                                         &debugs, &holes_2, &infos_2, &logs,
+                                         &warnings_2, &false_positives,
+                                         &severity_2, apply_overrides,
+                                         min_qod))
                 g_error ("%s: GET_TASKS: error getting counts for"
                          " first report, aborting",
                          __FUNCTION__);
@@ -18892,12 +18761,12 @@ handle_get_tasks (gmp_parser_t *gmp_parser, GError **error)
                 * doing the count again. */
               if (((first_report_id == NULL)
                   || (strcmp (second_last_report_id, first_report_id)))
-                  && report_counts (second_last_report_id,
-                                    &debugs, &holes_2, &infos_2,
-                                    &logs, &warnings_2,
-                                    &false_positives, &severity_2,
-                                    apply_overrides,
-                                    0, min_qod))
+                  && report_summary_counts (second_last_report_id,
+                                            &debugs, &holes_2, &infos_2,
+                                            &logs, &warnings_2,
+                                            &false_positives, &severity_2,
+                                            apply_overrides,
+                                            min_qod))
                 g_error ("%s: GET_TASKS: error getting counts for"
                          " second report, aborting",
                          __FUNCTION__);
@@ -18946,12 +18815,12 @@ handle_get_tasks (gmp_parser_t *gmp_parser, GError **error)
                       && strcmp (last_report_id,
                                 second_last_report_id)))
                 {
-                  if (report_counts
+                  if (report_summary_counts
                       (last_report_id,
                         &debugs, &holes, &infos, &logs,
                         &warnings, &false_positives, &severity,
                         apply_overrides,
-                        0, min_qod))
+                        min_qod))
                     g_error ("%s: GET_TASKS: error getting counts for"
                              " last report, aborting",
                              __FUNCTION__);
@@ -23320,13 +23189,54 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
       case CLIENT_CREATE_REPORT:
         {
           char *uuid;
+          gchar *binary;
+          int binary_ret, binary_results;
+
+          binary = NULL;
+          binary_results = 0;
+          binary_ret = 0;
+          if (create_report_data->binary_format
+              && create_report_data->results == NULL)
+            {
+              /* The binary report has been checked as it arrived.  The
+               * results are added from the checked copy when the report is
+               * imported, so the arrays that the XML report elements fill
+               * stay empty. */
+              create_report_data->details = make_array ();
+              create_report_data->host_ends = make_array ();
+              create_report_data->host_starts = make_array ();
+              create_report_data->results = make_array ();
+              free (create_report_data->scan_start);
+              free (create_report_data->scan_end);
+              create_report_data->scan_start = NULL;
+              create_report_data->scan_end = NULL;
+              if (create_report_data->binary == NULL)
+                binary_ret = -2;
+              else
+                binary_ret = report_binary_reader_finish
+                              (create_report_data->binary, &binary,
+                               &binary_results,
+                               &create_report_data->scan_start,
+                               &create_report_data->scan_end);
+            }
 
           array_terminate (create_report_data->results);
           array_terminate (create_report_data->host_ends);
           array_terminate (create_report_data->host_starts);
           array_terminate (create_report_data->details);
 
-          if (create_report_data->results == NULL)
+          if (binary_ret == -2)
+            SEND_TO_CLIENT_OR_FAIL
+             (XML_INTERNAL_ERROR ("create_report"));
+          else if (binary_ret == 1)
+            SEND_TO_CLIENT_OR_FAIL
+             (XML_ERROR_SYNTAX ("create_report",
+                                "Binary REPORT is not a supported version"));
+          else if (binary_ret)
+            SEND_TO_CLIENT_OR_FAIL
+             (XML_ERROR_SYNTAX ("create_report",
+                                "Binary REPORT is invalid"));
+          else if (create_report_data->results == NULL)
             SEND_TO_CLIENT_OR_FAIL
              (XML_ERROR_SYNTAX ("create_report",
                                 "A REPORT element is required"));
@@ -23337,6 +23247,8 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
                                 "Type must be 'scan'"));
           else switch (create_report
                         (create_report_data->results,
+                         binary,
+                         binary_results,
                          create_report_data->task_id,
                          create_report_data->task_name,
                          create_report_data->task_comment,
@@ -23390,6 +23302,9 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
                 break;
               default:
                 {
+                  /* The import process removes the binary report. */
+                  g_free (binary);
+                  binary = NULL;
                   SENDF_TO_CLIENT_OR_FAIL
                    (XML_OK_CREATED_ID ("create_report"),
                     uuid);
@@ -23399,6 +23314,12 @@ gmp_xml_handle_end_element (/* unused */ GMarkupParseContext* context,
                 }
             }
 
+          if (binary)
+            {
+              unlink (binary);
+              g_free (binary);
+            }
+
           gmp_parser->importing = 0;
           create_report_data_reset (create_report_data);
           set_client_state (CLIENT_AUTHENTIC);
@@ -29368,6 +29289,27 @@ gmp_xml_handle_text (/* unused */ GMarkupParseContext* context,
       APPEND (CLIENT_CREATE_REPORT_IN_ASSETS,
               &create_report_data->in_assets);
 
+      case CLIENT_CREATE_REPORT_REPORT:
+        if (create_report_data->binary)
+          {
+            guchar *decoded;
+            gsize decoded_len;
+
+            /* Decode and check the binary report.  GMarkup passes the
+             * whole text of the element at once, so the encoded report is
+             * in memory here.  The reader keeps only one decoded block,
+             * and rejects reports above its size limit. */
+            decoded = g_malloc ((text_len / 4) * 3 + 3);
+            decoded_len = g_base64_decode_step
+                           (text, text_len, decoded,
+                            &create_report_data->binary_state,
+                            &create_report_data->binary_save);
+            report_binary_reader_feed (create_report_data->binary, decoded,
+                                       decoded_len);
+            g_free (decoded);
+          }
+        break;
+
       APPEND (CLIENT_CREATE_REPORT_RR_ERRORS_ERROR_DESCRIPTION,
               &create_report_data->result_description);
 
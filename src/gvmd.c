@@ -1715,7 +1715,7 @@ main (int argc, char** argv)
   GOptionContext *option_context;
   static GOptionEntry option_entries[]
     = {
-        { "backup", '\0', 0, G_OPTION_ARG_NONE, &backup_database, "Backup the database.", NULL },
+        { "backup", '\0', 0, G_OPTION_ARG_NONE, &backup_database, "Backup the database, while gvmd keeps running.", NULL },
         { "check-alerts", '\0', 0, G_OPTION_ARG_NONE, &check_alerts, "Check SecInfo alerts.", NULL },
         { "client-watch-interval", '\0', 0, G_OPTION_ARG_INT,
           &client_watch_interval,
@@ -1784,7 +1784,7 @@ main (int argc, char** argv)
           G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE,
           &decrypt_all_credentials, NULL, NULL },
         { "new-password", '\0', 0, G_OPTION_ARG_STRING, &new_password, "Modify user's password and exit.", "<password>" },
-        { "optimize", '\0', 0, G_OPTION_ARG_STRING, &optimize, "Run an optimization: vacuum, analyze, cleanup-config-prefs, cleanup-port-names, cleanup-result-severities, cleanup-schedule-times, rebuild-report-cache or update-report-cache.", "<name>" },
+        { "optimize", '\0', 0, G_OPTION_ARG_STRING, &optimize, "Run an optimization: vacuum, analyze, advise-indexes, cleanup-config-prefs, cleanup-port-names, cleanup-result-severities, cleanup-schedule-times, create-advised-indexes, rebuild-report-cache or update-report-cache.", "<name>" },
         { "password", '\0', 0, G_OPTION_ARG_STRING, &password, "Password, for --create-user.", "<password>" },
         { "port", 'p', 0, G_OPTION_ARG_STRING, &manager_port_string, "Use port number <number>.", "<number>" },
         { "port2", '\0', 0, G_OPTION_ARG_STRING, &manager_port_string_2, "Use port number <number> for address 2.", "<number>" },
@@ -2077,7 +2077,8 @@ main (int argc, char** argv)
 
       g_info ("   Backing up database.");
 
-      /* TODO Not sure about locking.  Not used by Postgres.  Perhaps remove. */
+      /* The backup runs online, next to a running gvmd, so no lock is
+       * needed. */
 
       switch (manage_backup_db (database))
         {
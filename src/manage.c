@@ -1769,6 +1769,64 @@ send_config_preferences (config_t config, const char* section_name,
   return 0;
 }
 
+/**
+ * @brief Serialize the preferences from a config as sent to the scanner.
+ *
+ * The result only depends on the config and the NVT feed, so it can be
+ * cached.  File preferences with a value depend on the files of the task
+ * as well, so configs that have any of these are not serialized.
+ *
+ * @param[in]  config        Config.
+ * @param[in]  section_name  Name of preference section to serialize.
+ *
+ * @return Serialized preferences, or NULL if the section contains a file
+ *         preference with a value.
+ */
+static gchar*
+config_preferences_otp (config_t config, const char* section_name)
+{
+  iterator_t prefs;
+  GString *buffer;
+
+  buffer = g_string_new ("");
+  init_otp_pref_iterator (&prefs, config, section_name);
+  while (next (&prefs))
+    {
+      const char *pref_name = otp_pref_iterator_name (&prefs);
+      char *value;
+
+      if (strcmp (pref_name, "port_range") == 0)
+        continue;
+
+      value = preference_value (pref_name,
+                                otp_pref_iterator_value (&prefs));
+
+      if (strcmp (section_name, "PLUGINS_PREFS") == 0 && strlen (value))
+        {
+          char **splits;
+          int is_file = 0;
+          /* OID:PrefType:PrefName value */
+          splits = g_strsplit (pref_name, ":", 3);
+          if (splits && g_strv_length (splits) == 3
+              && strcmp (splits[1], "file") == 0)
+            is_file = 1;
+          g_strfreev (splits);
+          if (is_file)
+            {
+              g_free (value);
+              cleanup_iterator (&prefs);
+              g_string_free (buffer, TRUE);
+              return NULL;
+            }
+        }
+
+      g_string_append_printf (buffer, "%s <|> %s\n", pref_name, value);
+      g_free (value);
+    }
+  cleanup_iterator (&prefs);
+  return g_string_free (buffer, FALSE);
+}
+
 /**
  * @brief Send task preferences to the scanner.
  *
@@ -2152,7 +2210,7 @@ send_alive_test_preferences (target_t target)
 /* Slave tasks. */
 
 /* Defined in gmp.c. */
-void buffer_config_preference_xml (GString *, iterator_t *, config_t, int);
+void buffer_config_preference_xml (GString *, iterator_t *, int);
 
 /**
  * @brief Number of seconds to sleep between polls to slave.
@@ -3256,11 +3314,11 @@ slave_setup (gvm_connection_t *connection, const char *name, task_t task,
           }
         cleanup_iterator (&prefs);
 
-        init_nvt_preference_iterator (&prefs, NULL);
+        init_nvt_preference_iterator (&prefs, NULL, config);
         while (next (&prefs))
           {
             GString *buffer = g_string_new ("");
-            buffer_config_preference_xml (buffer, &prefs, config, 0);
+            buffer_config_preference_xml (buffer, &prefs, 0);
             if (gvm_server_sendf (&connection->session, "%s", buffer->str))
               {
                 cleanup_iterator (&prefs);
@@ -3583,15 +3641,8 @@ slave_setup (gvm_connection_t *connection, const char *name, task_t task,
             }
           free_entity (get_tasks);
 
-          /* Add results to assets. */
-          if (global_current_report)
-            {
-              hosts_set_identifiers (global_current_report);
-              hosts_set_max_severity (global_current_report, NULL, NULL);
-              hosts_set_details (global_current_report);
-            }
-
-          set_task_run_status (task, TASK_STATUS_DONE);
+          /* Add results to assets while finishing the scan. */
+          set_task_run_status_done (task, 1);
           break;
         }
 
@@ -4393,9 +4444,9 @@ cve_scan_host (task_t task, gvm_host_t *gvm_host)
                                         NULL, NULL, 0, NULL);
           while (next (&prognosis))
             {
-              const char *app, *cve;
+              const char *app, *cve, *location;
               double severity;
-              gchar *desc, *location;
+              gchar *desc;
               result_t result;
 
               if (global_current_report && (prognosis_report_host == 0))
@@ -4408,7 +4459,7 @@ cve_scan_host (task_t task, gvm_host_t *gvm_host)
 
               app = prognosis_iterator_cpe (&prognosis);
               cve = prognosis_iterator_cve (&prognosis);
-              location = app_location (report_host, app);
+              location = prognosis_iterator_app_location (&prognosis);
 
               desc = g_strdup_printf ("The host carries the product: %s\n"
                                       "It is vulnerable according to: %s.\n"
@@ -4451,7 +4502,6 @@ cve_scan_host (task_t task, gvm_host_t *gvm_host)
                                                  cve);
                     }
                 }
-              g_free (location);
             }
           cleanup_iterator (&prognosis);
 
@@ -5067,7 +5117,7 @@ static int
 run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
 {
   char title[128], *hosts, *port_range, *port, *uuid;
-  gchar *plugins;
+  gchar *plugins, *server_prefs, *plugins_prefs;
   int fail, pid, ret;
   GSList *files = NULL;
   GPtrArray *preference_files;
@@ -5217,9 +5267,19 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
       return -10;
     }
 
+  /* Get the plugin list and the config preferences.  These are cached per
+   * config, and only rebuilt when the config or the NVT feed changes. */
+
+  if (config_otp_cache (config, &plugins, &server_prefs, &plugins_prefs))
+    {
+      plugins = nvt_selector_plugins (config);
+      server_prefs = config_preferences_otp (config, "SERVER_PREFS");
+      plugins_prefs = config_preferences_otp (config, "PLUGINS_PREFS");
+      set_config_otp_cache (config, plugins, server_prefs, plugins_prefs);
+    }
+
   /* Send the plugin list. */
 
-  plugins = nvt_selector_plugins (config);
   if (plugins)
     {
       if (ssh_credential == 0 && smb_credential == 0 && esxi_credential == 0)
@@ -5247,6 +5307,8 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
   free (plugins);
   if (fail)
     {
+      g_free (server_prefs);
+      g_free (plugins_prefs);
       set_task_interrupted (task,
                             "Failed to send OTP plugin set."
                             "  Interrupting scan.");
@@ -5257,8 +5319,14 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
 
   /* Send the scanner and task preferences. */
 
-  if (send_config_preferences (config, "SERVER_PREFS", NULL, NULL))
+  if (server_prefs)
+    fail = send_to_server (server_prefs);
+  else
+    fail = send_config_preferences (config, "SERVER_PREFS", NULL, NULL);
+  g_free (server_prefs);
+  if (fail)
     {
+      g_free (plugins_prefs);
       set_task_interrupted (task,
                             "Failed to send OTP SERVER PREFS."
                             "  Interrupting scan.");
@@ -5269,6 +5337,7 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
 
   if (send_task_preferences (task))
     {
+      g_free (plugins_prefs);
       set_task_interrupted (task,
                             "Failed to send OTP task preferences."
                             "  Interrupting scan.");
@@ -5284,6 +5353,7 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
                        port_range ? port_range : "default"))
     {
       free (port_range);
+      g_free (plugins_prefs);
       set_task_interrupted (task,
                             "Failed to send OTP port_range."
                             "  Interrupting scan.");
@@ -5299,6 +5369,7 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
   if (port && sendf_to_server ("auth_port_ssh <|> %s\n", port))
     {
       free (port);
+      g_free (plugins_prefs);
       set_task_interrupted (task,
                             "Failed to send OTP auth_port_ssh."
                             "  Interrupting scan.");
@@ -5315,7 +5386,13 @@ run_otp_task (task_t task, scanner_t scanner, int from, char **report_id)
   /* Send the plugins preferences. */
 
   preference_files = g_ptr_array_new ();
-  if (send_config_preferences (config, "PLUGINS_PREFS", files, preference_files))
+  if (plugins_prefs)
+    fail = send_to_server (plugins_prefs);
+  else
+    fail = send_config_preferences (config, "PLUGINS_PREFS", files,
+                                    preference_files);
+  g_free (plugins_prefs);
+  if (fail)
     {
       g_ptr_array_free (preference_files, TRUE);
       slist_free (files);
@@ -7164,6 +7241,11 @@ manage_sync (sigset_t *sigmask_current,
   manage_sync_nvts (fork_update_nvt_cache);
   manage_sync_scap (sigmask_current);
   manage_sync_cert (sigmask_current);
+  manage_refresh_report_counts (sigmask_current);
+  manage_reap_trash (sigmask_current);
+  manage_sweep_report_host_detail_values (sigmask_current);
+  manage_prune_slow_filter_queries ();
+  manage_refresh_feed_info ();
 }
 
 /**
@@ -8057,17 +8139,6 @@ xsl_transform (gchar *stylesheet, gchar *xmlfile, gchar **param_names,
   return NULL;
 }
 
-/**
- * @brief Define a code snippet for get_nvti_xml.
- *
- * @param  x  Prefix for names in snippet.
- */
-#define DEF(x)                                                    \
-      const char* x = nvt_iterator_ ## x (nvts);                  \
-      gchar* x ## _text = x                                       \
-                          ? g_markup_escape_text (x, -1)          \
-                          : g_strdup ("");
-
 /**
  * @brief Create and return XML description for an NVT.
  *
@@ -8096,41 +8167,19 @@ get_nvti_xml (iterator_t *nvts, int details, int pref_count,
   if (details)
     {
       int tag_count;
-      GString *cert_refs_str, *tags_str, *buffer;
-      iterator_t cert_refs_iterator, tags;
+      GString *tags_str, *buffer;
+      iterator_t tags;
       gchar *tag_name_esc, *tag_value_esc, *tag_comment_esc;
-      char *default_timeout = nvt_default_timeout (oid);
+      gchar *feed_xml, *default_timeout;
 
-      DEF (family);
-      DEF (xref);
-      DEF (tag);
-
-#undef DEF
-
-      cert_refs_str = g_string_new ("");
-      if (manage_cert_loaded())
-        {
-          init_nvt_cert_bund_adv_iterator (&cert_refs_iterator, oid, 0, 0);
-          while (next (&cert_refs_iterator))
-            {
-              g_string_append_printf (cert_refs_str,
-                                      "<cert_ref type=\"CERT-Bund\" id=\"%s\"/>",
-                                      get_iterator_name (&cert_refs_iterator));
-          }
-          cleanup_iterator (&cert_refs_iterator);
+      /* The part of the XML that only depends on the feeds is cached per
+       * NVT by the NVT and CERT syncs.  Build it here only if the cache is
+       * out of date. */
 
-          init_nvt_dfn_cert_adv_iterator (&cert_refs_iterator, oid, 0, 0);
-          while (next (&cert_refs_iterator))
-            {
-              g_string_append_printf (cert_refs_str,
-                                      "<cert_ref type=\"DFN-CERT\" id=\"%s\"/>",
-                                      get_iterator_name (&cert_refs_iterator));
-          }
-          cleanup_iterator (&cert_refs_iterator);
-        }
-      else
+      if (nvt_xml_cache (oid, &feed_xml, &default_timeout))
         {
-          g_string_append (cert_refs_str, "<warning>database not available</warning>");
+          feed_xml = nvt_feed_xml (nvts, manage_cert_loaded ());
+          default_timeout = nvt_default_timeout (oid);
         }
 
       tags_str = g_string_new ("");
@@ -8186,18 +8235,7 @@ get_nvti_xml (iterator_t *nvts, int details, int pref_count,
                               "<creation_time>%s</creation_time>"
                               "<modification_time>%s</modification_time>"
                               "%s" // user_tags
-                              "<category>%d</category>"
-                              "<family>%s</family>"
-                              "<cvss_base>%s</cvss_base>"
-                              "<qod>"
-                              "<value>%s</value>"
-                              "<type>%s</type>"
-                              "</qod>"
-                              "<cve_id>%s</cve_id>"
-                              "<bugtraq_id>%s</bugtraq_id>"
-                              "<cert_refs>%s</cert_refs>"
-                              "<xrefs>%s</xrefs>"
-                              "<tags>%s</tags>"
+                              "%s" // category to tags
                               "<preference_count>%i</preference_count>"
                               "<timeout>%s</timeout>"
                               "<default_timeout>%s</default_timeout>",
@@ -8210,26 +8248,12 @@ get_nvti_xml (iterator_t *nvts, int details, int pref_count,
                                ? get_iterator_modification_time (nvts)
                                : "",
                               tags_str->str,
-                              nvt_iterator_category (nvts),
-                              family_text,
-                              nvt_iterator_cvss_base (nvts)
-                               ? nvt_iterator_cvss_base (nvts)
-                               : "",
-                              nvt_iterator_qod (nvts),
-                              nvt_iterator_qod_type (nvts),
-                              nvt_iterator_cve (nvts),
-                              nvt_iterator_bid (nvts),
-                              cert_refs_str->str,
-                              xref_text,
-                              tag_text,
+                              feed_xml,
                               pref_count,
                               timeout ? timeout : "",
                               default_timeout ? default_timeout : "");
-      g_free (family_text);
-      g_free (xref_text);
-      g_free (tag_text);
-      g_string_free(cert_refs_str, 1);
-      g_string_free(tags_str, 1);
+      g_free (feed_xml);
+      g_string_free (tags_str, 1);
 
       if (preferences)
         {
@@ -8245,9 +8269,9 @@ get_nvti_xml (iterator_t *nvts, int details, int pref_count,
                              timeout ? timeout : "",
                              default_timeout ? default_timeout : "");
 
-          init_nvt_preference_iterator (&prefs, nvt_oid);
+          init_nvt_preference_iterator (&prefs, nvt_oid, config);
           while (next (&prefs))
-            buffer_config_preference_xml (buffer, &prefs, config, 1);
+            buffer_config_preference_xml (buffer, &prefs, 1);
           cleanup_iterator (&prefs);
 
           xml_string_append (buffer, "</preferences>");
@@ -8255,7 +8279,7 @@ get_nvti_xml (iterator_t *nvts, int details, int pref_count,
 
       xml_string_append (buffer, close_tag ? "</nvt>" : "");
       msg = g_string_free (buffer, FALSE);
-      free (default_timeout);
+      g_free (default_timeout);
     }
   else
     {
@@ -8777,6 +8801,322 @@ gvm_get_sync_script_feed_version (const gchar * sync_script,
   return TRUE;
 }
 
+/**
+ * @brief NVT feed synchronization script.
+ */
+#define NVT_SYNC_SCRIPT SBINDIR "/greenbone-nvt-sync"
+
+/**
+ * @brief Feed metadata, as shown by GET_FEEDS.
+ */
+typedef struct
+{
+  gchar *key;         ///< Paths and stats of the files the info came from.
+  int status;         ///< 0 success, -1 info missing, -2 bad sync script.
+  gchar *name;        ///< Name of feed.
+  gchar *version;     ///< Version of feed.
+  gchar *description; ///< Description of feed.
+  gchar *sync_error;  ///< Sync script self test error, or NULL if passed.
+  time_t expiry;      ///< Time after which a failure is loaded again, or 0.
+} feed_info_t;
+
+/**
+ * @brief Seconds that a failure to get feed metadata is cached.
+ *
+ * Failures often come from the environment, like a missing tool or wrong
+ * permissions, which can be fixed without changing the feed files.
+ */
+#define FEED_INFO_FAILURE_TTL 60
+
+/**
+ * @brief Cached feed metadata, indexed by feed type.
+ *
+ * The main process refreshes this in manage_sync, so that the processes
+ * it forks for clients start with current info.
+ */
+static feed_info_t feed_infos[CERT_FEED + 1];
+
+/**
+ * @brief Append the path and stats of a file to a feed info key.
+ *
+ * @param[in]  key   Key.
+ * @param[in]  path  Path of file.
+ */
+static void
+feed_info_key_append (GString *key, const gchar *path)
+{
+  struct stat state;
+
+  if (stat (path, &state))
+    g_string_append_printf (key, "%s:-;", path);
+  else
+    g_string_append_printf (key, "%s:%lli.%lli.%lli;",
+                            path,
+                            (long long int) state.st_mtime,
+                            (long long int) state.st_size,
+                            (long long int) state.st_ino);
+}
+
+/**
+ * @brief Get the key that feed metadata is cached under.
+ *
+ * The key changes whenever one of the files that the metadata comes from
+ * changes.
+ *
+ * @param[in]  feed_type  Type of feed.
+ *
+ * @return Freshly allocated key.
+ */
+static gchar *
+feed_info_key (int feed_type)
+{
+  GString *key;
+
+  key = g_string_new ("");
+  if (feed_type == NVT_FEED)
+    {
+      feed_info_key_append (key, NVT_SYNC_SCRIPT);
+#ifdef GVM_NVT_DIR
+      /* The script reads the feed version from here. */
+      feed_info_key_append (key, GVM_NVT_DIR "/plugin_feed_info.inc");
+#endif
+    }
+  else
+    feed_info_key_append (key,
+                          feed_type == SCAP_FEED
+                           ? GVM_SCAP_DATA_DIR "/feed.xml"
+                           : GVM_CERT_DATA_DIR "/feed.xml");
+  return g_string_free (key, FALSE);
+}
+
+/**
+ * @brief Load NVT feed metadata from the NVT sync script.
+ *
+ * @param[out]  info  Feed info.
+ */
+static void
+feed_info_load_nvt (feed_info_t *info)
+{
+  gchar *description, *identification, *version;
+
+  description = NULL;
+  identification = NULL;
+  version = NULL;
+
+  if (gvm_get_sync_script_description (NVT_SYNC_SCRIPT, &description)
+      && gvm_get_sync_script_identification (NVT_SYNC_SCRIPT,
+                                             &identification,
+                                             NVT_FEED)
+      && gvm_get_sync_script_feed_version (NVT_SYNC_SCRIPT, &version))
+    {
+      gchar **ident;
+
+      ident = g_strsplit (identification, "|", 6);
+      if (ident[0] == NULL || ident[1] == NULL
+          || ident[2] == NULL || ident[3] == NULL)
+        {
+          info->status = -2;
+          g_free (version);
+        }
+      else
+        {
+          gchar *selftest_result;
+
+          info->status = 0;
+          info->name = g_strdup (ident[3]);
+          info->version = version;
+          info->description = description;
+          description = NULL;
+
+          selftest_result = NULL;
+          if (gvm_sync_script_perform_selftest (NVT_SYNC_SCRIPT,
+                                                &selftest_result)
+              == FALSE)
+            info->sync_error = selftest_result ? selftest_result
+                                               : g_strdup ("");
+        }
+      g_strfreev (ident);
+    }
+  else
+    {
+      info->status = -1;
+      g_free (version);
+    }
+
+  g_free (identification);
+  g_free (description);
+}
+
+/**
+ * @brief Load SCAP or CERT feed metadata from the feed XML.
+ *
+ * @param[in]   feed_type  Type of feed.
+ * @param[out]  info       Feed info.
+ */
+static void
+feed_info_load_xml (int feed_type, feed_info_t *info)
+{
+  GError *error;
+  gchar *config_path, *xml;
+  gsize xml_len;
+  entity_t entity, name, version, description;
+
+  info->status = -1;
+
+  config_path = g_build_filename (feed_type == SCAP_FEED
+                                   ? GVM_SCAP_DATA_DIR
+                                   : GVM_CERT_DATA_DIR,
+                                  "feed.xml",
+                                  NULL);
+  g_debug ("%s: config_path: %s", __FUNCTION__, config_path);
+
+  /* Read the file in. */
+
+  error = NULL;
+  g_file_get_contents (config_path, &xml, &xml_len, &error);
+  if (error)
+    {
+      g_warning ("%s: Failed to read '%s': %s",
+                 __FUNCTION__,
+                 config_path,
+                 error->message);
+      g_error_free (error);
+      g_free (config_path);
+      return;
+    }
+
+  /* Parse it as XML. */
+
+  if (parse_entity (xml, &entity))
+    {
+      g_warning ("%s: Failed to parse '%s'", __FUNCTION__, config_path);
+      g_free (xml);
+      g_free (config_path);
+      return;
+    }
+  g_free (xml);
+
+  /* Get the feed properties from the XML. */
+
+  name = entity_child (entity, "name");
+  description = entity_child (entity, "description");
+  version = entity_child (entity, "version");
+  if (name == NULL)
+    g_warning ("%s: Missing name in '%s'", __FUNCTION__, config_path);
+  else if (description == NULL)
+    g_warning ("%s: Missing description in '%s'",
+               __FUNCTION__, config_path);
+  else if (version == NULL)
+    g_warning ("%s: Missing version in '%s'", __FUNCTION__, config_path);
+  else
+    {
+      info->status = 0;
+      info->name = g_strdup (entity_text (name));
+      info->description = g_strdup (entity_text (description));
+      info->version = g_strdup (entity_text (version));
+    }
+
+  free_entity (entity);
+  g_free (config_path);
+}
+
+/**
+ * @brief Ensure the cached metadata of a feed is current.
+ *
+ * Only runs the sync script or parses the feed XML if one of the files
+ * the metadata comes from has changed since it was cached, or if the
+ * cached metadata is a failure older than FEED_INFO_FAILURE_TTL seconds.
+ *
+ * @param[in]  feed_type  Type of feed.
+ *
+ * @return Feed info.
+ */
+static feed_info_t *
+feed_info_refresh (int feed_type)
+{
+  feed_info_t *info;
+  gchar *key;
+
+  assert (feed_type == NVT_FEED
+          || feed_type == SCAP_FEED
+          || feed_type == CERT_FEED);
+
+  info = &feed_infos[feed_type];
+  key = feed_info_key (feed_type);
+  if (info->key && strcmp (info->key, key) == 0
+      && (info->expiry == 0 || time (NULL) < info->expiry))
+    {
+      g_free (key);
+      return info;
+    }
+
+  g_debug ("%s: loading info for feed %i", __FUNCTION__, feed_type);
+
+  g_free (info->key);
+  g_free (info->name);
+  g_free (info->version);
+  g_free (info->description);
+  g_free (info->sync_error);
+  memset (info, 0, sizeof (*info));
+
+  if (feed_type == NVT_FEED)
+    feed_info_load_nvt (info);
+  else
+    feed_info_load_xml (feed_type, info);
+
+  if (info->status || info->sync_error)
+    info->expiry = time (NULL) + FEED_INFO_FAILURE_TTL;
+  info->key = key;
+  return info;
+}
+
+/**
+ * @brief Refresh the cached metadata of all feeds.
+ *
+ * In gvmd, periodically called from the main daemon loop, via manage_sync.
+ */
+void
+manage_refresh_feed_info ()
+{
+  feed_info_refresh (NVT_FEED);
+  feed_info_refresh (SCAP_FEED);
+  feed_info_refresh (CERT_FEED);
+}
+
+/**
+ * @brief Get the metadata of a feed.
+ *
+ * @param[in]   feed_type    Type of feed.
+ * @param[out]  name         Name of feed.
+ * @param[out]  version      Version of feed.
+ * @param[out]  description  Description of feed.
+ * @param[out]  sync_error   Error from the self test of the sync script if
+ *                           it failed, else NULL.  Only for the NVT feed.
+ *
+ * @return 0 success, -1 feed info missing, -2 sync script gave a bad
+ *         identification.
+ */
+int
+manage_feed_info (int feed_type, gchar **name, gchar **version,
+                  gchar **description, gchar **sync_error)
+{
+  feed_info_t *info;
+
+  info = feed_info_refresh (feed_type);
+  if (info->status)
+    return info->status;
+
+  if (name)
+    *name = g_strdup (info->name);
+  if (version)
+    *version = g_strdup (info->version);
+  if (description)
+    *description = g_strdup (info->description);
+  if (sync_error)
+    *sync_error = g_strdup (info->sync_error);
+  return 0;
+}
+
 /**
  * @brief Migrates SCAP or CERT database, waiting until migration terminates.
  *
@@ -868,6 +868,9 @@ task_run_status (task_t);
 void
 set_task_run_status (task_t, task_status_t);
 
+void
+set_task_run_status_done (task_t, int);
+
 int
 task_result_count (task_t, int);
 
@@ -1275,9 +1278,46 @@ void
 update_duration_schedule_periods (task_t);
 
 int
-create_report (array_t*, const char *, const char *, const char *, const char *,
-               const char *, const char *, array_t*, array_t*, array_t*,
-               char **);
+create_report (array_t*, const gchar *, int, const char *, const char *,
+               const char *, const char *, const char *, const char *,
+               array_t*, array_t*, array_t*, char **);
+
+/**
+ * @brief UUID of the predefined binary report format.
+ */
+#define REPORT_BINARY_FORMAT_UUID "4ec4cdfc-cb31-11f1-a4ed-02fc00000001"
+
+/**
+ * @brief Version of the binary report format written by this Manager.
+ */
+#define REPORT_BINARY_VERSION 1
+
+/**
+ * @brief Reader for a binary report that arrives in pieces.
+ */
+typedef struct report_binary_reader report_binary_reader_t;
+
+int
+report_binary_write (report_t, const get_data_t *, const gchar *);
+
+report_binary_reader_t *
+report_binary_reader_new ();
+
+void
+report_binary_reader_free (report_binary_reader_t *);
+
+int
+report_binary_reader_feed (report_binary_reader_t *, const guchar *, gsize);
+
+int
+report_binary_reader_finish (report_binary_reader_t *, gchar **, int *,
+                             gchar **, gchar **);
+
+int
+report_binary_import (const gchar *,
+                      int (*) (array_t *, array_t *, array_t *, array_t *,
+                               void *),
+                      void *);
 
 void
 report_add_result (report_t, result_t);
@@ -1333,6 +1373,10 @@ int
 report_counts_id (report_t, int*, int*, int*, int*, int*, int*, double*,
                   const get_data_t*, const char*);
 
+int
+report_summary_counts (const char*, int*, int*, int*, int*, int*, int*,
+                       double*, int, int);
+
 int
 report_counts_id_no_filt (report_t, int*, int*, int*, int*, int*, int*,
                           double*, const get_data_t*, const char*);
@@ -1549,9 +1593,6 @@ manage_send_report (report_t, report_t, report_format_t, const get_data_t *,
 
 /* Reports. */
 
-gchar *
-app_location (report_host_t, const gchar *);
-
 void
 init_host_prognosis_iterator (iterator_t*, report_host_t, int, int,
                               const char *, const char *, int, const char *);
@@ -1568,6 +1609,9 @@ prognosis_iterator_cve (iterator_t*);
 const char*
 prognosis_iterator_description (iterator_t*);
 
+const char*
+prognosis_iterator_app_location (iterator_t*);
+
 
 /* Targets. */
 
@@ -2049,6 +2093,21 @@ init_family_iterator (iterator_t*, int, const char*, int);
 const char*
 family_iterator_name (iterator_t*);
 
+void
+init_selector_family_iterator (iterator_t*, int, const char*);
+
+const char*
+selector_family_iterator_name (iterator_t*);
+
+int
+selector_family_iterator_growing (iterator_t*);
+
+int
+selector_family_iterator_max_nvt_count (iterator_t*);
+
+int
+selector_family_iterator_nvt_count (iterator_t*);
+
 int
 nvt_selector_family_growing (const char *, const char *, int);
 
@@ -2083,7 +2142,7 @@ void
 manage_nvt_preferences_enable ();
 
 void
-init_nvt_preference_iterator (iterator_t*, const char*);
+init_nvt_preference_iterator (iterator_t*, const char*, config_t);
 
 const char*
 nvt_preference_iterator_name (iterator_t*);
@@ -2092,7 +2151,10 @@ const char*
 nvt_preference_iterator_value (iterator_t*);
 
 char*
-nvt_preference_iterator_config_value (iterator_t*, config_t);
+nvt_preference_iterator_config_value (iterator_t*);
+
+const char*
+nvt_preference_iterator_nvt_name (iterator_t*);
 
 char*
 nvt_preference_iterator_real_name (iterator_t*);
@@ -2866,6 +2928,18 @@ set_scheduled_user_uuid (const gchar* uuid);
 void
 manage_sync (sigset_t *, int (*fork_update_nvt_cache) ());
 
+void
+manage_refresh_report_counts (sigset_t *);
+
+void
+manage_reap_trash (sigset_t *);
+
+void
+manage_sweep_report_host_detail_values (sigset_t *);
+
+void
+manage_prune_slow_filter_queries ();
+
 int
 manage_schedule (manage_connection_forker_t,
                  gboolean,
@@ -4188,6 +4262,12 @@ gvm_get_sync_script_description (const gchar *, gchar **);
 gboolean
 gvm_get_sync_script_feed_version (const gchar *, gchar **);
 
+void
+manage_refresh_feed_info ();
+
+int
+manage_feed_info (int, gchar **, gchar **, gchar **, gchar **);
+
 
 /* Wizards. */
 
@@ -15268,6 +15268,838 @@ migrate_205_to_206 ()
   return 0;
 }
 
+/**
+ * @brief Migrate the database from version 206 to version 207.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_206_to_207 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 206. */
+
+  if (manage_db_version () != 206)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Reports got progress counters, so that progress does not have to be
+   * calculated from the report hosts on every request. */
+
+  sql ("ALTER TABLE reports ADD COLUMN progress_sum integer;");
+  sql ("ALTER TABLE reports ADD COLUMN progress_dead integer;");
+  sql ("ALTER TABLE reports ADD COLUMN progress_max_hosts integer;");
+
+  sql ("UPDATE reports"
+       " SET progress_sum"
+       "       = (SELECT coalesce (sum (CASE"
+       "                                WHEN max_port = -1"
+       "                                THEN 0"
+       "                                WHEN max_port IS NOT NULL"
+       "                                     AND max_port != 0"
+       "                                THEN (CASE"
+       "                                      WHEN current_port * 100"
+       "                                           / max_port"
+       "                                           > 100"
+       "                                      THEN 100"
+       "                                      WHEN current_port * 100"
+       "                                           / max_port"
+       "                                           < 0"
+       "                                      THEN 0"
+       "                                      ELSE current_port * 100"
+       "                                           / max_port"
+       "                                      END)"
+       "                                WHEN coalesce (current_port, 0) = 0"
+       "                                THEN 0"
+       "                                ELSE 100"
+       "                                END),"
+       "                           0)"
+       "          FROM report_hosts WHERE report = reports.id),"
+       "     progress_dead"
+       "       = (SELECT count (*) FROM report_hosts"
+       "          WHERE report = reports.id AND max_port = -1);");
+
+  /* Set the database version to 207. */
+
+  set_db_version (207);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 207 to version 208.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_207_to_208 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 207. */
+
+  if (manage_db_version () != 207)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table task_report_summaries was added.  It is filled as summaries are
+   * requested, so it starts empty. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS task_report_summaries"
+         " (id INTEGER PRIMARY KEY, task INTEGER, report INTEGER, user INTEGER,"
+         "  override INTEGER, min_qod INTEGER, date INTEGER, high INTEGER,"
+         "  medium INTEGER, low INTEGER, log INTEGER, false_positive INTEGER,"
+         "  severity REAL, end_time INTEGER);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS task_report_summaries"
+         " (id SERIAL PRIMARY KEY,"
+         "  task integer REFERENCES tasks (id) ON DELETE RESTRICT,"
+         "  report integer REFERENCES reports (id) ON DELETE RESTRICT,"
+         "  \"user\" integer REFERENCES users (id) ON DELETE RESTRICT,"
+         "  override integer,"
+         "  min_qod integer,"
+         "  date integer,"
+         "  high integer,"
+         "  medium integer,"
+         "  low integer,"
+         "  log integer,"
+         "  false_positive integer,"
+         "  severity double precision,"
+         "  end_time integer);");
+
+  /* Set the database version to 208. */
+
+  set_db_version (208);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 208 to version 209.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_208_to_209 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 208. */
+
+  if (manage_db_version () != 208)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table secinfo_changes was added.  It is filled by the SecInfo syncs, so
+   * it starts empty. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS secinfo_changes"
+         " (id INTEGER PRIMARY KEY, type, uuid, change INTEGER,"
+         "  item_time INTEGER, sync INTEGER);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS secinfo_changes"
+         " (id SERIAL PRIMARY KEY,"
+         "  type text,"
+         "  uuid text,"
+         "  change integer,"
+         "  item_time integer,"
+         "  sync integer);");
+
+  sql ("CREATE INDEX IF NOT EXISTS secinfo_changes_by_type_and_uuid"
+       " ON secinfo_changes (type, uuid);");
+
+  /* Set the database version to 209. */
+
+  set_db_version (209);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 209 to version 210.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_209_to_210 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 209. */
+
+  if (manage_db_version () != 209)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table secinfo_index was added.  Each feed is indexed at the end of its
+   * next sync, and All SecInfo uses the SecInfo tables until then. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS secinfo_index"
+         " (id INTEGER PRIMARY KEY, type, uuid, name, comment, created INTEGER,"
+         "  modified INTEGER, extra, severity REAL);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS secinfo_index"
+         " (id SERIAL PRIMARY KEY,"
+         "  type text,"
+         "  uuid text,"
+         "  name text,"
+         "  comment text,"
+         "  created integer,"
+         "  modified integer,"
+         "  extra text,"
+         "  severity double precision);");
+
+  /* Set the database version to 210. */
+
+  set_db_version (210);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 210 to version 211.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_210_to_211 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 210. */
+
+  if (manage_db_version () != 210)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Columns results.host_inet and report_hosts.host_inet were added, to sort
+   * and filter hosts by address without parsing the host text. */
+
+  if (sql_is_sqlite3 ())
+    {
+      sql ("ALTER TABLE results ADD COLUMN host_inet BLOB;");
+      sql ("ALTER TABLE report_hosts ADD COLUMN host_inet BLOB;");
+    }
+  else
+    {
+      sql ("ALTER TABLE results ADD COLUMN host_inet inet;");
+      sql ("ALTER TABLE report_hosts ADD COLUMN host_inet inet;");
+    }
+
+  sql ("UPDATE results SET host_inet = host_inet (host);");
+  sql ("UPDATE report_hosts SET host_inet = host_inet (host);");
+
+  sql ("CREATE INDEX IF NOT EXISTS results_by_host_inet"
+       " ON results (host_inet);");
+  sql ("CREATE INDEX IF NOT EXISTS results_by_report_host_inet"
+       " ON results (report, host_inet);");
+  sql ("CREATE INDEX IF NOT EXISTS report_hosts_by_report_and_host_inet"
+       " ON report_hosts (report, host_inet);");
+
+  /* Set the database version to 211. */
+
+  set_db_version (211);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 211 to version 212.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_211_to_212 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 211. */
+
+  if (manage_db_version () != 211)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table port_list_intervals was added, to hold the merged port ranges of
+   * each port list.  The intervals are compiled when gvmd next starts. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS port_list_intervals"
+         " (id INTEGER PRIMARY KEY, port_list INTEGER, type INTEGER,"
+         "  start INTEGER, end INTEGER);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS port_list_intervals"
+         " (id SERIAL PRIMARY KEY,"
+         "  port_list integer REFERENCES port_lists (id) ON DELETE RESTRICT,"
+         "  type integer,"
+         "  start integer,"
+         "  \"end\" integer);");
+
+  sql ("CREATE INDEX IF NOT EXISTS port_list_intervals_by_port_list"
+       " ON port_list_intervals (port_list, type, start);");
+
+  /* Set the database version to 212. */
+
+  set_db_version (212);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 212 to version 213.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_212_to_213 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 212. */
+
+  if (manage_db_version () != 212)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table report_counts_refresh was added, to queue report count rebuilds
+   * after override changes. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS report_counts_refresh"
+         " (id INTEGER PRIMARY KEY, report INTEGER, user INTEGER);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS report_counts_refresh"
+         " (id SERIAL PRIMARY KEY,"
+         "  report integer,"
+         "  \"user\" integer);");
+
+  sql ("CREATE INDEX IF NOT EXISTS report_counts_refresh_by_report"
+       " ON report_counts_refresh (report, \"user\");");
+
+  /* Set the database version to 213. */
+
+  set_db_version (213);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 213 to version 214.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_213_to_214 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 213. */
+
+  if (manage_db_version () != 213)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table config_otp_caches was added, to keep the serialized scanner
+   * plugin set and preferences of each config. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS config_otp_caches"
+         " (id INTEGER PRIMARY KEY, config INTEGER, modification_time INTEGER,"
+         "  feed_version, plugins TEXT, server_prefs TEXT,"
+         "  plugins_prefs TEXT);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS config_otp_caches"
+         " (id SERIAL PRIMARY KEY,"
+         "  config integer REFERENCES configs (id) ON DELETE RESTRICT,"
+         "  modification_time integer,"
+         "  feed_version text,"
+         "  plugins text,"
+         "  server_prefs text,"
+         "  plugins_prefs text);");
+
+  /* Set the database version to 214. */
+
+  set_db_version (214);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 214 to version 215.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_214_to_215 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 214. */
+
+  if (manage_db_version () != 214)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table nvt_xml_caches was added, to keep the feed dependent part of the
+   * NVT XML. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS nvt_xml_caches"
+         " (id INTEGER PRIMARY KEY, oid, modification_time INTEGER, xml TEXT,"
+         "  default_timeout);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS nvt_xml_caches"
+         " (id SERIAL PRIMARY KEY,"
+         "  oid text,"
+         "  modification_time integer,"
+         "  xml text,"
+         "  default_timeout text);");
+
+  sql ("CREATE INDEX IF NOT EXISTS nvt_xml_caches_by_oid"
+       " ON nvt_xml_caches (oid);");
+
+  /* Set the database version to 215. */
+
+  set_db_version (215);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 215 to version 216.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_215_to_216 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 215. */
+
+  if (manage_db_version () != 215)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Reports got a cached port count.  It is filled in on first use. */
+
+  sql ("ALTER TABLE reports ADD COLUMN port_count integer;");
+
+  /* Set the database version to 216. */
+
+  set_db_version (216);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 216 to version 217.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_216_to_217 ()
+{
+  int cert_loaded = manage_cert_loaded ();
+
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 216. */
+
+  if (manage_db_version () != 216)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* NVTs got flags for whether any CERT advisory refers to one of their
+   * CVEs.  They are kept up to date by the NVT and CERT syncs. */
+
+  sql ("ALTER TABLE nvts ADD COLUMN has_cert_bunds integer DEFAULT 0;");
+  sql ("ALTER TABLE nvts ADD COLUMN has_dfn_certs integer DEFAULT 0;");
+
+  if (cert_loaded)
+    sql ("UPDATE nvts"
+         " SET has_cert_bunds"
+         "       = (SELECT CASE WHEN EXISTS"
+         "                  (SELECT * FROM cert.cert_bund_cves"
+         "                   WHERE cve_name IN (SELECT cve_name FROM nvt_cves"
+         "                                      WHERE nvt_cves.oid = nvts.oid))"
+         "          THEN 1 ELSE 0 END),"
+         "     has_dfn_certs"
+         "       = (SELECT CASE WHEN EXISTS"
+         "                  (SELECT * FROM cert.dfn_cert_cves"
+         "                   WHERE cve_name IN (SELECT cve_name FROM nvt_cves"
+         "                                      WHERE nvt_cves.oid = nvts.oid))"
+         "          THEN 1 ELSE 0 END);");
+
+  /* Set the database version to 217. */
+
+  set_db_version (217);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 217 to version 218.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_217_to_218 ()
+{
+  long long int rows, values, size_before, size_after;
+
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 217. */
+
+  if (manage_db_version () != 217)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Host detail values are now stored once per distinct value, in
+   * report_host_detail_values.  The detail rows refer to them, and
+   * report_host_details became a view that joins the two. */
+
+  /* Depends on report_host_details.  Recreated by create_tables. */
+  sql ("DROP VIEW IF EXISTS results_autofp;");
+
+  if (sql_is_sqlite3 ())
+    {
+      sql ("CREATE TABLE report_host_detail_values"
+           " (id INTEGER PRIMARY KEY, hash, value);");
+      sql ("CREATE TABLE report_host_detail_rows"
+           " (id INTEGER PRIMARY KEY, report_host INTEGER, source_type,"
+           "  source_name, source_description, name, value_id INTEGER);");
+    }
+  else
+    {
+      sql ("CREATE TABLE report_host_detail_values"
+           " (id SERIAL PRIMARY KEY,"
+           "  hash text,"
+           "  value text);");
+      sql ("CREATE TABLE report_host_detail_rows"
+           " (id SERIAL PRIMARY KEY,"
+           "  report_host integer REFERENCES report_hosts (id)"
+           "                      ON DELETE RESTRICT,"
+           "  source_type text,"
+           "  source_name text,"
+           "  source_description text,"
+           "  name text,"
+           "  value_id integer);");
+    }
+  sql ("CREATE INDEX report_host_detail_values_by_hash"
+       " ON report_host_detail_values (hash);");
+
+  sql ("INSERT INTO report_host_detail_values (hash, value)"
+       " SELECT DISTINCT md5 (coalesce (value, '')), coalesce (value, '')"
+       " FROM report_host_details;");
+
+  sql ("INSERT INTO report_host_detail_rows"
+       " (id, report_host, source_type, source_name, source_description,"
+       "  name, value_id)"
+       " SELECT id, report_host, source_type, source_name,"
+       "        source_description, name,"
+       "        (SELECT report_host_detail_values.id"
+       "         FROM report_host_detail_values"
+       "         WHERE hash = md5 (coalesce (report_host_details.value, ''))"
+       "         AND report_host_detail_values.value"
+       "             = coalesce (report_host_details.value, '')"
+       "         LIMIT 1)"
+       " FROM report_host_details;");
+
+  /* Log the effect of the deduplication. */
+
+  rows = sql_int64_0 ("SELECT count (*) FROM report_host_detail_rows;");
+  values = sql_int64_0 ("SELECT count (*) FROM report_host_detail_values;");
+  size_before = sql_int64_0 ("SELECT coalesce (sum (length (value)), 0)"
+                             " FROM report_host_details;");
+  size_after = sql_int64_0 ("SELECT coalesce (sum (length (value)), 0)"
+                            " FROM report_host_detail_values;");
+  g_info ("%s: %lli host details share %lli distinct values."
+          "  Value text reduced from %lli to %lli characters.",
+          __FUNCTION__, rows, values, size_before, size_after);
+
+  sql ("DROP TABLE report_host_details;");
+
+  /* Set the database version to 218. */
+
+  set_db_version (218);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 218 to version 219.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_218_to_219 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 218. */
+
+  if (manage_db_version () != 218)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Slow filtered queries are now logged for the index advisor, which
+   * records the indexes it creates. */
+
+  if (sql_is_sqlite3 ())
+    {
+      sql ("CREATE TABLE IF NOT EXISTS slow_filter_queries"
+           " (id INTEGER PRIMARY KEY, table_name, shape, duration INTEGER,"
+           "  time INTEGER);");
+      sql ("CREATE TABLE IF NOT EXISTS advised_indexes"
+           " (id INTEGER PRIMARY KEY, name UNIQUE NOT NULL, table_name, shape,"
+           "  creation_time INTEGER, slow_count INTEGER,"
+           "  slow_duration INTEGER);");
+    }
+  else
+    {
+      sql ("CREATE TABLE IF NOT EXISTS slow_filter_queries"
+           " (id SERIAL PRIMARY KEY,"
+           "  table_name text,"
+           "  shape text,"
+           "  duration integer,"
+           "  time integer);");
+      sql ("CREATE TABLE IF NOT EXISTS advised_indexes"
+           " (id SERIAL PRIMARY KEY,"
+           "  name text UNIQUE NOT NULL,"
+           "  table_name text,"
+           "  shape text,"
+           "  creation_time integer,"
+           "  slow_count integer,"
+           "  slow_duration integer);");
+    }
+
+  /* Set the database version to 219. */
+
+  set_db_version (219);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 219 to version 220.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_219_to_220 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 219. */
+
+  if (manage_db_version () != 219)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table port_list_intervals_trash was added, to hold the merged port
+   * ranges of trashcan port lists.  The intervals are compiled when gvmd
+   * next starts. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS port_list_intervals_trash"
+         " (id INTEGER PRIMARY KEY, port_list INTEGER, type INTEGER,"
+         "  start INTEGER, end INTEGER);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS port_list_intervals_trash"
+         " (id SERIAL PRIMARY KEY,"
+         "  port_list integer REFERENCES port_lists_trash (id)"
+         "            ON DELETE RESTRICT,"
+         "  type integer,"
+         "  start integer,"
+         "  \"end\" integer);");
+
+  sql ("CREATE INDEX IF NOT EXISTS port_list_intervals_trash_by_port_list"
+       " ON port_list_intervals_trash (port_list);");
+
+  /* Set the database version to 220. */
+
+  set_db_version (220);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 220 to version 221.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_220_to_221 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 220. */
+
+  if (manage_db_version () != 220)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table nvt_xml_caches got a column cert_loaded, which records whether
+   * the cached XML includes CERT references.  The caches are now built
+   * during the NVT and CERT syncs, and rebuilt when gvmd next starts. */
+
+  sql ("DELETE FROM nvt_xml_caches;");
+  sql ("ALTER TABLE nvt_xml_caches ADD COLUMN cert_loaded INTEGER;");
+
+  /* Set the database version to 221. */
+
+  set_db_version (221);
+
+  sql_commit ();
+
+  return 0;
+}
+
+/**
+ * @brief Migrate the database from version 221 to version 222.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+migrate_221_to_222 ()
+{
+  sql_begin_immediate ();
+
+  /* Ensure that the database is currently version 221. */
+
+  if (manage_db_version () != 221)
+    {
+      sql_rollback ();
+      return -1;
+    }
+
+  /* Update the database. */
+
+  /* Table report_host_detail_values_sweep was added, to queue host detail
+   * values for removal.  Deleting the values together with their rows
+   * could race with a concurrent insert, leaving rows without a value.
+   * Remove any such rows, and queue any values without rows. */
+
+  if (sql_is_sqlite3 ())
+    sql ("CREATE TABLE IF NOT EXISTS report_host_detail_values_sweep"
+         " (id INTEGER PRIMARY KEY, value_id INTEGER);");
+  else
+    sql ("CREATE TABLE IF NOT EXISTS report_host_detail_values_sweep"
+         " (id SERIAL PRIMARY KEY,"
+         "  value_id integer);");
+
+  sql ("DELETE FROM report_host_detail_rows"
+       " WHERE value_id IS NULL"
+       " OR NOT EXISTS (SELECT * FROM report_host_detail_values"
+       "                WHERE id = report_host_detail_rows.value_id);");
+
+  sql ("INSERT INTO report_host_detail_values_sweep (value_id)"
+       " SELECT id FROM report_host_detail_values"
+       " WHERE NOT EXISTS (SELECT * FROM report_host_detail_rows"
+       "                   WHERE value_id = report_host_detail_values.id);");
+
+  /* Set the database version to 222. */
+
+  set_db_version (222);
+
+  sql_commit ();
+
+  return 0;
+}
+
 #undef UPDATE_CHART_SETTINGS
 #undef UPDATE_DASHBOARD_SETTINGS
 
@@ -15493,6 +16325,22 @@ static migrator_t database_migrators[]
     {204, migrate_203_to_204},
     {205, migrate_204_to_205}, // v8.0: rev 205
     {206, migrate_205_to_206},
+    {207, migrate_206_to_207},
+    {208, migrate_207_to_208},
+    {209, migrate_208_to_209},
+    {210, migrate_209_to_210},
+    {211, migrate_210_to_211},
+    {212, migrate_211_to_212},
+    {213, migrate_212_to_213},
+    {214, migrate_213_to_214},
+    {215, migrate_214_to_215},
+    {216, migrate_215_to_216},
+    {217, migrate_216_to_217},
+    {218, migrate_217_to_218},
+    {219, migrate_218_to_219},
+    {220, migrate_219_to_220},
+    {221, migrate_220_to_221},
+    {222, migrate_221_to_222},
     /* End marker. */
     {-1, NULL}};
 
@@ -27,6 +27,12 @@
 
 #include <strings.h> /* for strcasecmp() */
 #include <assert.h>  /* for assert() */
+#include <errno.h>   /* for errno */
+#include <stdio.h>   /* for FILE, fopen(), rename() */
+#include <string.h>  /* for strerror() */
+#include <unistd.h>  /* for unlink() */
+
+#include <gvm/util/compressutils.h>
 
 #include "sql.h"
 #include "manage_sql.h"
@@ -746,68 +752,53 @@ manage_create_sql_functions ()
 
   sql ("CREATE OR REPLACE FUNCTION report_progress_active (integer)"
        " RETURNS integer AS $$"
-       /* Calculate the progress of an active report. */
+       /* Calculate the progress of an active report, from the progress
+        * counters maintained in the report. */
        " DECLARE"
        "   report_task integer;"
        "   task_target integer;"
        "   target_hosts text;"
        "   target_exclude_hosts text;"
-       "   progress integer;"
-       "   total integer;"
        "   maximum_hosts integer;"
        "   total_progress integer;"
-       "   report_host record;"
-       "   dead_hosts integer;"
+       "   counts record;"
        " BEGIN"
-       "   total := 0;"
-       "   dead_hosts := 0;"
-       "   report_task := (SELECT task FROM reports WHERE id = $1);"
-       "   task_target := (SELECT target FROM tasks WHERE id = report_task);"
-       "   IF task_target IS NULL THEN"
-       "     target_hosts := NULL;"
-       "     target_exclude_hosts := NULL;"
-       "   ELSIF (SELECT target_location = " G_STRINGIFY (LOCATION_TRASH)
-       "          FROM tasks WHERE id = report_task)"
-       "   THEN"
-       "     target_hosts := (SELECT hosts FROM targets_trash"
-       "                      WHERE id = task_target);"
-       "     target_exclude_hosts := (SELECT exclude_hosts FROM targets_trash"
-       "                              WHERE id = task_target);"
-       "   ELSE"
-       "     target_hosts := (SELECT hosts FROM targets"
-       "                      WHERE id = task_target);"
-       "     target_exclude_hosts := (SELECT exclude_hosts FROM targets"
-       "                              WHERE id = task_target);"
-       "   END IF;"
-       "   IF target_hosts IS NULL THEN"
-       "     RETURN 0;"
+       "   SELECT coalesce (progress_sum, 0) AS total,"
+       "          coalesce (progress_dead, 0) AS dead_hosts,"
+       "          progress_max_hosts AS maximum_hosts"
+       "   INTO counts"
+       "   FROM reports WHERE id = $1;"
+       "   maximum_hosts := counts.maximum_hosts;"
+       "   IF maximum_hosts IS NULL THEN"
+       "     report_task := (SELECT task FROM reports WHERE id = $1);"
+       "     task_target := (SELECT target FROM tasks WHERE id = report_task);"
+       "     IF task_target IS NULL THEN"
+       "       target_hosts := NULL;"
+       "       target_exclude_hosts := NULL;"
+       "     ELSIF (SELECT target_location = " G_STRINGIFY (LOCATION_TRASH)
+       "            FROM tasks WHERE id = report_task)"
+       "     THEN"
+       "       target_hosts := (SELECT hosts FROM targets_trash"
+       "                        WHERE id = task_target);"
+       "       target_exclude_hosts := (SELECT exclude_hosts FROM targets_trash"
+       "                                WHERE id = task_target);"
+       "     ELSE"
+       "       target_hosts := (SELECT hosts FROM targets"
+       "                        WHERE id = task_target);"
+       "       target_exclude_hosts := (SELECT exclude_hosts FROM targets"
+       "                                WHERE id = task_target);"
+       "     END IF;"
+       "     IF target_hosts IS NULL THEN"
+       "       RETURN 0;"
+       "     END IF;"
+       "     maximum_hosts := max_hosts (target_hosts, target_exclude_hosts);"
        "   END IF;"
-       "   maximum_hosts := max_hosts (target_hosts, target_exclude_hosts);"
        "   IF maximum_hosts = 0 THEN"
        "     RETURN 0;"
        "   END IF;"
-       "   FOR report_host IN SELECT current_port, max_port"
-       "                      FROM report_hosts WHERE report = $1"
-       "   LOOP"
-       "     IF report_host.max_port = -1 THEN"
-       "       progress := 0;"
-       "       dead_hosts := dead_hosts + 1;"
-       "     ELSEIF report_host.max_port IS NOT NULL"
-       "        AND report_host.max_port != 0"
-       "     THEN"
-       "       progress := (report_host.current_port * 100)"
-       "                   / report_host.max_port;"
-       "     ELSIF report_host.current_port IS NULL"
-       "           OR report_host.current_port = 0"
-       "     THEN"
-       "       progress := 0;"
-       "     ELSE"
-       "       progress := 100;"
-       "     END IF;"
-       "     total := total + progress;"
-       "   END LOOP;"
-       "   IF (maximum_hosts - dead_hosts) > 0 THEN"
-       "     total_progress := total / (maximum_hosts - dead_hosts);"
+       "   IF (maximum_hosts - counts.dead_hosts) > 0 THEN"
+       "     total_progress := counts.total"
+       "                       / (maximum_hosts - counts.dead_hosts);"
        "   ELSE"
        "     total_progress := 0;"
        "   END IF;"
@@ -839,6 +830,26 @@ manage_create_sql_functions ()
        "$$ LANGUAGE plpgsql"
        " IMMUTABLE;");
 
+  /* Plain IPv4 addresses are checked with a pattern, to avoid setting up an
+   * exception block for the common case. */
+  sql ("CREATE OR REPLACE FUNCTION host_inet (text)"
+       " RETURNS inet AS $$"
+       " BEGIN"
+       "   IF $1 ~ '^((25[0-5]|2[0-4][0-9]|1?[0-9]?[0-9])\\.){3}"
+       "(25[0-5]|2[0-4][0-9]|1?[0-9]?[0-9])$' THEN"
+       "     RETURN $1::inet;"
+       "   ELSIF $1 ~ '^[0-9a-fA-F:.]*:[0-9a-fA-F:.]*$' THEN"
+       "     BEGIN"
+       "       RETURN $1::inet;"
+       "     EXCEPTION WHEN invalid_text_representation THEN"
+       "       RETURN NULL;"
+       "     END;"
+       "   END IF;"
+       "   RETURN NULL;"
+       " END;"
+       "$$ LANGUAGE plpgsql"
+       " IMMUTABLE;");
+
   sql ("CREATE OR REPLACE FUNCTION order_message_type (text)"
        " RETURNS integer AS $$"
        " BEGIN"
@@ -1536,27 +1547,56 @@ manage_create_sql_functions ()
         sql ("CREATE OR REPLACE FUNCTION task_severity (integer, integer,"
              "                                          integer)"
              " RETURNS double precision AS $$"
-             /* Calculate the severity of a task. */
-             "  SELECT CASE"
-             "         WHEN (SELECT target = 0"
-             "               FROM tasks WHERE id = $1)"
-             "         THEN CAST (NULL AS double precision)"
-             "         ELSE"
-             "         (SELECT report_severity ((SELECT id FROM reports"
-             "                                   WHERE task = $1"
-             "                                   AND scan_run_status = %u"
-             "                                   ORDER BY date DESC"
-             "                                   LIMIT 1 OFFSET 0), $2, $3))"
-             "         END;"
-             "$$ LANGUAGE SQL;",
-             TASK_STATUS_DONE);
+             /* Calculate the severity of a task, preferring the summary of
+              * the last report. */
+             " DECLARE"
+             "   last_report integer;"
+             "   summary_severity double precision;"
+             " BEGIN"
+             "   IF (SELECT target = 0 FROM tasks WHERE id = $1) THEN"
+             "     RETURN CAST (NULL AS double precision);"
+             "   END IF;"
+             "   last_report := task_last_report ($1);"
+             "   IF NOT dynamic_severity () THEN"
+             "     summary_severity := report_summary_severity (last_report,"
+             "                                                  $2, $3);"
+             "     IF summary_severity IS NOT NULL THEN"
+             "       RETURN summary_severity;"
+             "     END IF;"
+             "   END IF;"
+             "   RETURN report_severity (last_report, $2, $3);"
+             " END;"
+             "$$ LANGUAGE plpgsql;");
+
+      sql ("CREATE OR REPLACE FUNCTION report_summary_severity (integer,"
+           "                                                    integer,"
+           "                                                    integer)"
+           " RETURNS double precision AS $$"
+           /* Get the severity of a report from the task report summary of
+            * the current user, if there is a valid one. */
+           " BEGIN"
+           "   RETURN (SELECT severity FROM task_report_summaries"
+           "           WHERE report = $1"
+           "           AND override = $2"
+           "           AND min_qod = $3"
+           "           AND \"user\" = (SELECT id FROM users"
+           "                           WHERE uuid = (SELECT uuid"
+           "                                         FROM current_credentials))"
+           "           AND (end_time = 0 OR end_time >= m_now ()));"
+           " END;"
+           "$$ LANGUAGE plpgsql;");
 
       sql ("CREATE OR REPLACE FUNCTION task_trend (integer, integer, integer)"
            " RETURNS text AS $$"
-           /* Calculate the trend of a task. */
+           /* Calculate the trend of a task, preferring the summaries of the
+            * last two reports. */
            " DECLARE"
            "   last_report integer;"
            "   second_last_report integer;"
+           "   summary_a record;"
+           "   summary_b record;"
+           "   found_a boolean;"
+           "   found_b boolean;"
            "   severity_a double precision;"
            "   severity_b double precision;"
            "   high_a bigint;"
@@ -1587,26 +1627,68 @@ manage_create_sql_functions ()
            /*  Check if the severity score changed. */
            "   last_report := task_last_report ($1);"
            "   second_last_report := task_second_last_report ($1);"
-           "   severity_a := report_severity (last_report, $2, $3);"
-           "   severity_b := report_severity (second_last_report, $2, $3);"
+           "   found_a := false;"
+           "   found_b := false;"
+           "   IF NOT dynamic_severity () THEN"
+           "     SELECT severity, high, medium, low INTO summary_a"
+           "     FROM task_report_summaries"
+           "     WHERE report = last_report"
+           "     AND override = $2 AND min_qod = $3"
+           "     AND \"user\" = (SELECT id FROM users"
+           "                     WHERE uuid = (SELECT uuid"
+           "                                   FROM current_credentials))"
+           "     AND (end_time = 0 OR end_time >= m_now ());"
+           "     found_a := FOUND;"
+           "     SELECT severity, high, medium, low INTO summary_b"
+           "     FROM task_report_summaries"
+           "     WHERE report = second_last_report"
+           "     AND override = $2 AND min_qod = $3"
+           "     AND \"user\" = (SELECT id FROM users"
+           "                     WHERE uuid = (SELECT uuid"
+           "                                   FROM current_credentials))"
+           "     AND (end_time = 0 OR end_time >= m_now ());"
+           "     found_b := FOUND;"
+           "   END IF;"
+           "   IF found_a THEN"
+           "     severity_a := summary_a.severity;"
+           "   ELSE"
+           "     severity_a := report_severity (last_report, $2, $3);"
+           "   END IF;"
+           "   IF found_b THEN"
+           "     severity_b := summary_b.severity;"
+           "   ELSE"
+           "     severity_b := report_severity (second_last_report, $2, $3);"
+           "   END IF;"
            "   IF severity_a > severity_b THEN"
            "     RETURN 'up'::text;"
            "   ELSIF severity_b > severity_a THEN"
            "     RETURN 'down'::text;"
            "   END IF;"
            /*  Calculate trend. */
-           "   high_a := report_severity_count (last_report, $2, $3,"
-           "                                    'high');"
-           "   high_b := report_severity_count (second_last_report, $2, $3,"
-           "                                    'high');"
-           "   medium_a := report_severity_count (last_report, $2, $3,"
-           "                                      'medium');"
-           "   medium_b := report_severity_count (second_last_report, $2, $3,"
-           "                                      'medium');"
-           "   low_a := report_severity_count (last_report, $2, $3,"
-           "                                   'low');"
-           "   low_b := report_severity_count (second_last_report, $2, $3,"
-           "                                   'low');"
+           "   IF found_a THEN"
+           "     high_a := summary_a.high;"
+           "     medium_a := summary_a.medium;"
+           "     low_a := summary_a.low;"
+           "   ELSE"
+           "     high_a := report_severity_count (last_report, $2, $3,"
+           "                                      'high');"
+           "     medium_a := report_severity_count (last_report, $2, $3,"
+           "                                        'medium');"
+           "     low_a := report_severity_count (last_report, $2, $3,"
+           "                                     'low');"
+           "   END IF;"
+           "   IF found_b THEN"
+           "     high_b := summary_b.high;"
+           "     medium_b := summary_b.medium;"
+           "     low_b := summary_b.low;"
+           "   ELSE"
+           "     high_b := report_severity_count (second_last_report, $2, $3,"
+           "                                      'high');"
+           "     medium_b := report_severity_count (second_last_report, $2,"
+           "                                        $3, 'medium');"
+           "     low_b := report_severity_count (second_last_report, $2, $3,"
+           "                                     'low');"
+           "   END IF;"
            "   IF high_a > 0 THEN"
            "     threat_a := 4;"
            "   ELSIF medium_a > 0 THEN"
@@ -1981,20 +2063,230 @@ manage_create_sql_functions ()
 
 /* Creation. */
 
+/**
+ * @brief Check whether an index exists.
+ *
+ * @param[in]  name  Name of index.
+ *
+ * @return 1 if the index exists, else 0.
+ */
+int
+manage_index_exists (const char *name)
+{
+  return sql_int ("SELECT count (*) FROM pg_indexes"
+                  " WHERE schemaname = 'public'"
+                  " AND indexname = lower ('%s');",
+                  name)
+         > 0;
+}
+
+/**
+ * @brief Check whether a column is the leading column of an index.
+ *
+ * @param[in]  table   Table.
+ * @param[in]  column  Column.
+ *
+ * @return 1 if an index starts with the column, 0 if not, -1 if the table
+ *         has no such column.
+ */
+int
+manage_column_indexed (const char *table, const char *column)
+{
+  if (sql_int ("SELECT count (*) FROM information_schema.columns"
+               " WHERE table_schema = 'public'"
+               " AND table_name = '%s'"
+               " AND column_name = '%s';",
+               table,
+               column)
+      == 0)
+    return -1;
+
+  return sql_int ("SELECT count (*)"
+                  " FROM pg_index, pg_class, pg_attribute"
+                  " WHERE pg_class.oid = pg_index.indrelid"
+                  " AND pg_class.relname = '%s'"
+                  " AND pg_attribute.attrelid = pg_class.oid"
+                  " AND pg_attribute.attnum = pg_index.indkey[0]"
+                  " AND pg_attribute.attname = '%s';",
+                  table,
+                  column)
+         > 0;
+}
+
+/**
+ * @brief Check whether indexes on expressions are supported.
+ *
+ * @return 1 if supported, else 0.
+ */
+int
+manage_expression_indexes ()
+{
+  return 1;
+}
+
+/**
+ * @brief Check whether the current transaction is read only.
+ *
+ * @return 1 if read only, else 0.
+ */
+int
+manage_transaction_read_only ()
+{
+  return sql_int ("SELECT (current_setting ('transaction_read_only') = 'on')"
+                  "       ::integer;");
+}
+
+/**
+ * @brief Create an index if it does not exist yet.
+ *
+ * Building an index concurrently leaves the table writable, but cannot
+ * happen inside a transaction.
+ *
+ * @param[in]  name          Name of index.
+ * @param[in]  table         Table.
+ * @param[in]  columns       Indexed columns or expressions.
+ * @param[in]  concurrently  Whether to build the index concurrently.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+manage_create_index (const char *name, const char *table,
+                     const char *columns, int concurrently)
+{
+  gchar *quoted_columns;
+
+  if (concurrently == 0)
+    {
+      quoted_columns = sql_quote (columns);
+      sql ("SELECT create_index ('%s', '%s', '%s');",
+           name, table, quoted_columns);
+      g_free (quoted_columns);
+      return 0;
+    }
+
+  if (manage_index_exists (name))
+    return 0;
+
+  if (sql_error ("CREATE INDEX CONCURRENTLY %s ON %s (%s);",
+                 name, table, columns))
+    {
+      g_warning ("%s: failed to create index %s", __FUNCTION__, name);
+      /* A failed concurrent build leaves an invalid index behind. */
+      sql_error ("DROP INDEX IF EXISTS %s;", name);
+      return -1;
+    }
+  return 0;
+}
+
+/**
+ * @brief Create a list of indexes.
+ *
+ * @param[in]  indexes  Indexes, terminated by an entry with a NULL name.
+ */
+static void
+create_indexes (const db_index_t *indexes)
+{
+  while (indexes->name)
+    {
+      manage_create_index (indexes->name, indexes->table, indexes->columns,
+                           0);
+      indexes++;
+    }
+}
+
+/**
+ * @brief Indexes on the results table.
+ */
+static const db_index_t result_indexes[] =
+  {
+    { "results_by_host_and_qod", "results", "host, qod" },
+    { "results_by_host_inet", "results", "host_inet" },
+    { "results_by_report_host_inet", "results", "report, host_inet" },
+    { "results_by_report", "results", "report" },
+    { "results_by_nvt", "results", "nvt" },
+    { "results_by_task", "results", "task" },
+    { "results_by_date", "results", "date" },
+    { NULL, NULL, NULL }
+  };
+
 /**
  * @brief Create result indexes.
  */
 void
 manage_create_result_indexes ()
 {
-  sql ("SELECT create_index ('results_by_host_and_qod', 'results',"
-       "                     'host, qod');");
-  sql ("SELECT create_index ('results_by_report', 'results', 'report');");
-  sql ("SELECT create_index ('results_by_nvt', 'results', 'nvt');");
-  sql ("SELECT create_index ('results_by_task', 'results', 'task');");
-  sql ("SELECT create_index ('results_by_date', 'results', 'date');");
+  create_indexes (result_indexes);
 }
 
+/**
+ * @brief Indexes created by create_tables, apart from the result indexes.
+ */
+static const db_index_t table_indexes[] =
+  {
+    { "host_details_by_host", "host_details", "host" },
+    { "host_identifiers_by_host", "host_identifiers", "host" },
+    { "host_identifiers_by_value", "host_identifiers", "value" },
+    { "host_max_severities_by_host", "host_max_severities", "host" },
+    { "host_oss_by_host", "host_oss", "host" },
+    { "notes_by_nvt_and_result", "notes", "nvt, result" },
+    { "notes_by_result", "notes", "result" },
+    { "nvt_cves_by_oid", "nvt_cves", "oid" },
+    { "nvt_selectors_by_family_or_nvt", "nvt_selectors",
+      "type, family_or_nvt" },
+    { "nvt_selectors_by_name", "nvt_selectors", "name" },
+    { "nvt_xml_caches_by_oid", "nvt_xml_caches", "oid" },
+    { "nvts_by_creation_time", "nvts", "creation_time" },
+    { "nvts_by_cvss_base", "nvts", "cvss_base" },
+    { "nvts_by_family", "nvts", "family" },
+    { "nvts_by_modification_time", "nvts", "modification_time" },
+    { "nvts_by_name", "nvts", "name" },
+    { "nvts_by_solution_type", "nvts", "solution_type" },
+    { "overrides_by_nvt_and_result", "overrides", "nvt, result" },
+    { "overrides_by_result", "overrides", "result" },
+    { "permissions_by_name", "permissions", "name" },
+    { "permissions_by_resource", "permissions", "resource" },
+    { "port_list_intervals_by_port_list", "port_list_intervals",
+      "port_list, type, start" },
+    { "port_list_intervals_trash_by_port_list", "port_list_intervals_trash",
+      "port_list" },
+    { "report_counts_by_report_and_override", "report_counts",
+      "report, override" },
+    { "report_counts_refresh_by_report", "report_counts_refresh",
+      "report, \"user\"" },
+    { "report_host_detail_rows_by_report_host_and_name",
+      "report_host_detail_rows",
+      "report_host, name" },
+    { "report_host_detail_rows_by_value_id", "report_host_detail_rows",
+      "value_id" },
+    { "report_host_detail_values_by_hash", "report_host_detail_values",
+      "hash" },
+    { "report_hosts_by_report_and_host", "report_hosts", "report, host" },
+    { "report_hosts_by_report_and_host_inet", "report_hosts",
+      "report, host_inet" },
+    { "reports_by_task", "reports", "task" },
+    { "result_nvt_reports_by_report", "result_nvt_reports", "report" },
+    { "secinfo_changes_by_type_and_uuid", "secinfo_changes", "type, uuid" },
+    { "secinfo_index_by_created", "secinfo_index", "created" },
+    { "secinfo_index_by_modified", "secinfo_index", "modified" },
+    { "secinfo_index_by_name", "secinfo_index", "name" },
+    { "secinfo_index_by_severity", "secinfo_index", "severity" },
+    { "secinfo_index_by_type_and_uuid", "secinfo_index", "type, uuid" },
+    { "slow_filter_queries_by_table_and_shape", "slow_filter_queries",
+      "table_name, shape" },
+    { "tag_resources_by_resource", "tag_resources",
+      "resource_type, resource, resource_location" },
+    { "tag_resources_by_resource_uuid", "tag_resources",
+      "resource_type, resource_uuid" },
+    { "tag_resources_by_tag", "tag_resources", "tag" },
+    { "tag_resources_trash_by_tag", "tag_resources_trash", "tag" },
+    { "task_report_summaries_by_report", "task_report_summaries",
+      "report, \"user\", override, min_qod" },
+    { "task_report_summaries_by_task", "task_report_summaries", "task" },
+    { "ticket_results_by_result", "ticket_results",
+      "result, result_location" },
+    { NULL, NULL, NULL }
+  };
+
 /**
  * @brief Results WHERE SQL for creating views in create_tabes.
  */
@@ -2022,6 +2314,25 @@ create_tables ()
        "  name text UNIQUE NOT NULL,"
        "  value text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS secinfo_changes"
+       " (id SERIAL PRIMARY KEY,"
+       "  type text,"
+       "  uuid text,"
+       "  change integer,"
+       "  item_time integer,"
+       "  sync integer);");
+
+  sql ("CREATE TABLE IF NOT EXISTS secinfo_index"
+       " (id SERIAL PRIMARY KEY,"
+       "  type text,"
+       "  uuid text,"
+       "  name text,"
+       "  comment text,"
+       "  created integer,"
+       "  modified integer,"
+       "  extra text,"
+       "  severity double precision);");
+
   sql ("CREATE TABLE IF NOT EXISTS users"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -2369,6 +2680,21 @@ create_tables ()
        "  comment text,"
        "  exclude integer);");
 
+  sql ("CREATE TABLE IF NOT EXISTS port_list_intervals"
+       " (id SERIAL PRIMARY KEY,"
+       "  port_list integer REFERENCES port_lists (id) ON DELETE RESTRICT,"
+       "  type integer,"
+       "  start integer,"
+       "  \"end\" integer);");
+
+  sql ("CREATE TABLE IF NOT EXISTS port_list_intervals_trash"
+       " (id SERIAL PRIMARY KEY,"
+       "  port_list integer REFERENCES port_lists_trash (id)"
+       "            ON DELETE RESTRICT,"
+       "  type integer,"
+       "  start integer,"
+       "  \"end\" integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS port_names"
        " (id SERIAL PRIMARY KEY,"
        "  number integer,"
@@ -2555,6 +2881,15 @@ create_tables ()
        "  default_value text,"
        "  hr_name text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS config_otp_caches"
+       " (id SERIAL PRIMARY KEY,"
+       "  config integer REFERENCES configs (id) ON DELETE RESTRICT,"
+       "  modification_time integer,"
+       "  feed_version text,"
+       "  plugins text,"
+       "  server_prefs text,"
+       "  plugins_prefs text);");
+
   sql ("CREATE TABLE IF NOT EXISTS schedules"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -2672,7 +3007,27 @@ create_tables ()
        "  slave_host text,"
        "  slave_port integer,"
        "  source_iface text,"
-       "  flags integer);");
+       "  flags integer,"
+       "  progress_sum integer,"
+       "  progress_dead integer,"
+       "  progress_max_hosts integer,"
+       "  port_count integer);");
+
+  sql ("CREATE TABLE IF NOT EXISTS task_report_summaries"
+       " (id SERIAL PRIMARY KEY,"
+       "  task integer REFERENCES tasks (id) ON DELETE RESTRICT,"
+       "  report integer REFERENCES reports (id) ON DELETE RESTRICT,"
+       "  \"user\" integer REFERENCES users (id) ON DELETE RESTRICT,"
+       "  override integer,"
+       "  min_qod integer,"
+       "  date integer,"
+       "  high integer,"
+       "  medium integer,"
+       "  low integer,"
+       "  log integer,"
+       "  false_positive integer,"
+       "  severity double precision,"
+       "  end_time integer);");
 
   sql ("CREATE TABLE IF NOT EXISTS report_counts"
        " (id SERIAL PRIMARY KEY,"
@@ -2684,6 +3039,11 @@ create_tables ()
        "  end_time integer,"
        "  min_qod integer);");
 
+  sql ("CREATE TABLE IF NOT EXISTS report_counts_refresh"
+       " (id SERIAL PRIMARY KEY,"
+       "  report integer,"
+       "  \"user\" integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS resources_predefined"
        " (id SERIAL PRIMARY KEY,"
        "  resource_type text,"
@@ -2706,7 +3066,8 @@ create_tables ()
        "  qod_type text,"
        "  owner integer REFERENCES users (id) ON DELETE RESTRICT,"
        "  date integer,"
-       "  hostname text);");
+       "  hostname text,"
+       "  host_inet inet);");
 
   sql ("CREATE TABLE IF NOT EXISTS results_trash"
        " (id SERIAL PRIMARY KEY,"
@@ -2816,16 +3177,41 @@ create_tables ()
        "  start_time integer,"
        "  end_time integer,"
        "  current_port integer,"
-       "  max_port integer);");
+       "  max_port integer,"
+       "  host_inet inet);");
+
+  /* Host detail values are stored once per distinct value, and referenced
+   * by the detail rows.  The report_host_details view joins them again for
+   * readers. */
 
-  sql ("CREATE TABLE IF NOT EXISTS report_host_details"
+  sql ("CREATE TABLE IF NOT EXISTS report_host_detail_values"
+       " (id SERIAL PRIMARY KEY,"
+       "  hash text,"
+       "  value text);");
+
+  sql ("CREATE TABLE IF NOT EXISTS report_host_detail_rows"
        " (id SERIAL PRIMARY KEY,"
        "  report_host integer REFERENCES report_hosts (id) ON DELETE RESTRICT,"
        "  source_type text,"
        "  source_name text,"
        "  source_description text,"
        "  name text,"
-       "  value text);");
+       "  value_id integer);"); // REFERENCES report_host_detail_values (id)
+
+  /* Values that may have lost their last detail row.  The sweep in
+   * manage_sync removes the ones that are still unused. */
+
+  sql ("CREATE TABLE IF NOT EXISTS report_host_detail_values_sweep"
+       " (id SERIAL PRIMARY KEY,"
+       "  value_id integer);");
+
+  sql ("CREATE OR REPLACE VIEW report_host_details AS"
+       " SELECT report_host_detail_rows.id AS id, report_host, source_type,"
+       "        source_name, source_description, name,"
+       "        report_host_detail_values.value AS value"
+       " FROM report_host_detail_rows"
+       " JOIN report_host_detail_values"
+       " ON report_host_detail_values.id = report_host_detail_rows.value_id;");
 
   sql ("CREATE TABLE IF NOT EXISTS nvt_preferences"
        " (id SERIAL PRIMARY KEY,"
@@ -2849,7 +3235,9 @@ create_tables ()
        "  modification_time integer,"
        "  solution_type text,"
        "  qod integer,"
-       "  qod_type text);");
+       "  qod_type text,"
+       "  has_cert_bunds integer DEFAULT 0,"
+       "  has_dfn_certs integer DEFAULT 0);");
 
   sql ("CREATE TABLE IF NOT EXISTS nvt_cves"
        " (id SERIAL PRIMARY KEY,"
@@ -2857,6 +3245,14 @@ create_tables ()
        "  oid text,"
        "  cve_name text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS nvt_xml_caches"
+       " (id SERIAL PRIMARY KEY,"
+       "  oid text,"
+       "  modification_time integer,"
+       "  xml text,"
+       "  default_timeout text,"
+       "  cert_loaded integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS notes"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -2961,6 +3357,22 @@ create_tables ()
        "  comment text,"
        "  value text);");
 
+  sql ("CREATE TABLE IF NOT EXISTS slow_filter_queries"
+       " (id SERIAL PRIMARY KEY,"
+       "  table_name text,"
+       "  shape text,"
+       "  duration integer,"
+       "  time integer);");
+
+  sql ("CREATE TABLE IF NOT EXISTS advised_indexes"
+       " (id SERIAL PRIMARY KEY,"
+       "  name text UNIQUE NOT NULL,"
+       "  table_name text,"
+       "  shape text,"
+       "  creation_time integer,"
+       "  slow_count integer,"
+       "  slow_duration integer);");
+
   sql ("CREATE TABLE IF NOT EXISTS tags"
        " (id SERIAL PRIMARY KEY,"
        "  uuid text UNIQUE NOT NULL,"
@@ -3171,88 +3583,8 @@ create_tables ()
 
   /* Create indexes. */
 
-  sql ("SELECT create_index ('host_details_by_host',"
-       "                     'host_details', 'host');");
-
-  sql ("SELECT create_index ('host_identifiers_by_host',"
-       "                     'host_identifiers', 'host');");
-  sql ("SELECT create_index ('host_identifiers_by_value',"
-       "                     'host_identifiers', 'value');");
-
-  sql ("SELECT create_index ('host_max_severities_by_host',"
-       "                     'host_max_severities', 'host');");
-  sql ("SELECT create_index ('host_oss_by_host',"
-       "                     'host_oss', 'host');");
-
-  sql ("SELECT create_index ('nvt_cves_by_oid', 'nvt_cves', 'oid');");
-  sql ("SELECT create_index ('nvt_selectors_by_family_or_nvt',"
-       "                     'nvt_selectors',"
-       "                     'type, family_or_nvt');");
-  sql ("SELECT create_index ('nvt_selectors_by_name',"
-       "                     'nvt_selectors',"
-       "                     'name');");
-  sql ("SELECT create_index ('nvts_by_creation_time',"
-       "                     'nvts',"
-       "                     'creation_time');");
-  sql ("SELECT create_index ('nvts_by_family', 'nvts', 'family');");
-  sql ("SELECT create_index ('nvts_by_name', 'nvts', 'name');");
-  sql ("SELECT create_index ('nvts_by_modification_time',"
-       "                     'nvts', 'modification_time');");
-  sql ("SELECT create_index ('nvts_by_cvss_base',"
-       "                     'nvts', 'cvss_base');");
-  sql ("SELECT create_index ('nvts_by_solution_type',"
-       "                     'nvts', 'solution_type');");
-
-  sql ("SELECT create_index ('permissions_by_name',"
-       "                     'permissions', 'name');");
-  sql ("SELECT create_index ('permissions_by_resource',"
-       "                     'permissions', 'resource');");
-
-  sql ("SELECT create_index ('report_counts_by_report_and_override',"
-       "                     'report_counts', 'report, override');");
-
-  sql ("SELECT create_index ('reports_by_task',"
-       "                     'reports', 'task');");
-
-  sql ("SELECT create_index ('tag_resources_by_resource',"
-       "                     'tag_resources',"
-       "                     'resource_type, resource, resource_location');");
-  sql ("SELECT create_index ('tag_resources_by_resource_uuid',"
-       "                     'tag_resources',"
-       "                     'resource_type, resource_uuid');");
-  sql ("SELECT create_index ('tag_resources_by_tag',"
-       "                     'tag_resources', 'tag');");
-
-  sql ("SELECT create_index ('tag_resources_trash_by_tag',"
-       "                     'tag_resources_trash', 'tag');");
-
-
-#if 0
-  /* TODO The value column can be bigger than 8191, the maximum size that
-   *      Postgres can handle.  For example, this can happen for "ports".
-   *      Mostly value is short, like a CPE for the "App" detail, which is
-   *      what the index is for. */
-  sql ("SELECT create_index"
-       "        ('report_host_details_by_report_host_and_name_and_value',"
-       "         'report_host_details',"
-       "         'report_host, name, value');");
-#else
-  sql ("SELECT create_index"
-       "        ('report_host_details_by_report_host_and_name',"
-       "         'report_host_details',"
-       "         'report_host, name');");
-#endif
-  sql ("SELECT create_index"
-       "        ('report_hosts_by_report_and_host',"
-       "         'report_hosts',"
-       "         'report, host');");
-
+  create_indexes (table_indexes);
   manage_create_result_indexes ();
-
-  sql ("SELECT create_index"
-       "        ('result_nvt_reports_by_report',"
-       "         'result_nvt_reports',"
-       "         'report');");
 }
 
 /**
@@ -3521,6 +3853,16 @@ manage_db_init (const gchar *name)
       sql ("CREATE INDEX afp_cve_idx"
            " ON affected_products (cve);");
 
+      sql ("CREATE TABLE scap.cpe_cves"
+           " (id SERIAL PRIMARY KEY,"
+           "  cpe INTEGER,"
+           "  cpe_name text,"
+           "  cve INTEGER,"
+           "  cve_name text,"
+           "  cvss FLOAT DEFAULT 0);");
+      sql ("CREATE INDEX cpe_cves_by_cpe_name"
+           " ON cpe_cves (cpe_name, cvss);");
+
       sql ("CREATE TABLE scap.ovaldefs"
            " (id SERIAL PRIMARY KEY,"
            "  uuid text UNIQUE,"
@@ -3610,7 +3952,7 @@ manage_db_init (const gchar *name)
       /* Init tables. */
 
       sql ("INSERT INTO scap.meta (name, value)"
-           " VALUES ('database_version', '15');");
+           " VALUES ('database_version', '16');");
       sql ("INSERT INTO scap.meta (name, value)"
            " VALUES ('last_update', '0');");
     }
@@ -3682,9 +4024,357 @@ manage_scap_loaded ()
 
 /* Backup. */
 
+/**
+ * @brief Amount of backup data to compress and write at a time, in bytes.
+ */
+#define BACKUP_CHUNK_SIZE 1048576
+
+/**
+ * @brief Pause after writing each chunk of backup data, in microseconds.
+ *
+ * This throttles the backup, so that the scanner and GMP clients keep most
+ * of the I/O.
+ */
+#define BACKUP_CHUNK_PAUSE 20000
+
+/**
+ * @brief Postgres backup file state.
+ */
+typedef struct
+{
+  FILE *file;           ///< Backup file.
+  GString *buffer;      ///< Data waiting to be compressed.
+  long long written;    ///< Compressed bytes written so far.
+} backup_t;
+
+/**
+ * @brief Compress and write buffered backup data.
+ *
+ * Each chunk is written as a separate gzip member, which gunzip reads as
+ * one stream.
+ *
+ * @param[in]  backup  Backup.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+backup_flush (backup_t *backup)
+{
+  void *compressed;
+  unsigned long compressed_len;
+
+  if (backup->buffer->len == 0)
+    return 0;
+
+  compressed = gvm_compress_gzipheader (backup->buffer->str,
+                                        backup->buffer->len,
+                                        &compressed_len);
+  if (compressed == NULL)
+    {
+      g_warning ("%s: failed to compress backup data", __FUNCTION__);
+      return -1;
+    }
+
+  if (fwrite (compressed, 1, compressed_len, backup->file) != compressed_len)
+    {
+      g_warning ("%s: failed to write backup: %s",
+                 __FUNCTION__,
+                 strerror (errno));
+      g_free (compressed);
+      return -1;
+    }
+  g_free (compressed);
+
+  backup->written += compressed_len;
+  g_string_truncate (backup->buffer, 0);
+  g_usleep (BACKUP_CHUNK_PAUSE);
+  return 0;
+}
+
+/**
+ * @brief Add data to a backup.
+ *
+ * @param[in]  data    Data.
+ * @param[in]  len     Length of data.
+ * @param[in]  backup  Backup.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+backup_append (const char *data, int len, void *backup)
+{
+  g_string_append_len (((backup_t *) backup)->buffer, data, len);
+  if (((backup_t *) backup)->buffer->len >= BACKUP_CHUNK_SIZE)
+    return backup_flush (backup);
+  return 0;
+}
+
+/**
+ * @brief Add formatted text to a backup.
+ *
+ * @param[in]  backup  Backup.
+ * @param[in]  format  Format string.
+ * @param[in]  ...     Arguments for format string.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+backup_printf (backup_t *backup, const char *format, ...)
+{
+  va_list args;
+  gchar *text;
+  int ret;
+
+  va_start (args, format);
+  text = g_strdup_vprintf (format, args);
+  va_end (args);
+
+  ret = backup_append (text, strlen (text), backup);
+  g_free (text);
+  return ret;
+}
+
+/**
+ * @brief Get the gvmd tables in the order in which they can be restored.
+ *
+ * Every table comes after the tables that its foreign keys refer to.  This
+ * way the restore does not have to disable the foreign key triggers, which
+ * would need superuser rights.
+ *
+ * @return NULL terminated array of quoted table names, or NULL if the
+ *         foreign keys form a cycle.
+ */
+static gchar **
+backup_table_names ()
+{
+  iterator_t rows;
+  GPtrArray *pending, *ordered, *references;
+  GHashTable *placed;
+
+  pending = g_ptr_array_new ();
+  init_iterator (&rows,
+                 "SELECT quote_ident (tablename) FROM pg_tables"
+                 " WHERE schemaname = 'public'"
+                 " ORDER BY tablename;");
+  while (next (&rows))
+    g_ptr_array_add (pending, g_strdup (iterator_string (&rows, 0)));
+  cleanup_iterator (&rows);
+
+  /* Pairs of referencing table and referenced table. */
+  references = g_ptr_array_new_with_free_func (g_free);
+  init_iterator (&rows,
+                 "SELECT quote_ident (referencing.relname),"
+                 "       quote_ident (referenced.relname)"
+                 " FROM pg_constraint"
+                 " JOIN pg_class AS referencing"
+                 "   ON referencing.oid = pg_constraint.conrelid"
+                 " JOIN pg_class AS referenced"
+                 "   ON referenced.oid = pg_constraint.confrelid"
+                 " JOIN pg_namespace"
+                 "   ON pg_namespace.oid = referencing.relnamespace"
+                 " WHERE contype = 'f'"
+                 " AND nspname = 'public'"
+                 " AND conrelid != confrelid;");
+  while (next (&rows))
+    {
+      g_ptr_array_add (references, g_strdup (iterator_string (&rows, 0)));
+      g_ptr_array_add (references, g_strdup (iterator_string (&rows, 1)));
+    }
+  cleanup_iterator (&rows);
+
+  ordered = g_ptr_array_new ();
+  placed = g_hash_table_new (g_str_hash, g_str_equal);
+  while (pending->len)
+    {
+      guint index, placed_count;
+
+      placed_count = 0;
+      index = 0;
+      while (index < pending->len)
+        {
+          const gchar *table;
+          guint reference;
+
+          table = g_ptr_array_index (pending, index);
+          for (reference = 0; reference < references->len; reference += 2)
+            if (strcmp (g_ptr_array_index (references, reference), table)
+                == 0
+                && g_hash_table_contains (placed,
+                                          g_ptr_array_index (references,
+                                                             reference + 1))
+                   == FALSE)
+              break;
+
+          if (reference < references->len)
+            {
+              index++;
+              continue;
+            }
+
+          /* Every table the table refers to has been placed. */
+          g_hash_table_add (placed, (gpointer) table);
+          g_ptr_array_add (ordered, g_ptr_array_remove_index (pending, index));
+          placed_count++;
+        }
+
+      if (placed_count == 0)
+        {
+          g_warning ("%s: foreign keys of table %s form a cycle",
+                     __FUNCTION__,
+                     (gchar *) g_ptr_array_index (pending, 0));
+          g_hash_table_destroy (placed);
+          g_ptr_array_free (references, TRUE);
+          g_ptr_array_set_free_func (pending, g_free);
+          g_ptr_array_free (pending, TRUE);
+          g_ptr_array_set_free_func (ordered, g_free);
+          g_ptr_array_free (ordered, TRUE);
+          return NULL;
+        }
+    }
+
+  g_hash_table_destroy (placed);
+  g_ptr_array_free (references, TRUE);
+  g_ptr_array_free (pending, TRUE);
+  g_ptr_array_add (ordered, NULL);
+  return (gchar **) g_ptr_array_free (ordered, FALSE);
+}
+
+/**
+ * @brief Write the gvmd tables to a backup, from a consistent snapshot.
+ *
+ * The backup is a gzipped SQL script for psql, like a data only pg_dump.
+ * The restore checks the database version first, and checks the row count
+ * of every table at the end, rolling back if any differ.  The tables are
+ * loaded in foreign key order, so the database owner can restore the
+ * backup without superuser rights.
+ *
+ * Caller must be in a REPEATABLE READ transaction.
+ *
+ * @param[in]  backup  Backup.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+backup_tables (backup_t *backup)
+{
+  iterator_t tables;
+  GArray *counts;
+  gchar **names, *all_names;
+  int count, index, ret;
+
+  names = backup_table_names ();
+  if (names == NULL)
+    return -1;
+  count = g_strv_length (names);
+
+  ret = -1;
+  counts = g_array_new (FALSE, FALSE, sizeof (long long int));
+  all_names = g_strjoinv (", ", names);
+
+  if (backup_printf (backup,
+                     "-- gvmd database backup.\n"
+                     "--\n"
+                     "-- Restore into a database of the same version with:\n"
+                     "--   gunzip -c FILE | psql -v ON_ERROR_STOP=1 DATABASE\n"
+                     "\n"
+                     "BEGIN;\n"
+                     "DO $$ BEGIN\n"
+                     "  IF (SELECT value FROM meta"
+                     " WHERE name = 'database_version') != '%i' THEN\n"
+                     "    RAISE EXCEPTION 'Database must be version %i';\n"
+                     "  END IF;\n"
+                     "END $$;\n"
+                     "TRUNCATE %s;\n",
+                     manage_db_version (),
+                     manage_db_version (),
+                     all_names))
+    goto fail;
+
+  for (index = 0; index < count; index++)
+    {
+      gchar *copy;
+      long long int rows;
+
+      if (backup_printf (backup,
+                         "\nCOPY %s FROM stdin;\n",
+                         names[index]))
+        goto fail;
+
+      copy = g_strdup_printf ("COPY %s TO STDOUT;", names[index]);
+      rows = sql_copy_out (copy, backup_append, backup);
+      g_free (copy);
+      if (rows < 0)
+        goto fail;
+      g_array_append_val (counts, rows);
+
+      if (backup_printf (backup, "\\.\n"))
+        goto fail;
+
+      g_info ("   Backed up table %i of %i: %s (%lli rows, %lli bytes"
+              " written).",
+              index + 1, count, names[index], rows, backup->written);
+    }
+
+  /* Sequences. */
+
+  init_iterator (&tables,
+                 "SELECT quote_ident (sequence_name)"
+                 " FROM information_schema.sequences"
+                 " WHERE sequence_schema = 'public';");
+  while (next (&tables))
+    {
+      const char *sequence;
+
+      sequence = iterator_string (&tables, 0);
+      if (backup_printf (backup,
+                         "SELECT setval ('%s', %lli, %s);\n",
+                         sequence,
+                         sql_int64_0 ("SELECT last_value FROM %s;",
+                                      sequence),
+                         sql_int ("SELECT is_called FROM %s;", sequence)
+                          ? "true"
+                          : "false"))
+        {
+          cleanup_iterator (&tables);
+          goto fail;
+        }
+    }
+  cleanup_iterator (&tables);
+
+  /* Verification of the restore. */
+
+  if (backup_printf (backup, "\nDO $$ BEGIN\n"))
+    goto fail;
+  for (index = 0; index < count; index++)
+    if (backup_printf (backup,
+                       "  IF (SELECT count (*) FROM %s) != %lli THEN\n"
+                       "    RAISE EXCEPTION 'Row count of %s differs';\n"
+                       "  END IF;\n",
+                       names[index],
+                       g_array_index (counts, long long int, index),
+                       names[index]))
+      goto fail;
+  if (backup_printf (backup,
+                     "END $$;\n"
+                     "COMMIT;\n"))
+    goto fail;
+
+  ret = backup_flush (backup);
+
+ fail:
+  g_array_free (counts, TRUE);
+  g_free (all_names);
+  g_strfreev (names);
+  return ret;
+}
+
 /**
  * @brief Backup the database to a file.
  *
+ * The backup runs online, in a read only snapshot, so gvmd can keep
+ * running.  It covers the gvmd tables, not the SecInfo feed data, which is
+ * restored by the feed syncs.
+ *
  * @param[in]  database  Name of manage database.
  *
  * @return 0 success, -1 error.
@@ -3692,8 +4382,64 @@ manage_scap_loaded ()
 int
 manage_backup_db (const gchar *database)
 {
-  g_warning ("%s: database backup not supported for Postgres", __FUNCTION__);
-  return -1;
+  backup_t backup;
+  gchar *backup_file, *part_file;
+  int ret;
+
+  init_manage_process (0, database);
+
+  backup_file = g_strdup_printf ("%s/%s-backup.sql.gz",
+                                 GVMD_STATE_DIR,
+                                 sql_database ());
+  part_file = g_strdup_printf ("%s.part", backup_file);
+
+  backup.file = fopen (part_file, "w");
+  if (backup.file == NULL)
+    {
+      g_warning ("%s: failed to open %s: %s",
+                 __FUNCTION__,
+                 part_file,
+                 strerror (errno));
+      g_free (backup_file);
+      g_free (part_file);
+      cleanup_manage_process (TRUE);
+      return -1;
+    }
+  backup.buffer = g_string_new ("");
+  backup.written = 0;
+
+  sql ("BEGIN ISOLATION LEVEL REPEATABLE READ READ ONLY;");
+  ret = backup_tables (&backup);
+  sql_rollback ();
+
+  g_string_free (backup.buffer, TRUE);
+  if (fclose (backup.file))
+    {
+      g_warning ("%s: failed to close %s: %s",
+                 __FUNCTION__,
+                 part_file,
+                 strerror (errno));
+      ret = -1;
+    }
+
+  if (ret == 0 && rename (part_file, backup_file))
+    {
+      g_warning ("%s: failed to rename %s: %s",
+                 __FUNCTION__,
+                 part_file,
+                 strerror (errno));
+      ret = -1;
+    }
+
+  if (ret)
+    unlink (part_file);
+  else
+    g_info ("   Backup written to %s.", backup_file);
+
+  g_free (backup_file);
+  g_free (part_file);
+  cleanup_manage_process (TRUE);
+  return ret;
 }
 
 
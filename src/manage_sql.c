@@ -49,10 +49,13 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <glib/gstdio.h>
 #include <locale.h>
 #include <pwd.h>
+#include <signal.h>
 #include <stdlib.h>
+#include <sys/file.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -224,15 +227,33 @@ nvt_selector_add (const char*, const char*, const char*, int);
 static void
 nvt_selector_remove_selector (const char*, const char*, int);
 
+static void
+nvt_selector_add_family_nvts (const char*, const char*, int);
+
+static void
+nvt_selector_add_nvts (const char*, GPtrArray *, const char*, int);
+
+static void
+nvt_selector_remove_nvts (const char*, GPtrArray *, int);
+
 static void
 update_config_caches (config_t);
 
+static void
+config_otp_cache_clear (config_t);
+
+static void
+port_lists_compile_missing ();
+
 int
 family_count ();
 
 static int
 report_counts_cache_exists (report_t, int, int);
 
+static int
+report_active (report_t);
+
 static void report_severity_data (report_t, const char *, const get_data_t *,
                                   severity_data_t*, severity_data_t*);
 
@@ -357,6 +378,19 @@ cleanup_schedule_times ();
 static int
 nvt_selector_families_growing (const char *);
 
+static void
+report_cache_progress (report_t);
+
+static long
+report_max_hosts (report_t, task_t);
+
+static int
+report_summary (report_t, int, int, int *, int *, int *, int *, int *,
+                double *);
+
+static void
+report_clear_summaries (report_t, int, int, const char *);
+
 static int
 nvt_selector_nvts_growing_2 (const char*, int);
 
@@ -3213,6 +3247,94 @@ filter_clause_append_tag_id (GString *clause, keyword_t *keyword,
   g_free (quoted_keyword);
 }
 
+/**
+ * @brief Get SQL to check that a host_inet column is in a CIDR network.
+ *
+ * @param[in]  column  Column.
+ * @param[in]  range   Network, like 10.0.0.0/8.
+ *
+ * @return Freshly allocated SQL condition, or NULL if range is not a network.
+ */
+static gchar *
+host_inet_range_clause (const char *column, const char *range)
+{
+  unsigned char low[16], high[16];
+  GString *condition;
+  int index;
+
+  if (strchr (range, '/') == NULL
+      || host_inet_range (range, low, high))
+    return NULL;
+
+  if (sql_is_sqlite3 () == 0)
+    {
+      gchar *quoted_range, *ret;
+
+      /* Postgres uses a btree index for <<= on inet. */
+      quoted_range = sql_quote (range);
+      ret = g_strdup_printf ("%s <<= '%s'::inet", column, quoted_range);
+      g_free (quoted_range);
+      return ret;
+    }
+
+  condition = g_string_new ("");
+  g_string_append_printf (condition, "%s BETWEEN X'", column);
+  for (index = 0; index < 16; index++)
+    g_string_append_printf (condition, "%02x", low[index]);
+  g_string_append (condition, "' AND X'");
+  for (index = 0; index < 16; index++)
+    g_string_append_printf (condition, "%02x", high[index]);
+  g_string_append (condition, "'");
+  return g_string_free (condition, FALSE);
+}
+
+/**
+ * @brief Get SQL to check that a result port is in a port list.
+ *
+ * Looks the port up in the compiled intervals of the port list, which are
+ * indexed by port list, protocol and start.
+ *
+ * @param[in]  port_list_id  UUID of port list.
+ *
+ * @return Freshly allocated SQL condition.
+ */
+static gchar *
+result_port_list_clause (const char *port_list_id)
+{
+  gchar *quoted_port_list_id, *number, *ret;
+
+  /* Result ports look like 80/tcp or general/tcp. */
+  if (sql_is_sqlite3 ())
+    number = g_strdup ("CAST (results.port AS INTEGER)");
+  else
+    number = g_strdup ("CAST (substring (results.port from '^([0-9]+)/')"
+                       "      AS INTEGER)");
+
+  quoted_port_list_id = sql_quote (port_list_id);
+  ret = g_strdup_printf ("EXISTS (SELECT * FROM port_list_intervals"
+                         "        WHERE port_list"
+                         "              = (SELECT id FROM port_lists"
+                         "                 WHERE uuid = '%s')"
+                         "        AND type = (CASE"
+                         "                    WHEN %s (results.port, '/tcp') > 0"
+                         "                    THEN %i"
+                         "                    WHEN %s (results.port, '/udp') > 0"
+                         "                    THEN %i"
+                         "                    ELSE NULL END)"
+                         "        AND start <= %s"
+                         "        AND \"end\" >= %s)",
+                         quoted_port_list_id,
+                         sql_is_sqlite3 () ? "instr" : "strpos",
+                         PORT_PROTOCOL_TCP,
+                         sql_is_sqlite3 () ? "instr" : "strpos",
+                         PORT_PROTOCOL_UDP,
+                         number,
+                         number);
+  g_free (quoted_port_list_id);
+  g_free (number);
+  return ret;
+}
+
 /**
  * @brief Return SQL WHERE clause for restricting a SELECT to a filter term.
  *
@@ -3270,7 +3392,7 @@ filter_clause (const char* type, const char* filter,
   first_order = 1;
   while (*point)
     {
-      gchar *quoted_keyword;
+      gchar *quoted_keyword, *range_clause;
       int index;
       keyword_t *keyword;
 
@@ -3461,6 +3583,22 @@ filter_clause (const char* type, const char* filter,
                                           " ORDER BY CAST (%s AS INTEGER) ASC",
                                           column);
                 }
+              else if (trash == 0
+                       && strcmp (type, "result") == 0
+                       && strcmp (keyword->string, "host") == 0)
+                {
+                  /* Postgres puts NULLs (host names) after addresses
+                   * already, so it can scan the host_inet index. */
+                  if (sql_is_sqlite3 ())
+                    g_string_append (order,
+                                     " ORDER BY results.host_inet IS NULL ASC,"
+                                     " results.host_inet ASC,"
+                                     " lower (results.host) ASC");
+                  else
+                    g_string_append (order,
+                                     " ORDER BY results.host_inet ASC,"
+                                     " lower (results.host) ASC");
+                }
               else if (strcmp (keyword->string, "ip") == 0)
                 {
                   gchar *column;
@@ -3638,6 +3776,22 @@ filter_clause (const char* type, const char* filter,
                                           " ORDER BY CAST (%s AS INTEGER) DESC",
                                           column);
                 }
+              else if (trash == 0
+                       && strcmp (type, "result") == 0
+                       && strcmp (keyword->string, "host") == 0)
+                {
+                  /* Postgres puts NULLs (host names) after addresses
+                   * already, so it can scan the host_inet index. */
+                  if (sql_is_sqlite3 ())
+                    g_string_append (order,
+                                     " ORDER BY results.host_inet IS NULL DESC,"
+                                     " results.host_inet DESC,"
+                                     " lower (results.host) DESC");
+                  else
+                    g_string_append (order,
+                                     " ORDER BY results.host_inet DESC,"
+                                     " lower (results.host) DESC");
+                }
               else if (strcmp (keyword->string, "ip") == 0)
                 {
                   gchar *column;
@@ -3753,7 +3907,11 @@ filter_clause (const char* type, const char* filter,
 
       if (keyword->relation == KEYWORD_RELATION_COLUMN_EQUAL)
         {
-          if (vector_find_filter (filter_columns, keyword->column) == 0)
+          if (vector_find_filter (filter_columns, keyword->column) == 0
+              /* Results also take port_list=<uuid>. */
+              && (trash
+                  || strcmp (type, "result")
+                  || strcasecmp (keyword->column, "port_list")))
             {
               last_was_and = 0;
               last_was_not = 0;
@@ -3816,6 +3974,36 @@ filter_clause (const char* type, const char* filter,
 
               g_free (type_term);
             }
+          else if (trash == 0
+                   && strcmp (type, "result") == 0
+                   && keyword->column
+                   && strcasecmp (keyword->column, "host") == 0
+                   && (range_clause
+                        = host_inet_range_clause ("results.host_inet",
+                                                  keyword->string)))
+            {
+              g_string_append_printf (clause,
+                                      "%s(%s",
+                                      get_join (first_keyword, last_was_and,
+                                                last_was_not),
+                                      range_clause);
+              g_free (range_clause);
+            }
+          else if (trash == 0
+                   && strcmp (type, "result") == 0
+                   && keyword->column
+                   && strcasecmp (keyword->column, "port_list") == 0)
+            {
+              gchar *port_list_clause;
+
+              port_list_clause = result_port_list_clause (keyword->string);
+              g_string_append_printf (clause,
+                                      "%s(%s",
+                                      get_join (first_keyword, last_was_and,
+                                                last_was_not),
+                                      port_list_clause);
+              g_free (port_list_clause);
+            }
           else if (keyword->column && strcmp (keyword->column, "owner"))
             {
               gchar *column;
@@ -5053,6 +5241,11 @@ resource_uuid (const gchar *type, resource_t resource)
  * @param[in]  extra_order     Extra ORDER clauses.
  * @param[in]  extra_with      Extra WITH clauses.
  * @param[in]  assume_permitted   Whether to skip permission checks.
+ * @param[in]  outer_columns   Columns to select from the page of resources,
+ *                             or NULL to return the page itself.  Skipped
+ *                             for trash and single resource.
+ * @param[in]  outer_clauses   Extra clauses after outer_columns, like GROUP BY
+ *                             and ORDER BY.
  *
  * @return 0 success, 1 failed to find resource, 2 failed to find filter, -1
  *         error.
@@ -5069,10 +5262,13 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
                          int ignore_id,
                          const char *extra_order,
                          const char *extra_with,
-                         int assume_permitted)
+                         int assume_permitted,
+                         const char *outer_columns,
+                         const char *outer_clauses)
 {
   int first, max;
   gchar *clause, *order, *filter, *owned_clause, *with_clause;
+  gchar *outer_start, *outer_end;
   array_t *permissions;
   resource_t resource = 0;
   gchar *owner_filter;
@@ -5208,6 +5404,23 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
       order = NULL;
     }
 
+  if (outer_columns)
+    {
+      outer_start = g_strdup_printf ("SELECT %s FROM (", outer_columns);
+      outer_end = g_strdup_printf (") AS subquery_for_outer%s",
+                                   outer_clauses ? outer_clauses : "");
+    }
+  else if (distinct)
+    {
+      outer_start = g_strdup ("SELECT DISTINCT * FROM (");
+      outer_end = g_strdup (") AS subquery_for_distinct");
+    }
+  else
+    {
+      outer_start = NULL;
+      outer_end = NULL;
+    }
+
   if (resource && get->trash)
     init_iterator (iterator,
                    "%sSELECT %s"
@@ -5264,7 +5477,7 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
                    " %s%s%s%s%s%s%s"
                    " LIMIT %s OFFSET %i%s;",
                    with_clause ? with_clause : "",
-                   distinct ? "SELECT DISTINCT * FROM (" : "",
+                   outer_start ? outer_start : "",
                    columns,
                    type,
                    extra_tables ? extra_tables : "",
@@ -5277,8 +5490,10 @@ init_get_iterator2_with (iterator_t* iterator, const char *type,
                    order ? (extra_order ? extra_order : "") : "",
                    sql_select_limit (max),
                    first,
-                   distinct ? ") AS subquery_for_distinct" : "");
+                   outer_end ? outer_end : "");
 
+  g_free (outer_start);
+  g_free (outer_end);
   g_free (columns);
   g_free (with_clause);
   g_free (owned_clause);
@@ -5329,7 +5544,7 @@ init_get_iterator2 (iterator_t* iterator, const char *type,
                                  trash_select_columns, where_columns,
                                  trash_where_columns, filter_columns, distinct,
                                  extra_tables, extra_where, owned, ignore_id,
-                                 extra_order, NULL, 0);
+                                 extra_order, NULL, 0, NULL, NULL);
 }
 
 /**
@@ -5980,6 +6195,228 @@ aggregate_iterator_subgroup_value (iterator_t* iterator)
   return ret;
 }
 
+/**
+ * @brief Milliseconds a filtered count must take to be logged as slow.
+ */
+#define SLOW_FILTER_QUERY_MSECS 500
+
+/**
+ * @brief Log one in this many slow filtered counts.
+ */
+#define SLOW_FILTER_QUERY_SAMPLE 4
+
+/**
+ * @brief Maximum number of indexed expressions in a filter query shape.
+ */
+#define FILTER_SHAPE_MAX_EXPRESSIONS 3
+
+/**
+ * @brief Get the column name if a column expression is a plain column.
+ *
+ * @param[in]  expression  Column expression from a column list.
+ * @param[in]  table       Table the expression may be prefixed with.
+ *
+ * @return Column name within expression if plain, else NULL.
+ */
+static const gchar *
+plain_column (const gchar *expression, const gchar *table)
+{
+  const gchar *column, *point;
+
+  while (*expression == ' ')
+    expression++;
+
+  column = expression;
+  if (table
+      && g_str_has_prefix (expression, table)
+      && expression[strlen (table)] == '.')
+    column = expression + strlen (table) + 1;
+
+  if (*column == '\0')
+    return NULL;
+  for (point = column; *point; point++)
+    if (g_ascii_islower (*point) == FALSE
+        && g_ascii_isdigit (*point) == FALSE
+        && *point != '_')
+      return NULL;
+  return column;
+}
+
+/**
+ * @brief Get the shape of the WHERE clause that a filter generates.
+ *
+ * The shape lists the indexable expressions that filter_clause compares
+ * against keyword values, first the ones used with "=", in a fixed order,
+ * then one used with "<" or ">".  Only plain columns of the table are
+ * included, because those are the only ones an index on the table can cover.
+ *
+ * @param[in]  type            Resource type.
+ * @param[in]  filter          Filter term.
+ * @param[in]  filter_columns  Filter columns.
+ * @param[in]  select_columns  SELECT columns.
+ * @param[in]  where_columns   WHERE columns.
+ * @param[in]  trash           Whether the query is on the trashcan.
+ * @param[out] table_return    Table of the query.  Only set if there is a
+ *                             shape.
+ *
+ * @return Comma separated expressions, or NULL if there are none.
+ */
+static gchar *
+filter_query_shape (const char *type, const char *filter,
+                    const char **filter_columns, column_t *select_columns,
+                    column_t *where_columns, int trash, gchar **table_return)
+{
+  array_t *split;
+  keyword_t **point;
+  GList *equal, *list;
+  gchar *table, *range;
+  GString *shape;
+  int count;
+
+  table = g_strdup_printf ("%ss%s", type,
+                           trash && strcmp (type, "task") ? "_trash" : "");
+  equal = NULL;
+  range = NULL;
+
+  split = split_filter (filter ? filter : "");
+  for (point = (keyword_t**) split->pdata; *point; point++)
+    {
+      keyword_t *keyword;
+      keyword_type_t column_type;
+      const gchar *column;
+      gchar *select, *expression;
+
+      keyword = *point;
+
+      if (keyword->column == NULL
+          || (keyword->relation != KEYWORD_RELATION_COLUMN_EQUAL
+              && keyword->relation != KEYWORD_RELATION_COLUMN_ABOVE
+              && keyword->relation != KEYWORD_RELATION_COLUMN_BELOW)
+          || vector_find_filter (filter_columns, keyword->column) == 0
+          /* These are special cases in filter_clause. */
+          || strcmp (keyword->column, "owner") == 0
+          || g_str_has_suffix (keyword->column, "_id")
+          || (strcmp (type, "result") == 0
+              && (strcasecmp (keyword->column, "host") == 0
+                  || strcasecmp (keyword->column, "port_list") == 0)))
+        continue;
+
+      select = columns_select_column_with_type (select_columns, where_columns,
+                                                keyword->column, &column_type);
+      if (select == NULL)
+        continue;
+      column = plain_column (select, table);
+      if (column == NULL)
+        continue;
+
+      /* Match the expressions that filter_clause generates. */
+      if (keyword->type == KEYWORD_TYPE_INTEGER
+          && (column_type == KEYWORD_TYPE_INTEGER
+              || column_type == KEYWORD_TYPE_DOUBLE))
+        expression = g_strdup_printf ("CAST (%s AS NUMERIC)", column);
+      else if (keyword->type == KEYWORD_TYPE_DOUBLE
+               && (column_type == KEYWORD_TYPE_DOUBLE
+                   || column_type == KEYWORD_TYPE_INTEGER))
+        expression = g_strdup_printf ("CAST (%s AS REAL)", column);
+      else if (keyword->relation == KEYWORD_RELATION_COLUMN_EQUAL
+               && strlen (keyword->string) == 0)
+        /* Compared with IS NULL. */
+        continue;
+      else if (column_type == KEYWORD_TYPE_STRING && sql_is_sqlite3 () == 0)
+        /* Postgres drops the cast on text columns, so a plain index on the
+         * column covers the comparison. */
+        expression = g_strdup (column);
+      else
+        expression = g_strdup_printf ("CAST (%s AS TEXT)", column);
+
+      if (keyword->relation != KEYWORD_RELATION_COLUMN_EQUAL)
+        {
+          if (range == NULL)
+            range = expression;
+          else
+            g_free (expression);
+        }
+      else if (g_list_find_custom (equal, expression, (GCompareFunc) strcmp))
+        g_free (expression);
+      else
+        equal = g_list_insert_sorted (equal, expression,
+                                      (GCompareFunc) strcmp);
+    }
+  filter_free (split);
+
+  shape = g_string_new ("");
+  count = 0;
+  for (list = equal;
+       list && count < FILTER_SHAPE_MAX_EXPRESSIONS;
+       list = list->next, count++)
+    g_string_append_printf (shape, "%s%s",
+                            count ? ", " : "",
+                            (gchar *) list->data);
+  if (range && count < FILTER_SHAPE_MAX_EXPRESSIONS)
+    g_string_append_printf (shape, "%s%s", count++ ? ", " : "", range);
+  g_list_free_full (equal, g_free);
+  g_free (range);
+
+  if (count == 0)
+    {
+      g_string_free (shape, TRUE);
+      g_free (table);
+      return NULL;
+    }
+  *table_return = table;
+  return g_string_free (shape, FALSE);
+}
+
+/**
+ * @brief Log a filtered count if it was slow, for the index advisor.
+ *
+ * @param[in]  type            Resource type.
+ * @param[in]  filter          Filter term.
+ * @param[in]  filter_columns  Filter columns.
+ * @param[in]  select_columns  SELECT columns.
+ * @param[in]  where_columns   WHERE columns.
+ * @param[in]  trash           Whether the query is on the trashcan.
+ * @param[in]  start           Monotonic time when the query started.
+ */
+static void
+log_slow_filter_query (const char *type, const char *filter,
+                       const char **filter_columns, column_t *select_columns,
+                       column_t *where_columns, int trash, gint64 start)
+{
+  gint64 msecs;
+  gchar *table, *shape, *quoted_shape;
+
+  msecs = (g_get_monotonic_time () - start) / 1000;
+  if (msecs < SLOW_FILTER_QUERY_MSECS)
+    return;
+
+  /* Sample, so that a busy instance does not add a row for every count. */
+  if (g_random_int_range (0, SLOW_FILTER_QUERY_SAMPLE))
+    return;
+
+  /* The count may be part of a read only transaction, which must not
+   * fail because of the log. */
+  if (manage_transaction_read_only ())
+    return;
+
+  shape = filter_query_shape (type, filter, filter_columns, select_columns,
+                              where_columns, trash, &table);
+  if (shape == NULL)
+    return;
+
+  quoted_shape = sql_quote (shape);
+  if (sql_error ("INSERT INTO slow_filter_queries"
+                 " (table_name, shape, duration, time)"
+                 " VALUES ('%s', '%s', %i, m_now ());",
+                 table,
+                 quoted_shape,
+                 (int) msecs))
+    g_debug ("%s: failed to log slow filter query", __FUNCTION__);
+  g_free (quoted_shape);
+  g_free (shape);
+  g_free (table);
+}
+
 /**
  * @brief Count number of a particular resource.
  *
@@ -6009,6 +6446,7 @@ count2 (const char *type, const get_data_t *get, column_t *select_columns,
   int ret;
   gchar *clause, *owned_clause, *owner_filter, *columns, *filter, *with;
   array_t *permissions;
+  gint64 start;
 
   assert (get);
 
@@ -6031,8 +6469,6 @@ count2 (const char *type, const get_data_t *get, column_t *select_columns,
                           get->trash, NULL, NULL, NULL, &permissions,
                           &owner_filter);
 
-  g_free (filter);
-
   owned_clause = acl_where_owned (type, get, owned, owner_filter, 0,
                                   permissions, &with);
 
@@ -6044,6 +6480,8 @@ count2 (const char *type, const get_data_t *get, column_t *select_columns,
   else
     columns = columns_build_select (select_columns);
 
+  start = g_get_monotonic_time ();
+
   if ((distinct == 0)
       && (extra_tables == NULL)
       && (clause == NULL)
@@ -6071,6 +6509,18 @@ count2 (const char *type, const get_data_t *get, column_t *select_columns,
                    clause ? ") " : "",
                    extra_where ? extra_where : "");
 
+  if (clause)
+    log_slow_filter_query (type, filter ? filter : get->filter,
+                           filter_columns,
+                           get->trash && trash_select_columns
+                            ? trash_select_columns
+                            : select_columns,
+                           get->trash && trash_where_columns
+                            ? trash_where_columns
+                            : where_columns,
+                           get->trash, start);
+
+  g_free (filter);
   g_free (with);
   g_free (columns);
   g_free (owned_clause);
@@ -6733,69 +7183,101 @@ check_alerts ()
 {
   if (manage_scap_loaded ())
     {
-      int max_time;
-
-      max_time
-       = sql_int ("SELECT %s"
-                  "        ((SELECT max (modification_time) FROM scap.cves),"
-                  "         (SELECT max (modification_time) FROM scap.cpes),"
-                  "         (SELECT max (modification_time) FROM scap.ovaldefs),"
-                  "         (SELECT max (creation_time) FROM scap.cves),"
-                  "         (SELECT max (creation_time) FROM scap.cpes),"
-                  "         (SELECT max (creation_time) FROM scap.ovaldefs));",
-                  sql_greatest ());
-
       if (sql_int ("SELECT NOT EXISTS (SELECT * FROM meta"
-                   "                   WHERE name = 'scap_check_time')"))
-        sql ("INSERT INTO meta (name, value)"
-             " VALUES ('scap_check_time', %i);",
-             max_time);
-      else if (sql_int ("SELECT value = '0' FROM meta"
-                        " WHERE name = 'scap_check_time';"))
-        sql ("UPDATE meta SET value = %i"
-             " WHERE name = 'scap_check_time';",
-             max_time);
+                   "                   WHERE name = 'scap_check_time')"
+                   " OR (SELECT value = '0' FROM meta"
+                   "     WHERE name = 'scap_check_time');"))
+        {
+          int max_time;
+
+          /* First check, so just record the time. */
+
+          max_time
+           = sql_int ("SELECT %s"
+                      "        ((SELECT max (modification_time) FROM scap.cves),"
+                      "         (SELECT max (modification_time) FROM scap.cpes),"
+                      "         (SELECT max (modification_time) FROM scap.ovaldefs),"
+                      "         (SELECT max (creation_time) FROM scap.cves),"
+                      "         (SELECT max (creation_time) FROM scap.cpes),"
+                      "         (SELECT max (creation_time) FROM scap.ovaldefs));",
+                      sql_greatest ());
+
+          if (sql_int ("SELECT NOT EXISTS (SELECT * FROM meta"
+                       "                   WHERE name = 'scap_check_time')"))
+            sql ("INSERT INTO meta (name, value)"
+                 " VALUES ('scap_check_time', %i);",
+                 max_time);
+          else
+            sql ("UPDATE meta SET value = %i"
+                 " WHERE name = 'scap_check_time';",
+                 max_time);
+        }
       else
         {
           check_for_new_scap ();
           check_for_updated_scap ();
-          sql ("UPDATE meta SET value = %i"
+          sql ("UPDATE meta"
+               " SET value = %s (CAST (value AS INTEGER),"
+               "                 coalesce ((SELECT max (item_time)"
+               "                            FROM secinfo_changes"
+               "                            WHERE type IN ('cve', 'cpe',"
+               "                                           'ovaldef')),"
+               "                           0))"
                " WHERE name = 'scap_check_time';",
-               max_time);
+               sql_greatest ());
         }
+
+      sql ("DELETE FROM secinfo_changes"
+           " WHERE type IN ('cve', 'cpe', 'ovaldef');");
     }
 
   if (manage_cert_loaded ())
     {
-      int max_time;
-
-      max_time
-       = sql_int ("SELECT"
-                  " %s"
-                  "  ((SELECT max (modification_time) FROM cert.cert_bund_advs),"
-                  "   (SELECT max (modification_time) FROM cert.dfn_cert_advs),"
-                  "   (SELECT max (creation_time) FROM cert.cert_bund_advs),"
-                  "   (SELECT max (creation_time) FROM cert.dfn_cert_advs));",
-                  sql_greatest ());
-
       if (sql_int ("SELECT NOT EXISTS (SELECT * FROM meta"
-                   "                   WHERE name = 'cert_check_time')"))
-        sql ("INSERT INTO meta (name, value)"
-             " VALUES ('cert_check_time', %i);",
-             max_time);
-      else if (sql_int ("SELECT value = '0' FROM meta"
-                        " WHERE name = 'cert_check_time';"))
-        sql ("UPDATE meta SET value = %i"
-             " WHERE name = 'cert_check_time';",
-             max_time);
+                   "                   WHERE name = 'cert_check_time')"
+                   " OR (SELECT value = '0' FROM meta"
+                   "     WHERE name = 'cert_check_time');"))
+        {
+          int max_time;
+
+          /* First check, so just record the time. */
+
+          max_time
+           = sql_int ("SELECT"
+                      " %s"
+                      "  ((SELECT max (modification_time) FROM cert.cert_bund_advs),"
+                      "   (SELECT max (modification_time) FROM cert.dfn_cert_advs),"
+                      "   (SELECT max (creation_time) FROM cert.cert_bund_advs),"
+                      "   (SELECT max (creation_time) FROM cert.dfn_cert_advs));",
+                      sql_greatest ());
+
+          if (sql_int ("SELECT NOT EXISTS (SELECT * FROM meta"
+                       "                   WHERE name = 'cert_check_time')"))
+            sql ("INSERT INTO meta (name, value)"
+                 " VALUES ('cert_check_time', %i);",
+                 max_time);
+          else
+            sql ("UPDATE meta SET value = %i"
+                 " WHERE name = 'cert_check_time';",
+                 max_time);
+        }
       else
         {
           check_for_new_cert ();
           check_for_updated_cert ();
-          sql ("UPDATE meta SET value = %i"
+          sql ("UPDATE meta"
+               " SET value = %s (CAST (value AS INTEGER),"
+               "                 coalesce ((SELECT max (item_time)"
+               "                            FROM secinfo_changes"
+               "                            WHERE type IN ('cert_bund_adv',"
+               "                                           'dfn_cert_adv')),"
+               "                           0))"
                " WHERE name = 'cert_check_time';",
-               max_time);
+               sql_greatest ());
         }
+
+      sql ("DELETE FROM secinfo_changes"
+           " WHERE type IN ('cert_bund_adv', 'dfn_cert_adv');");
     }
 }
 
@@ -14491,7 +14973,33 @@ condition_met (task_t task, report_t report, alert_t alert,
 }
 
 /**
- * @brief Produce an event.
+ * @brief Check the tickets of a task, producing events for changed tickets.
+ *
+ * @param[in]  task  Task.
+ */
+static void
+check_task_tickets (task_t task)
+{
+  GArray *verified;
+  guint index;
+
+  verified = check_tickets (task);
+  if (verified == NULL)
+    return;
+
+  for (index = 0; index < verified->len; index++)
+    {
+      ticket_t ticket;
+
+      ticket = g_array_index (verified, ticket_t, index);
+      event (EVENT_OWNED_TICKET_CHANGED, NULL, ticket, 0);
+      event (EVENT_ASSIGNED_TICKET_CHANGED, NULL, ticket, 0);
+    }
+  g_array_free (verified, TRUE);
+}
+
+/**
+ * @brief Run the alerts that apply to an event.
  *
  * @param[in]  event       Event.
  * @param[in]  event_data  Event type specific details.
@@ -14499,22 +15007,16 @@ condition_met (task_t task, report_t report, alert_t alert,
  *                         a task for EVENT_TASK_RUN_STATUS_CHANGED.
  * @param[in]  resource_2  Event type specific resource 2.
  */
-void
-event (event_t event, void* event_data, resource_t resource_1,
-       resource_t resource_2)
+static void
+event_alerts (event_t event, void* event_data, resource_t resource_1,
+              resource_t resource_2)
 {
   iterator_t alerts;
   GArray *alerts_triggered;
   guint index;
 
-  g_debug ("   EVENT %i on resource %llu", event, resource_1);
-
   alerts_triggered = g_array_new (TRUE, TRUE, sizeof (alert_t));
 
-  if ((event == EVENT_TASK_RUN_STATUS_CHANGED)
-      && (((task_status_t) event_data) == TASK_STATUS_DONE))
-    check_tickets (resource_1);
-
   init_event_alert_iterator (&alerts, event);
   while (next (&alerts))
     {
@@ -14555,6 +15057,257 @@ event (event_t event, void* event_data, resource_t resource_1,
   g_array_free (alerts_triggered, TRUE);
 }
 
+/**
+ * @brief Produce an event.
+ *
+ * @param[in]  event       Event.
+ * @param[in]  event_data  Event type specific details.
+ * @param[in]  resource_1  Event type specific resource 1.  For example,
+ *                         a task for EVENT_TASK_RUN_STATUS_CHANGED.
+ * @param[in]  resource_2  Event type specific resource 2.
+ */
+void
+event (event_t event, void* event_data, resource_t resource_1,
+       resource_t resource_2)
+{
+  g_debug ("   EVENT %i on resource %llu", event, resource_1);
+
+  if ((event == EVENT_TASK_RUN_STATUS_CHANGED)
+      && (((task_status_t) event_data) == TASK_STATUS_DONE))
+    check_task_tickets (resource_1);
+
+  event_alerts (event, event_data, resource_1, resource_2);
+}
+
+/**
+ * @brief Jobs run at the end of a scan.
+ */
+typedef enum
+{
+  SCAN_END_JOB_COUNTS,   ///< Rebuild the report counts cache.
+  SCAN_END_JOB_ASSETS,   ///< Add the report hosts to the assets.
+  SCAN_END_JOB_TICKETS,  ///< Check the tickets of the task.
+  SCAN_END_JOB_ALERTS,   ///< Run the alerts of the task.
+  SCAN_END_JOB_MAX       ///< Number of jobs.
+} scan_end_job_t;
+
+/**
+ * @brief Maximum number of scan end jobs run at the same time.
+ */
+#define SCAN_END_WORKERS 3
+
+/**
+ * @brief Microseconds to wait between checks for finished scan end jobs.
+ */
+#define SCAN_END_POLL_USECS 100000
+
+/**
+ * @brief Seconds a scan end job may run before it is killed.
+ */
+#define SCAN_END_JOB_TIMEOUT (60 * 60)
+
+/**
+ * @brief Names of the scan end jobs, for logging.
+ */
+static const char *scan_end_job_names[] =
+  { "report counts", "assets", "tickets", "alerts" };
+
+/**
+ * @brief Jobs that must finish before each scan end job starts, as bit masks.
+ *
+ * Alert conditions and the reports sent by alerts use the report counts.
+ */
+static const int scan_end_job_depends[] =
+  { 0, 0, 0, 1 << SCAN_END_JOB_COUNTS };
+
+/**
+ * @brief Run a single scan end job, logging how long it took.
+ *
+ * @param[in]  job     Job.
+ * @param[in]  task    Task.
+ * @param[in]  report  Report of the scan.
+ */
+static void
+scan_end_job_run (scan_end_job_t job, task_t task, report_t report)
+{
+  gint64 start;
+
+  start = g_get_monotonic_time ();
+
+  switch (job)
+    {
+      case SCAN_END_JOB_COUNTS:
+        report_cache_counts (report, 0, 0, NULL);
+        break;
+      case SCAN_END_JOB_ASSETS:
+        hosts_set_identifiers (report);
+        hosts_set_max_severity (report, NULL, NULL);
+        hosts_set_details (report);
+        break;
+      case SCAN_END_JOB_TICKETS:
+        check_task_tickets (task);
+        break;
+      case SCAN_END_JOB_ALERTS:
+        event_alerts (EVENT_TASK_RUN_STATUS_CHANGED,
+                      (void*) TASK_STATUS_DONE,
+                      task,
+                      report);
+        break;
+      default:
+        assert (0);
+        break;
+    }
+
+  g_info ("%s: %s of task %llu took %.2f seconds",
+          __FUNCTION__,
+          scan_end_job_names[job],
+          task,
+          (g_get_monotonic_time () - start) / (double) G_USEC_PER_SEC);
+}
+
+/**
+ * @brief Start a scan end job in a child process.
+ *
+ * Runs the job in the current process if the fork fails.
+ *
+ * @param[in]  job     Job.
+ * @param[in]  task    Task.
+ * @param[in]  report  Report of the scan.
+ *
+ * @return PID of child, or 0 if the job has already run.
+ */
+static pid_t
+scan_end_job_start (scan_end_job_t job, task_t task, report_t report)
+{
+  pid_t pid;
+
+  pid = fork ();
+  switch (pid)
+    {
+      case 0:
+        /* Child.  The parent is still responsible for the scan, so make
+         * sure the exit cleanup leaves the task alone. */
+        current_scanner_task = (task_t) 0;
+        global_current_report = (report_t) 0;
+        reinit_manage_process ();
+        manage_session_init (current_credentials.uuid);
+
+        scan_end_job_run (job, task, report);
+
+        /* Skip the atexit handlers.  On the slave path they would stop the
+         * slave task and close the slave connection, which the child shares
+         * with the parent. */
+        cleanup_manage_process (TRUE);
+        _exit (EXIT_SUCCESS);
+
+      case -1:
+        g_warning ("%s: fork failed, running %s in this process",
+                   __FUNCTION__,
+                   scan_end_job_names[job]);
+        scan_end_job_run (job, task, report);
+        return 0;
+
+      default:
+        return pid;
+    }
+}
+
+/**
+ * @brief Run the jobs at the end of a scan.
+ *
+ * The jobs are run by a small pool of child processes.  Jobs that do not
+ * depend on each other run at the same time, and each job starts as soon as
+ * the jobs it depends on have finished.  A job that runs for longer than
+ * SCAN_END_JOB_TIMEOUT seconds is killed.
+ *
+ * @param[in]  task    Task.
+ * @param[in]  report  Report of the scan, or 0.
+ * @param[in]  assets  Whether to add the report hosts to the assets.
+ */
+static void
+run_scan_end_jobs (task_t task, report_t report, int assets)
+{
+  pid_t pids[SCAN_END_JOB_MAX];
+  gint64 starts[SCAN_END_JOB_MAX];
+  int pending, running, workers;
+  gint64 start;
+
+  start = g_get_monotonic_time ();
+
+  pending = (1 << SCAN_END_JOB_TICKETS) | (1 << SCAN_END_JOB_ALERTS);
+  if (report && setting_auto_cache_rebuild_int ())
+    pending |= 1 << SCAN_END_JOB_COUNTS;
+  if (report && assets)
+    pending |= 1 << SCAN_END_JOB_ASSETS;
+
+  running = 0;
+  workers = 0;
+  while (pending || running)
+    {
+      int job;
+
+      for (job = 0; job < SCAN_END_JOB_MAX; job++)
+        if ((pending & (1 << job))
+            && ((scan_end_job_depends[job] & (pending | running)) == 0)
+            && (workers < SCAN_END_WORKERS))
+          {
+            pending &= ~(1 << job);
+            pids[job] = scan_end_job_start (job, task, report);
+            starts[job] = g_get_monotonic_time ();
+            if (pids[job] > 0)
+              {
+                running |= 1 << job;
+                workers++;
+              }
+          }
+
+      if (running == 0)
+        continue;
+
+      gvm_usleep (SCAN_END_POLL_USECS);
+
+      for (job = 0; job < SCAN_END_JOB_MAX; job++)
+        if (running & (1 << job))
+          {
+            int status;
+            pid_t ret;
+
+            ret = waitpid (pids[job], &status, WNOHANG);
+            if (ret == 0
+                && (g_get_monotonic_time () - starts[job]
+                    > (gint64) SCAN_END_JOB_TIMEOUT * G_USEC_PER_SEC))
+              {
+                /* Kill a stuck job, so that it cannot block the task. */
+                g_warning ("%s: %s timed out, killing it",
+                           __FUNCTION__,
+                           scan_end_job_names[job]);
+                kill (pids[job], SIGKILL);
+                while ((ret = waitpid (pids[job], &status, 0)) < 0
+                       && errno == EINTR);
+              }
+            if (ret == 0 || (ret < 0 && errno == EINTR))
+              continue;
+            if (ret < 0)
+              g_warning ("%s: waitpid for %s: %s",
+                         __FUNCTION__,
+                         scan_end_job_names[job],
+                         strerror (errno));
+            else if (WIFEXITED (status) == 0
+                     || WEXITSTATUS (status) != EXIT_SUCCESS)
+              g_warning ("%s: %s failed",
+                         __FUNCTION__,
+                         scan_end_job_names[job]);
+            running &= ~(1 << job);
+            workers--;
+          }
+    }
+
+  g_info ("%s: scan end of task %llu took %.2f seconds",
+          __FUNCTION__,
+          task,
+          (g_get_monotonic_time () - start) / (double) G_USEC_PER_SEC);
+}
+
 /**
  * @brief Initialise an alert task iterator.
  *
@@ -16290,8 +17043,14 @@ check_db_port_lists ()
    * ranges were initialised to 65536.
    *
    * This should be a migrator, but this way is easier to backport.  */
+  sql ("DELETE FROM port_list_intervals"
+       " WHERE port_list IN (SELECT port_list FROM port_ranges"
+       "                     WHERE \"end\" = 65536 OR start = 65536);");
   sql ("UPDATE port_ranges SET \"end\" = 65535 WHERE \"end\" = 65536;");
   sql ("UPDATE port_ranges SET start = 65535 WHERE start = 65536;");
+
+  /* Compile new predefined port lists, and any changed above. */
+  port_lists_compile_missing ();
 }
 
 /**
@@ -16790,6 +17549,10 @@ check_db_nvt_selectors ()
 static void
 check_db_configs ()
 {
+  /* The checks below may adjust the predefined configs, so drop all cached
+   * scanner payloads. */
+  sql ("DELETE FROM config_otp_caches;");
+
   if (sql_int ("SELECT count(*) FROM configs"
                " WHERE name = 'Full and fast';")
       == 0)
@@ -19316,7 +20079,8 @@ set_task_run_status_internal (task_t task, task_status_t status)
       sql ("UPDATE reports SET scan_run_status = %u WHERE id = %llu;",
            status,
            global_current_report);
-      if (setting_auto_cache_rebuild_int ())
+      /* At the end of a scan the counts are rebuilt by the scan end jobs. */
+      if (setting_auto_cache_rebuild_int () && status != TASK_STATUS_DONE)
         report_cache_counts (global_current_report, 0, 0, NULL);
     }
 
@@ -19326,21 +20090,17 @@ set_task_run_status_internal (task_t task, task_status_t status)
 }
 
 /**
- * @brief Set the run state of a task.
- *
- * Logs and generates event.
+ * @brief Log a change to the run state of a task.
  *
  * @param[in]  task    Task.
  * @param[in]  status  New run status.
  */
-void
-set_task_run_status (task_t task, task_status_t status)
+static void
+log_task_run_status (task_t task, task_status_t status)
 {
   char *uuid;
   char *name;
 
-  set_task_run_status_internal (task, status);
-
   task_uuid (task, &uuid);
   name = task_name (task);
   g_log ("event task", G_LOG_LEVEL_MESSAGE,
@@ -19348,6 +20108,27 @@ set_task_run_status (task_t task, task_status_t status)
          name, uuid, run_status_name (status));
   free (uuid);
   free (name);
+}
+
+/**
+ * @brief Set the run state of a task.
+ *
+ * Logs and generates event.
+ *
+ * @param[in]  task    Task.
+ * @param[in]  status  New run status.
+ */
+void
+set_task_run_status (task_t task, task_status_t status)
+{
+  if (status == TASK_STATUS_DONE)
+    {
+      set_task_run_status_done (task, 0);
+      return;
+    }
+
+  set_task_run_status_internal (task, status);
+  log_task_run_status (task, status);
 
   event (EVENT_TASK_RUN_STATUS_CHANGED,
          (void*) status,
@@ -19355,6 +20136,24 @@ set_task_run_status (task_t task, task_status_t status)
          (task == current_scanner_task) ? global_current_report : 0);
 }
 
+/**
+ * @brief Set the run state of a task to Done, and run the scan end jobs.
+ *
+ * @param[in]  task    Task.
+ * @param[in]  assets  Whether to add the hosts of the current report to the
+ *                     assets.
+ */
+void
+set_task_run_status_done (task_t task, int assets)
+{
+  set_task_run_status_internal (task, TASK_STATUS_DONE);
+  log_task_run_status (task, TASK_STATUS_DONE);
+
+  run_scan_end_jobs (task,
+                     (task == current_scanner_task) ? global_current_report : 0,
+                     assets);
+}
+
 /**
  * @brief Atomically set the run state of a task to requested.
  *
@@ -20265,11 +21064,14 @@ static double
 task_severity_double (task_t task, int overrides, int min_qod, int offset)
 {
   report_t report;
+  int holes, infos, logs, warnings, false_positives;
+  double severity;
 
   if (current_credentials.uuid == NULL
       || task_target (task) == 0 /* Container task. */)
     return SEVERITY_MISSING;
 
+  report = 0;
   sql_int64 (&report,
              "SELECT id FROM reports"
              "           WHERE reports.task = %llu"
@@ -20277,8 +21079,14 @@ task_severity_double (task_t task, int overrides, int min_qod, int offset)
              "           ORDER BY reports.date DESC"
              "           LIMIT 1 OFFSET %d",
              task, TASK_STATUS_DONE, offset);
+  if (report == 0)
+    return SEVERITY_MISSING;
 
-  return report_severity (report, overrides, min_qod);
+  if (report_summary (report, overrides, min_qod, &holes, &infos, &logs,
+                      &warnings, &false_positives, &severity))
+    return SEVERITY_MISSING;
+
+  return severity;
 }
 
 /**
@@ -20518,34 +21326,80 @@ update_duration_schedule_periods (task_t task)
   g_free (task_element);
 }
 
+/**
+ * @brief Maximum number of reports auto_delete_reports deletes per call.
+ */
+#define AUTO_DELETE_REPORTS_PER_TICK 20
+
+/**
+ * @brief Reports that auto_delete_reports failed to delete.
+ *
+ * These are skipped on later ticks, so that they do not take up the budget
+ * of every tick.
+ */
+static GHashTable *auto_delete_failed = NULL;
+
+/**
+ * @brief Last auto delete backlog recorded, -1 if none.
+ */
+static int auto_delete_backlog = -1;
+
+/**
+ * @brief Record the auto delete backlog.
+ *
+ * The backlog is stored in the meta table as auto_delete_backlog, and
+ * logged, whenever it changes.
+ *
+ * @param[in]  backlog  Number of surplus reports left to delete.
+ */
+static void
+auto_delete_backlog_set (int backlog)
+{
+  if (backlog == auto_delete_backlog)
+    return;
+
+  if (sql_begin_immediate_giveup ())
+    return;
+  sql ("DELETE FROM meta WHERE name = 'auto_delete_backlog';");
+  sql ("INSERT INTO meta (name, value) VALUES ('auto_delete_backlog', %i);",
+       backlog);
+  sql_commit ();
+
+  if (backlog || auto_delete_backlog > 0)
+    g_info ("%s: %i surplus reports left to delete", __FUNCTION__, backlog);
+  auto_delete_backlog = backlog;
+}
+
 /**
  * @brief Auto delete reports.
+ *
+ * Called on every scheduler tick.  Deletes at most
+ * AUTO_DELETE_REPORTS_PER_TICK surplus reports, each in its own short
+ * transaction that claims only the row of the report, so that readers of
+ * other reports are never blocked.  The budget is shared round-robin
+ * between the tasks, so that reports that are in use cannot starve other
+ * tasks.  Reports that fail to delete are skipped on later ticks.  Reports
+ * left over are deleted on later ticks.
  */
 void
 auto_delete_reports ()
 {
   iterator_t tasks;
+  GPtrArray *task_reports;
+  array_t *reports;
+  report_t *report;
+  int index, round, backlog;
 
   g_debug ("%s", __FUNCTION__);
 
-  if (sql_is_sqlite3 ())
-    {
-      if (sql_begin_exclusive_giveup ())
-        return;
-    }
-  else
-    {
-      sql_begin_immediate ();
+  if (auto_delete_failed == NULL)
+    auto_delete_failed = g_hash_table_new_full (g_int64_hash, g_int64_equal,
+                                                g_free, NULL);
 
-      /* As in delete_report, this prevents other processes from getting the
-       * report ID. */
-      if (sql_error ("LOCK table reports IN ACCESS EXCLUSIVE MODE NOWAIT;"))
-        {
-          sql_rollback ();
-          return;
-        }
-    }
+  /* Collect the surplus reports of each task, oldest first. */
 
+  task_reports = g_ptr_array_new ();
+  backlog = 0;
   init_iterator (&tasks,
                  "SELECT id, name,"
                  "       (SELECT value FROM task_preferences"
@@ -20561,7 +21415,7 @@ auto_delete_reports ()
   while (next (&tasks))
     {
       task_t task;
-      iterator_t reports;
+      iterator_t surplus;
       const char *keep_string;
       int keep;
 
@@ -20578,7 +21432,8 @@ auto_delete_reports ()
               iterator_string (&tasks, 1),
               keep);
 
-      init_iterator (&reports,
+      reports = make_array ();
+      init_iterator (&surplus,
                      "SELECT id FROM reports"
                      " WHERE task = %llu"
                      " AND start_time IS NOT NULL"
@@ -20587,35 +21442,109 @@ auto_delete_reports ()
                      task,
                      sql_select_limit (-1),
                      keep);
-      while (next (&reports))
+      while (next (&surplus))
         {
-          int ret;
-          report_t report;
+          report_t surplus_report;
 
-          report = iterator_int64 (&reports, 0);
-          assert (report);
-
-          g_debug ("%s: delete %llu", __FUNCTION__, report);
-          ret = delete_report_internal (report);
-          if (ret == 2)
-            {
-              /* Report is in use. */
-              g_debug ("%s: %llu is in use", __FUNCTION__, report);
-              continue;
-            }
-          if (ret)
-            {
-              g_warning ("%s: failed to delete %llu (%i)",
-                         __FUNCTION__, report, ret);
-              sql_rollback ();
-            }
+          backlog++;
+          surplus_report = iterator_int64 (&surplus, 0);
+          assert (surplus_report);
+          if (reports->len >= AUTO_DELETE_REPORTS_PER_TICK
+              || g_hash_table_contains (auto_delete_failed, &surplus_report))
+            continue;
+          report = g_malloc0 (sizeof (report_t));
+          *report = surplus_report;
+          array_add (reports, report);
         }
-      cleanup_iterator (&reports);
+      cleanup_iterator (&surplus);
+
+      if (reports->len)
+        g_ptr_array_add (task_reports, reports);
+      else
+        array_free (reports);
     }
   cleanup_iterator (&tasks);
-  sql_commit ();
-}
 
+  /* Share the budget between the tasks, one report per task per round. */
+
+  reports = make_array ();
+  for (round = 0;
+       round < AUTO_DELETE_REPORTS_PER_TICK
+       && reports->len < AUTO_DELETE_REPORTS_PER_TICK;
+       round++)
+    for (index = 0;
+         index < task_reports->len
+         && reports->len < AUTO_DELETE_REPORTS_PER_TICK;
+         index++)
+      {
+        array_t *surplus;
+
+        surplus = (array_t*) g_ptr_array_index (task_reports, index);
+        if (round < surplus->len)
+          {
+            report = g_malloc0 (sizeof (report_t));
+            *report = *(report_t*) g_ptr_array_index (surplus, round);
+            array_add (reports, report);
+          }
+      }
+  for (index = 0; index < task_reports->len; index++)
+    array_free ((array_t*) g_ptr_array_index (task_reports, index));
+  g_ptr_array_free (task_reports, TRUE);
+
+  /* Delete the collected reports. */
+
+  for (index = 0; index < reports->len; index++)
+    {
+      int ret;
+      report_t *failed;
+
+      report = (report_t*) g_ptr_array_index (reports, index);
+
+      if (sql_begin_immediate_giveup ())
+        {
+          g_debug ("%s: database busy, leaving the rest for later",
+                   __FUNCTION__);
+          break;
+        }
+
+      /* Claim the report row, so that no other process can use the report
+       * while it is deleted.  Skip reports that are claimed already. */
+      if (sql_is_sqlite3 () == 0
+          && sql_error ("SELECT id FROM reports WHERE id = %llu"
+                        " FOR UPDATE NOWAIT;",
+                        *report))
+        {
+          g_debug ("%s: %llu is locked", __FUNCTION__, *report);
+          sql_rollback ();
+          continue;
+        }
+
+      g_debug ("%s: delete %llu", __FUNCTION__, *report);
+      ret = delete_report_internal (*report);
+      if (ret == 2)
+        {
+          /* Report is in use. */
+          g_debug ("%s: %llu is in use", __FUNCTION__, *report);
+          sql_rollback ();
+          continue;
+        }
+      if (ret)
+        {
+          g_warning ("%s: failed to delete %llu (%i), skipping it from now on",
+                     __FUNCTION__, *report, ret);
+          sql_rollback ();
+          failed = g_malloc0 (sizeof (report_t));
+          *failed = *report;
+          g_hash_table_add (auto_delete_failed, failed);
+          continue;
+        }
+      sql_commit ();
+      backlog--;
+    }
+  array_free (reports);
+
+  auto_delete_backlog_set (backlog);
+}
 
 /**
  * @brief Get definitions file from a task's config.
@@ -20645,7 +21574,7 @@ reschedule_task (const gchar *task_id)
   task = 0;
   switch (sql_int64 (&task,
                      "SELECT id FROM tasks WHERE uuid = '%s'"
-                     " AND hidden != 2;",
+                     " AND hidden < 2;",
                      task_id))
     {
       case 0:
@@ -20790,11 +21719,11 @@ make_osp_result (task_t task, const char *host, const char *nvt,
   result_nvt_notice (quoted_nvt);
   sql ("INSERT into results"
        " (owner, date, task, host, port, nvt, nvt_version, severity, type,"
-       "  qod, qod_type, description, uuid)"
+       "  qod, qod_type, description, uuid, host_inet)"
        " VALUES (NULL, m_now(), %llu, '%s', '%s', '%s', '%s', '%s', '%s',"
-       "         %d, '', '%s', make_uuid ());",
+       "         %d, '', '%s', make_uuid (), host_inet ('%s'));",
        task, host ?: "", quoted_port, quoted_nvt, nvt_revision ?: "",
-       result_severity ?: "0", type, qod, quoted_desc);
+       result_severity ?: "0", type, qod, quoted_desc, host ?: "");
   g_free (result_severity);
   g_free (nvt_revision);
   g_free (quoted_desc);
@@ -21136,15 +22065,16 @@ make_result (task_t task, const char* host, const char *hostname,
   sql ("INSERT into results"
        " (owner, date, task, host, hostname, port,"
        "  nvt, nvt_version, severity, type,"
-       "  description, uuid, qod, qod_type, result_nvt)"
+       "  description, uuid, qod, qod_type, result_nvt, host_inet)"
        " VALUES"
        " (NULL, m_now (), %llu, '%s', '%s', '%s',"
        "  '%s', '%s', '%s', '%s',"
        "  '%s', make_uuid (), %i, '%s',"
-       "  (SELECT id FROM result_nvts WHERE nvt = '%s'));",
+       "  (SELECT id FROM result_nvts WHERE nvt = '%s'),"
+       "  host_inet ('%s'));",
        task, host ?: "", quoted_hostname, port ?: "",
        nvt ?: "", nvt_revision, severity, type,
-       quoted_descr, qod, quoted_qod_type, nvt ? nvt : "");
+       quoted_descr, qod, quoted_qod_type, nvt ? nvt : "", host ?: "");
 
   g_free (quoted_hostname);
   g_free (quoted_descr);
@@ -21175,13 +22105,14 @@ make_cve_result (task_t task, const char* host, const char *nvt, double cvss,
   result_nvt_notice (nvt);
   sql ("INSERT into results"
        " (owner, date, task, host, port, nvt, nvt_version, severity, type,"
-       "  description, uuid, qod, qod_type, result_nvt)"
+       "  description, uuid, qod, qod_type, result_nvt, host_inet)"
        " VALUES"
        " (NULL, m_now (), %llu, '%s', '', '%s', '', '%1.1f', '%s',"
        "  '%s', make_uuid (), %i, '',"
-       "  (SELECT id FROM result_nvts WHERE nvt = '%s'));",
+       "  (SELECT id FROM result_nvts WHERE nvt = '%s'),"
+       "  host_inet ('%s'));",
        task, host ?: "", nvt, cvss, severity_to_type (cvss),
-       quoted_descr, QOD_DEFAULT, nvt);
+       quoted_descr, QOD_DEFAULT, nvt, host ?: "");
 
   g_free (quoted_descr);
   return sql_last_insert_id ();
@@ -21356,15 +22287,13 @@ static void
 init_prognosis_iterator (iterator_t *iterator, const char *cpe)
 {
   if (prognosis_stmt == NULL)
-    prognosis_stmt = sql_prepare ("SELECT cves.name, cves.cvss,"
-                                  "       cves.description, cpes.name"
-                                  " FROM scap.cves, scap.cpes,"
-                                  "      scap.affected_products"
-                                  " WHERE cpes.name=$1"
-                                  " AND cpes.id=affected_products.cpe"
-                                  " AND cves.id=affected_products.cve"
-                                  " ORDER BY CAST (cves.cvss AS NUMERIC)"
-                                  " DESC;");
+    prognosis_stmt = sql_prepare ("SELECT cpe_cves.cve_name, cpe_cves.cvss,"
+                                  "       (SELECT description FROM scap.cves"
+                                  "        WHERE id = cpe_cves.cve),"
+                                  "       cpe_cves.cpe_name"
+                                  " FROM scap.cpe_cves"
+                                  " WHERE cpe_cves.cpe_name = $1"
+                                  " ORDER BY cpe_cves.cvss DESC;");
   else
     {
       if (sql_reset (prognosis_stmt))
@@ -21393,6 +22322,16 @@ DEF_ACCESS (prognosis_iterator_cvss, 1);
 DEF_ACCESS (prognosis_iterator_description, 2);
 DEF_ACCESS (prognosis_iterator_cpe, 3);
 
+/**
+ * @brief Get the location of the App from a report host prognosis iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Location if there is one, else NULL.  Caller must only use before
+ *         calling cleanup_iterator.
+ */
+DEF_ACCESS (prognosis_iterator_app_location, 5);
+
 /**
  * @brief Get the CVSS from a result iterator as a double.
  *
@@ -21407,43 +22346,6 @@ prognosis_iterator_cvss_double (iterator_t* iterator)
   return iterator_double (iterator, 1);
 }
 
-/**
- * @brief Get the location of an App for a report's host.
- *
- * @param[in]  report_host  Report host.
- * @param[in]  app          CPE.
- *
- * @return Location if there is one, else NULL.
- */
-gchar *
-app_location (report_host_t report_host, const gchar *app)
-{
-  gchar *quoted_app, *ret;
-
-  assert (app);
-
-  quoted_app = sql_quote (app);
-
-  ret = sql_string ("SELECT value FROM report_host_details"
-                    " WHERE report_host = %llu"
-                    " AND name = '%s'"
-                    " AND source_type = 'nvt'"
-                    " AND source_name"
-                    "     = (SELECT source_name FROM report_host_details"
-                    "        WHERE report_host = %llu"
-                    "        AND source_type = 'nvt'"
-                    "        AND name = 'App'"
-                    "        AND value = '%s');",
-                    report_host,
-                    quoted_app,
-                    report_host,
-                    quoted_app);
-
-  g_free (quoted_app);
-
-  return ret;
-}
-
 /**
  * @brief Return SQL WHERE for restricting a SELECT to a search phrase.
  *
@@ -21467,8 +22369,8 @@ prognosis_where_search_phrase (const char* search_phrase)
       phrase_sql = g_string_new ("");
       g_string_append_printf (phrase_sql,
                               " AND (cves.description %s '%%%%%s%%%%'"
-                              " OR cves.name %s '%%%%%s%%%%'"
-                              " OR cpes.name %s '%%%%%s%%%%')",
+                              " OR cpe_cves.cve_name %s '%%%%%s%%%%'"
+                              " OR cpe_cves.cpe_name %s '%%%%%s%%%%')",
                               sql_ilike_op (),
                               quoted_search_phrase,
                               sql_ilike_op (),
@@ -21508,22 +22410,22 @@ prognosis_where_levels (const char* levels)
     return "";
 
   if (high && medium)
-    return " AND cves.cvss > 2";
+    return " AND cpe_cves.cvss > 2";
 
   if (high && low)
-    return " AND (cves.cvss > 5 OR cves.cvss <= 2)";
+    return " AND (cpe_cves.cvss > 5 OR cpe_cves.cvss <= 2)";
 
   if (medium && low)
-    return " AND cves.cvss <= 5";
+    return " AND cpe_cves.cvss <= 5";
 
   if (high)
-    return " AND cves.cvss > 5";
+    return " AND cpe_cves.cvss > 5";
 
   if (medium)
-    return " AND cves.cvss <= 5 AND cves.cvss > 2";
+    return " AND cpe_cves.cvss <= 5 AND cpe_cves.cvss > 2";
 
   if (low)
-    return " AND cves.cvss <= 2";
+    return " AND cpe_cves.cvss <= 2";
 
   return "";
 }
@@ -21543,7 +22445,7 @@ prognosis_order_by (const char* sort_field, int ascending)
 
   if ((sort_field == NULL) || strcmp (sort_field, "ROWID") == 0)
     g_string_append_printf (order_sql,
-                            " ORDER BY cves.id %s",
+                            " ORDER BY cpe_cves.cve %s",
                             ascending ? "ASC" : "DESC");
   else if (strcmp (sort_field, "host") == 0)
     g_string_append_printf (order_sql,
@@ -21604,20 +22506,29 @@ init_host_prognosis_iterator (iterator_t* iterator, report_host_t report_host,
   phrase_sql = prognosis_where_search_phrase (search_phrase);
   order_sql = prognosis_order_by (sort_field, sort_order);
 
+  /* Join the Apps of the host against the CPE index, so that the whole
+   * prognosis is a single query. */
   init_iterator (iterator,
-                 "SELECT cves.name AS vulnerability,"
-                 "       CAST (cves.cvss AS NUMERIC) AS severity,"
+                 "SELECT cpe_cves.cve_name AS vulnerability,"
+                 "       cpe_cves.cvss AS severity,"
                  "       cves.description,"
-                 "       cpes.name AS location,"
+                 "       cpe_cves.cpe_name AS location,"
                  "       (SELECT host FROM report_hosts"
-                 "        WHERE id = %llu) AS host"
-                 " FROM scap.cves, scap.cpes, scap.affected_products,"
-                 "      report_host_details"
+                 "        WHERE id = %llu) AS host,"
+                 "       (SELECT value FROM report_host_details AS locations"
+                 "        WHERE locations.report_host"
+                 "              = report_host_details.report_host"
+                 "        AND locations.name = report_host_details.value"
+                 "        AND locations.source_type = 'nvt'"
+                 "        AND locations.source_name"
+                 "            = report_host_details.source_name"
+                 "        LIMIT 1)"
+                 "       AS app_location"
+                 " FROM scap.cpe_cves, scap.cves, report_host_details"
                  " WHERE report_host_details.report_host = %llu"
-                 " AND cpes.name = report_host_details.value"
                  " AND report_host_details.name = 'App'"
-                 " AND cpes.id=affected_products.cpe"
-                 " AND cves.id=affected_products.cve"
+                 " AND cpe_cves.cpe_name = report_host_details.value"
+                 " AND cves.id = cpe_cves.cve"
                  "%s%s%s"
                  " LIMIT %s OFFSET %i;",
                  report_host,
@@ -21662,52 +22573,31 @@ static void
 reports_add_for_override (GHashTable *reports_table,
                           override_t override)
 {
-  result_t result;
-  task_t task;
-  gchar *nvt_id;
   iterator_t reports;
 
   if (override == 0)
     return;
 
-  sql_int64 (&result,
-             "SELECT result FROM overrides WHERE id = %llu",
-             override);
-  sql_int64 (&task,
-             "SELECT task FROM overrides WHERE id = %llu",
-             override);
-  nvt_id = sql_string ("SELECT nvt FROM overrides WHERE id = %llu",
-                       override);
-
-  if (result)
-    {
-      report_t *report = g_malloc0 (sizeof (report_t));
-      sql_int64 (report,
-                 "SELECT report FROM results"
-                 " WHERE id = %llu AND nvt = '%s'",
-                 result, nvt_id);
-
-      if (*report)
-        g_hash_table_add (reports_table, report);
-      else
-        g_free (report);
+  /* Only take reports that have a result that the override applies to. */
 
-      return;
-    }
-  else if (task)
-    {
-      init_iterator (&reports,
-                     "SELECT DISTINCT report FROM results"
-                     " WHERE task = %llu AND nvt = '%s'",
-                     task, nvt_id);
-    }
-  else
-    {
-      init_iterator (&reports,
-                     "SELECT DISTINCT report FROM results"
-                     " WHERE nvt = '%s'",
-                     nvt_id);
-    }
+  init_iterator (&reports,
+                 "SELECT DISTINCT results.report"
+                 " FROM results, overrides"
+                 " WHERE overrides.id = %llu"
+                 " AND results.nvt = overrides.nvt"
+                 " AND (overrides.task = 0"
+                 "      OR results.task = overrides.task)"
+                 " AND (overrides.result = 0"
+                 "      OR results.id = overrides.result)"
+                 " AND (overrides.hosts is NULL"
+                 "      OR overrides.hosts = ''"
+                 "      OR hosts_contains (overrides.hosts, results.host))"
+                 " AND (overrides.port is NULL"
+                 "      OR overrides.port = ''"
+                 "      OR overrides.port = results.port)"
+                 " AND severity_matches_ov (results.severity,"
+                 "                          overrides.severity);",
+                 override);
 
   while (next (&reports))
     {
@@ -21803,6 +22693,9 @@ reports_build_count_cache (int clear, int* changes_out)
        " WHERE (SELECT hidden = 2 FROM tasks"
        "        WHERE tasks.id = (SELECT task FROM reports"
        "                          WHERE reports.id = report_counts.report));");
+  sql ("DELETE FROM task_report_summaries"
+       " WHERE (SELECT hidden = 2 FROM tasks"
+       "        WHERE tasks.id = task_report_summaries.task);");
 
   init_iterator (&reports,
                  "SELECT id FROM reports"
@@ -21974,6 +22867,8 @@ report_cache_counts (report_t report, int clear_original, int clear_overridden,
   gchar *old_user_id;
 
   old_user_id = current_credentials.uuid;
+  report_clear_summaries (report, clear_original, clear_overridden,
+                          users_where);
   init_report_counts_build_iterator (&cache_iterator, report, INT_MAX, 1,
                                      users_where);
 
@@ -22003,6 +22898,10 @@ report_cache_counts (report_t report, int clear_original, int clear_overridden,
       report_counts_id (report, &debugs, &holes, &infos, &logs, &warnings,
                         &false_positives, &severity, get, NULL);
 
+      /* Keep the task report summary in step with the counts. */
+      report_summary (report, override, min_qod, &holes, &infos, &logs,
+                      &warnings, &false_positives, &severity);
+
       get_data_reset (get);
       g_free (get);
       g_free (current_credentials.uuid);
@@ -22054,6 +22953,275 @@ report_clear_count_cache (report_t report,
            override,
            extra_where ? extra_where : "");
     }
+
+  report_clear_summaries (report, clear_original, clear_overridden,
+                          users_where);
+}
+
+/**
+ * @brief Clear the task report summaries of a report.
+ *
+ * @param[in]  report  Report.
+ * @param[in]  clear_original     Whether to clear summaries for
+ *                                 original severity.
+ * @param[in]  clear_overridden   Whether to clear summaries for
+ *                                 overridden severity.
+ * @param[in]  users_where        Optional SQL clause to limit users.
+ */
+static void
+report_clear_summaries (report_t report, int clear_original,
+                        int clear_overridden, const char* users_where)
+{
+  gchar *extra_where;
+
+  if (clear_original == 0 && clear_overridden == 0)
+    return;
+
+  if (users_where)
+    extra_where
+      = g_strdup_printf (" AND \"user\" IN (SELECT id FROM users WHERE %s)",
+                         users_where);
+  else
+    extra_where = NULL;
+
+  if (clear_original && clear_overridden)
+    sql ("DELETE FROM task_report_summaries"
+         " WHERE report = %llu"
+         "%s",
+         report,
+         extra_where ? extra_where : "");
+  else
+    sql ("DELETE FROM task_report_summaries"
+         " WHERE report = %llu"
+         "   AND override = %d"
+         "%s",
+         report,
+         clear_overridden ? 1 : 0,
+         extra_where ? extra_where : "");
+
+  g_free (extra_where);
+}
+
+/**
+ * @brief Refresh the overridden counts of reports after an override change.
+ *
+ * With automatic cache rebuilding the rebuild is queued for the background
+ * refresh in manage_refresh_report_counts.  Until then the cached counts
+ * stay in use, and the reports show that their counts are refreshing.
+ * Otherwise the counts are just cleared, to be rebuilt on the next read.
+ *
+ * @param[in]  reports      Reports, as from reports_for_override.
+ * @param[in]  users_where  Optional SQL clause to limit users.
+ */
+static void
+reports_refresh_override_counts (GHashTable *reports, const char *users_where)
+{
+  GHashTableIter reports_iter;
+  report_t *reports_ptr;
+  int auto_cache_rebuild;
+
+  auto_cache_rebuild = setting_auto_cache_rebuild_int ();
+  g_hash_table_iter_init (&reports_iter, reports);
+  reports_ptr = NULL;
+  while (g_hash_table_iter_next (&reports_iter,
+                                 ((gpointer*)&reports_ptr), NULL))
+    {
+      if (auto_cache_rebuild)
+        sql ("INSERT INTO report_counts_refresh (report, \"user\")"
+             " SELECT %llu, id FROM users WHERE %s;",
+             *reports_ptr,
+             users_where ? users_where : "t ()");
+      else
+        report_clear_count_cache (*reports_ptr, 0, 1, users_where);
+    }
+}
+
+/**
+ * @brief Check whether the counts of a report are waiting for a refresh.
+ *
+ * @param[in]  report  Report.
+ *
+ * @return 1 if refreshing for the current user, else 0.
+ */
+static int
+report_counts_refreshing (report_t report)
+{
+  return sql_int ("SELECT EXISTS (SELECT * FROM report_counts_refresh"
+                  "               WHERE report = %llu"
+                  "               AND \"user\" = (SELECT id FROM users"
+                  "                               WHERE uuid = '%s'));",
+                  report,
+                  current_credentials.uuid);
+}
+
+/**
+ * @brief Fork a child that holds an exclusive lock file.
+ *
+ * The parent returns to the caller straight away.  The child restores the
+ * sigmask, takes the lock and reinitialises the manage process.  If another
+ * process holds the lock then the child exits.
+ *
+ * @param[in]   sigmask_current  Sigmask to restore in child.
+ * @param[in]   lock_name        Name of lock file in the tmp dir.
+ * @param[in]   caller           Name of caller, for log messages.
+ * @param[out]  lockfile         Lock file descriptor, in the child.
+ *
+ * @return 0 in the child, 1 in the parent, -1 if the fork failed.
+ */
+static int
+fork_locked_child (sigset_t *sigmask_current, const gchar *lock_name,
+                   const gchar *caller, int *lockfile)
+{
+  gchar *lockfile_name;
+
+  switch (fork ())
+    {
+      case 0:
+        /* Child.  Restore the sigmask that was blanked for pselect in the
+         * parent, and cleanup so that exit works. */
+        pthread_sigmask (SIG_SETMASK, sigmask_current, NULL);
+        cleanup_manage_process (FALSE);
+
+        lockfile_name = g_build_filename (g_get_tmp_dir (), lock_name, NULL);
+        *lockfile = open (lockfile_name,
+                          O_RDWR | O_CREAT | O_APPEND,
+                          /* "-rw-r--r--" */
+                          S_IWUSR | S_IRUSR | S_IROTH | S_IRGRP);
+        if (*lockfile == -1)
+          {
+            g_warning ("%s: failed to open lock file '%s': %s", caller,
+                       lockfile_name, strerror (errno));
+            g_free (lockfile_name);
+            exit (EXIT_FAILURE);
+          }
+        g_free (lockfile_name);
+
+        if (flock (*lockfile, LOCK_EX | LOCK_NB)) /* Exclusive, Non blocking. */
+          {
+            if (errno == EWOULDBLOCK)
+              g_debug ("%s: skipping, lock held by another process", caller);
+            else
+              g_debug ("%s: flock: %s", caller, strerror (errno));
+            exit (EXIT_SUCCESS);
+          }
+
+        reinit_manage_process ();
+        manage_session_init (current_credentials.uuid);
+        return 0;
+
+      case -1:
+        /* Parent on error. */
+        g_warning ("%s: fork failed", caller);
+        return -1;
+
+      default:
+        /* Parent.  Return to the main loop. */
+        return 1;
+    }
+}
+
+/**
+ * @brief Release the lock of a child from fork_locked_child and exit.
+ *
+ * @param[in]  lockfile  Lock file descriptor.
+ * @param[in]  caller    Name of caller, for log messages.
+ */
+static void
+exit_locked_child (int lockfile, const gchar *caller)
+{
+  if (close (lockfile))
+    {
+      g_warning ("%s: failed to close lock file: %s", caller,
+                 strerror (errno));
+      exit (EXIT_FAILURE);
+    }
+
+  exit (EXIT_SUCCESS);
+}
+
+/**
+ * @brief Rebuild the report counts queued by override changes.
+ *
+ * Forks a child to do the rebuild, so that the parent can return to the
+ * main loop.  A lock file ensures that only one child rebuilds at a time.
+ * Nothing is forked while the queue is empty.
+ *
+ * @param[in]  sigmask_current  Sigmask to restore in child.
+ */
+void
+manage_refresh_report_counts (sigset_t *sigmask_current)
+{
+  int lockfile, index;
+  resource_t last;
+  array_t *reports;
+  iterator_t queued;
+  report_t *report;
+
+  if (sql_int ("SELECT NOT EXISTS (SELECT * FROM report_counts_refresh);"))
+    return;
+
+  if (fork_locked_child (sigmask_current, "gvm-refresh-report-counts",
+                         __FUNCTION__, &lockfile))
+    return;
+
+  /* Take the queue as it is now.  Entries queued during the refresh are
+   * left for the next round. */
+
+  last = sql_int64_0 ("SELECT max (id) FROM report_counts_refresh;");
+  if (last == 0)
+    exit_locked_child (lockfile, __FUNCTION__);
+
+  proctitle_set ("gvmd: Refreshing report counts");
+
+  reports = make_array ();
+  init_iterator (&queued,
+                 "SELECT DISTINCT report FROM report_counts_refresh"
+                 " WHERE id <= %llu;",
+                 last);
+  while (next (&queued))
+    {
+      report = g_malloc0 (sizeof (report_t));
+      *report = iterator_int64 (&queued, 0);
+      array_add (reports, report);
+    }
+  cleanup_iterator (&queued);
+
+  for (index = 0; index < reports->len; index++)
+    {
+      gchar *users_where;
+
+      report = (report_t*) g_ptr_array_index (reports, index);
+
+      sql_begin_immediate ();
+
+      /* Reports of trashcan tasks are not counted. */
+      if (sql_int ("SELECT count (*) FROM reports"
+                   " WHERE id = %llu"
+                   " AND (SELECT hidden = 0 FROM tasks"
+                   "      WHERE tasks.id = reports.task);",
+                   *report))
+        {
+          users_where
+            = g_strdup_printf ("id IN (SELECT \"user\""
+                               "        FROM report_counts_refresh"
+                               "        WHERE report = %llu"
+                               "        AND id <= %llu)",
+                               *report,
+                               last);
+          report_cache_counts (*report, 0, 1, users_where);
+          g_free (users_where);
+        }
+
+      sql ("DELETE FROM report_counts_refresh"
+           " WHERE report = %llu AND id <= %llu;",
+           *report,
+           last);
+
+      sql_commit ();
+    }
+  array_free (reports);
+
+  exit_locked_child (lockfile, __FUNCTION__);
 }
 
 /**
@@ -22069,10 +23237,11 @@ report_t
 make_report (task_t task, const char* uuid, task_status_t status)
 {
   sql ("INSERT into reports (uuid, owner, task, date, nbefile, comment,"
-       " scan_run_status, slave_progress, slave_task_uuid)"
+       " scan_run_status, slave_progress, slave_task_uuid, progress_sum,"
+       " progress_dead)"
        " VALUES ('%s',"
        " (SELECT owner FROM tasks WHERE tasks.id = %llu),"
-       " %llu, %i, '', '', %u, 0, '');",
+       " %llu, %i, '', '', %u, 0, '', 0, 0);",
        uuid, task, task, time (NULL), status);
   return sql_last_insert_id ();
 }
@@ -22109,6 +23278,10 @@ create_current_report (task_t task, char **report_id, task_status_t status)
 
   set_report_scheduled (global_current_report);
 
+  /* Cache the maximum number of hosts for the progress calculation. */
+
+  report_max_hosts (global_current_report, task);
+
   return 0;
 }
 
@@ -22147,6 +23320,7 @@ insert_report_host_detail (report_t report, const char *host,
 {
   char *quoted_host, *quoted_source_name, *quoted_source_type;
   char *quoted_source_desc, *quoted_name, *quoted_value;
+  gchar *hash;
 
   quoted_host = sql_quote (host);
   quoted_source_type = sql_quote (s_type);
@@ -22154,15 +23328,55 @@ insert_report_host_detail (report_t report, const char *host,
   quoted_source_desc = sql_quote (s_desc);
   quoted_name = sql_quote (name);
   quoted_value = sql_quote (value);
-  sql ("INSERT INTO report_host_details"
-       " (report_host, source_type, source_name, source_description,"
-       "  name, value)"
-       " VALUES"
-       " ((SELECT id FROM report_hosts"
-       "   WHERE report = %llu AND host = '%s'),"
-       "  '%s', '%s', '%s', '%s', '%s');",
-       report, quoted_host, quoted_source_type, quoted_source_name,
-       quoted_source_desc, quoted_name, quoted_value);
+  hash = g_compute_checksum_for_string (G_CHECKSUM_MD5, value, -1);
+
+  /* The row must only be inserted while its value exists, because the
+   * sweep in manage_sweep_report_host_detail_values may remove unused
+   * values.  On Postgres a single statement holds the table lock that the
+   * sweep waits for.  On SQLite the sweep can run between statements, so
+   * retry until the row is inserted. */
+  if (sql_is_sqlite3 ())
+    do
+      {
+        sql ("INSERT INTO report_host_detail_values (hash, value)"
+             " SELECT '%s', '%s'"
+             " WHERE NOT EXISTS (SELECT * FROM report_host_detail_values"
+             "                   WHERE hash = '%s' AND value = '%s');",
+             hash, quoted_value, hash, quoted_value);
+        sql ("INSERT INTO report_host_detail_rows"
+             " (report_host, source_type, source_name, source_description,"
+             "  name, value_id)"
+             " SELECT (SELECT id FROM report_hosts"
+             "         WHERE report = %llu AND host = '%s'),"
+             "        '%s', '%s', '%s', '%s', id"
+             " FROM report_host_detail_values"
+             " WHERE hash = '%s' AND value = '%s'"
+             " LIMIT 1;",
+             report, quoted_host, quoted_source_type, quoted_source_name,
+             quoted_source_desc, quoted_name, hash, quoted_value);
+      }
+    while (sql_changes () == 0);
+  else
+    sql ("WITH new_value AS"
+         " (INSERT INTO report_host_detail_values (hash, value)"
+         "  SELECT '%s', '%s'"
+         "  WHERE NOT EXISTS (SELECT * FROM report_host_detail_values"
+         "                    WHERE hash = '%s' AND value = '%s')"
+         "  RETURNING id)"
+         " INSERT INTO report_host_detail_rows"
+         " (report_host, source_type, source_name, source_description,"
+         "  name, value_id)"
+         " VALUES"
+         " ((SELECT id FROM report_hosts"
+         "   WHERE report = %llu AND host = '%s'),"
+         "  '%s', '%s', '%s', '%s',"
+         "  coalesce ((SELECT id FROM new_value),"
+         "            (SELECT id FROM report_host_detail_values"
+         "             WHERE hash = '%s' AND value = '%s'"
+         "             LIMIT 1)));",
+         hash, quoted_value, hash, quoted_value,
+         report, quoted_host, quoted_source_type, quoted_source_name,
+         quoted_source_desc, quoted_name, hash, quoted_value);
 
   g_free (quoted_host);
   g_free (quoted_source_type);
@@ -22170,6 +23384,29 @@ insert_report_host_detail (report_t report, const char *host,
   g_free (quoted_source_desc);
   g_free (quoted_name);
   g_free (quoted_value);
+  g_free (hash);
+}
+
+/**
+ * @brief Delete the host details of some report hosts.
+ *
+ * The values of the details are queued for the sweep in
+ * manage_sweep_report_host_detail_values, which removes the values that no
+ * other detail refers to.
+ *
+ * @param[in]  report_hosts_where  SQL condition on report_hosts that selects
+ *                                 the report hosts.
+ */
+static void
+delete_report_host_details (const char *report_hosts_where)
+{
+  sql ("INSERT INTO report_host_detail_values_sweep (value_id)"
+       " SELECT DISTINCT value_id FROM report_host_detail_rows"
+       " WHERE report_host IN (SELECT id FROM report_hosts WHERE %s);",
+       report_hosts_where);
+  sql ("DELETE FROM report_host_detail_rows"
+       " WHERE report_host IN (SELECT id FROM report_hosts WHERE %s);",
+       report_hosts_where);
 }
 
 /**
@@ -22177,6 +23414,15 @@ insert_report_host_detail (report_t report, const char *host,
  */
 #define CREATE_REPORT_INSERT_SIZE 300
 
+/**
+ * @brief End of the batched host detail values insert in create_report.
+ */
+#define REPORT_HOST_DETAIL_VALUES_NEW                                 \
+  ") AS new_values"                                                   \
+  " WHERE NOT EXISTS (SELECT * FROM report_host_detail_values"        \
+  "                   WHERE hash = new_values.hash"                   \
+  "                   AND value = new_values.value);"
+
 /**
  * @brief Number of results per transaction, when uploading report.
  */
@@ -22188,217 +23434,45 @@ insert_report_host_detail (report_t report, const char *host,
 #define CREATE_REPORT_CHUNK_SLEEP 1000
 
 /**
- * @brief Create a report from an array of results.
+ * @brief Insert results, hosts and host details into an uploaded report.
  *
+ * @param[in]   report        Report.
+ * @param[in]   task          Task of report.
+ * @param[in]   owner         Owner of task.
  * @param[in]   results       Array of create_report_result_t pointers.
- * @param[in]   task_id       UUID of container task, or NULL to create new one.
- * @param[in]   task_name     Name for container task.
- * @param[in]   task_comment  Comment for container task.
- * @param[in]   in_assets     Whether to create assets from the report.
- * @param[in]   scan_start    Scan start time text.
- * @param[in]   scan_end      Scan end time text.
  * @param[in]   host_starts   Array of create_report_result_t pointers.  Host
  *                            name in host, time in description.
  * @param[in]   host_ends     Array of create_report_result_t pointers.  Host
  *                            name in host, time in description.
  * @param[in]   details       Array of host_detail_t pointers.
- * @param[out]  report_id     Report ID.
- *
- * @return 0 success, 99 permission denied, -1 error, -2 failed to generate ID,
- *         -3 task_name is NULL, -4 failed to find task, -5 task must be
- *         container, -6 permission to create assets denied.
  */
-int
-create_report (array_t *results, const char *task_id, const char *task_name,
-               const char *task_comment, const char *in_assets,
-               const char *scan_start, const char *scan_end,
-               array_t *host_starts, array_t *host_ends, array_t *details,
-               char **report_id)
+static void
+create_report_insert (report_t report, task_t task, user_t owner,
+                      array_t *results, array_t *host_starts,
+                      array_t *host_ends, array_t *details)
 {
-  int index, in_assets_int, count, insert_count, first;
+  int index, count, insert_count, first;
   create_report_result_t *result, *end, *start;
-  report_t report;
-  user_t owner;
-  task_t task;
-  pid_t pid;
   host_detail_t *detail;
-  GString *insert;
-
-  in_assets_int
-    = (in_assets && strcmp (in_assets, "") && strcmp (in_assets, "0"));
-
-  if (in_assets_int && acl_user_may ("create_asset") == 0)
-    return -6;
-
-  g_debug ("%s", __FUNCTION__);
-
-  if (acl_user_may ("create_report") == 0)
-    return 99;
-
-  if (task_id == NULL && task_name == NULL)
-    return -3;
-
-  /* Find or create the task. */
-
-  sql_begin_immediate ();
-  if (task_id)
-    {
-      int rc = 0;
-
-      /* It's important that the task is not in the trash, because we
-       * are inserting results below.  This find function will fail if
-       * the task is in the trash. */
-      if (find_task_with_permission (task_id, &task, "modify_task"))
-        rc = -1;
-      else if (task == 0)
-        rc = -4;
-      else if (task_target (task))
-        rc = -5;
-      if (rc)
-        {
-          sql_rollback ();
-          return rc;
-        }
-    }
-  else
-    {
-      if (acl_user_may ("create_task") == 0)
-        {
-          sql_rollback ();
-          return 99;
-        }
-
-      task = make_task (g_strdup (task_name),
-                        task_comment ? g_strdup (task_comment) : NULL,
-                        1,  /* Include in assets. */
-                        1); /* Log and generate event. */
-    }
-
-  /* Generate report UUID. */
-
-  *report_id = gvm_uuid_make ();
-  if (*report_id == NULL) return -2;
-
-  /* Create the report. */
-
-  report = make_report (task, *report_id, TASK_STATUS_RUNNING);
-
-  if (scan_start)
-    {
-      sql ("UPDATE reports SET start_time = %i WHERE id = %llu;",
-           parse_iso_time (scan_start),
-           report);
-    }
-
-  if (scan_end)
-    {
-      sql ("UPDATE reports SET end_time = %i WHERE id = %llu;",
-           parse_iso_time (scan_end),
-           report);
-    }
-
-  /* Show that the upload has started. */
-
-  set_task_run_status (task, TASK_STATUS_RUNNING);
-  sql ("UPDATE tasks SET upload_result_count = %llu WHERE id = %llu;",
-       results->len,
-       task);
-  sql_commit ();
-
-  /* Fork a child to import the results while the parent responds to the
-   * client. */
-
-  pid = fork ();
-  switch (pid)
-    {
-      case 0:
-        {
-          /* Child.
-           *
-           * Fork again so the parent can wait on the child, to prevent
-           * zombies. */
-          cleanup_manage_process (FALSE);
-          pid = fork ();
-          switch (pid)
-            {
-              case 0:
-                /* Grandchild.  Reopen the database (required after fork) and carry on
-                 * to import the reports, . */
-                reinit_manage_process ();
-                break;
-              case -1:
-                /* Grandchild's parent when error. */
-                g_warning ("%s: fork: %s", __FUNCTION__, strerror (errno));
-                exit (EXIT_FAILURE);
-                break;
-              default:
-                /* Grandchild's parent.  Exit, to close parent's wait. */
-                g_debug ("%s: %i forked %i", __FUNCTION__, getpid (), pid);
-                exit (EXIT_SUCCESS);
-                break;
-            }
-        }
-        break;
-      case -1:
-        /* Parent when error. */
-        g_warning ("%s: fork: %s", __FUNCTION__, strerror (errno));
-        global_current_report = report;
-        set_task_interrupted (task,
-                              "Failed to fork child to import report."
-                              "  Setting task status to Interrupted.");
-        global_current_report = 0;
-        return -1;
-        break;
-      default:
-        {
-          int status;
-
-          /* Parent.  Wait to prevent zombie, then return to respond to client. */
-          g_debug ("%s: %i forked %i", __FUNCTION__, getpid (), pid);
-          while (waitpid (pid, &status, 0) < 0)
-            {
-              if (errno == ECHILD)
-                {
-                  g_warning ("%s: Failed to get child exit status",
-                             __FUNCTION__);
-                  return -1;
-                }
-              if (errno == EINTR)
-                continue;
-              g_warning ("%s: waitpid: %s",
-                         __FUNCTION__,
-                         strerror (errno));
-              return -1;
-            }
-          return 0;
-          break;
-        }
-    }
-
-  proctitle_set ("gvmd: Importing results");
-
-  /* Add the results. */
-
-  if (sql_int64 (&owner,
-                 "SELECT owner FROM tasks WHERE tasks.id = %llu",
-                 task))
-    {
-      g_warning ("%s: failed to get owner of task", __FUNCTION__);
-      return -1;
-    }
+  GString *insert, *insert_values;
+  int detail_count;
+  long long int values_before;
 
   sql_begin_immediate ();
   g_debug ("%s: add hosts", __FUNCTION__);
   index = 0;
   while ((start = (create_report_result_t*) g_ptr_array_index (host_starts,
                                                                index++)))
-    if (start->host && start->description)
+    if (start->host)
       manage_report_host_add (report, start->host,
-                              parse_iso_time (start->description),
+                              start->description
+                               ? parse_iso_time (start->description)
+                               : 0,
                               0);
 
   g_debug ("%s: add results", __FUNCTION__);
   insert = g_string_new ("");
+  insert_values = g_string_new ("");
   index = 0;
   first = 1;
   insert_count = 0;
@@ -22436,7 +23510,7 @@ create_report (array_t *results, const char *task_id, const char *task_name,
                          " (uuid, owner, date, task, host, hostname, port,"
                          "  nvt, type, description,"
                          "  nvt_version, severity, qod, qod_type, result_nvt,"
-                         "  report)"
+                         "  report, host_inet)"
                          " VALUES");
       else
         g_string_append (insert, ", ");
@@ -22446,7 +23520,7 @@ create_report (array_t *results, const char *task_id, const char *task_name,
                               "  '%s', '%s', '%s', '%s', '%s', '%s', '%s',"
                               "  '%s', '%s',"
                               "  (SELECT id FROM result_nvts WHERE nvt = '%s'),"
-                              "  %llu)",
+                              "  %llu, host_inet ('%s'))",
                               owner,
                               task,
                               quoted_host,
@@ -22462,7 +23536,8 @@ create_report (array_t *results, const char *task_id, const char *task_name,
                               quoted_qod,
                               quoted_qod_type,
                               quoted_nvt_oid,
-                              report);
+                              report,
+                              quoted_host);
 
       /* Limit the number of results inserted at a time. */
       if (insert_count == CREATE_REPORT_INSERT_SIZE)
@@ -22504,12 +23579,6 @@ create_report (array_t *results, const char *task_id, const char *task_name,
       sql_begin_immediate ();
     }
 
-  sql ("INSERT INTO result_nvt_reports (result_nvt, report)"
-       " SELECT distinct result_nvt, %llu FROM results"
-       " WHERE results.report = %llu;",
-       report,
-       report);
-
   g_debug ("%s: add host ends", __FUNCTION__);
   index = 0;
   count = 0;
@@ -22550,12 +23619,16 @@ create_report (array_t *results, const char *task_id, const char *task_name,
   first = 1;
   count = 0;
   insert_count = 0;
+  detail_count = 0;
   g_string_truncate (insert, 0);
+  values_before = sql_int64_0 ("SELECT max (id)"
+                               " FROM report_host_detail_values;");
   while ((detail = (host_detail_t*) g_ptr_array_index (details, index++)))
     if (detail->ip && detail->name)
       {
         char *quoted_host, *quoted_source_name, *quoted_source_type;
         char *quoted_source_desc, *quoted_name, *quoted_value;
+        gchar *hash;
 
         quoted_host = sql_quote (detail->ip);
         quoted_source_type = sql_quote (detail->source_type ?: "");
@@ -22563,24 +23636,49 @@ create_report (array_t *results, const char *task_id, const char *task_name,
         quoted_source_desc = sql_quote (detail->source_desc ?: "");
         quoted_name = sql_quote (detail->name);
         quoted_value = sql_quote (detail->value ?: "");
-
+        hash = g_compute_checksum_for_string (G_CHECKSUM_MD5,
+                                              detail->value ?: "",
+                                              -1);
+
+        /* Each distinct value is stored once.  The UNION drops repeats
+         * within this batch, and the NOT EXISTS values that are already
+         * stored.  Both inserts run in the transaction, so the value sweep
+         * cannot remove a value before its rows refer to it. */
         if (first)
-          g_string_append (insert,
-                           "INSERT INTO report_host_details"
-                           " (report_host, source_type, source_name,"
-                           "  source_description, name, value)"
-                           " VALUES");
+          {
+            g_string_append_printf (insert_values,
+                                    "INSERT INTO report_host_detail_values"
+                                    " (hash, value)"
+                                    " SELECT hash, value"
+                                    " FROM (SELECT '%s' AS hash,"
+                                    "              '%s' AS value",
+                                    hash, quoted_value);
+            g_string_append (insert,
+                             "INSERT INTO report_host_detail_rows"
+                             " (report_host, source_type, source_name,"
+                             "  source_description, name, value_id)"
+                             " VALUES");
+          }
         else
-          g_string_append (insert, ", ");
+          {
+            g_string_append_printf (insert_values,
+                                    " UNION SELECT '%s', '%s'",
+                                    hash, quoted_value);
+            g_string_append (insert, ", ");
+          }
         first = 0;
+        detail_count++;
 
         g_string_append_printf (insert,
                                 " ((SELECT id FROM report_hosts"
                                 "   WHERE report = %llu AND host = '%s'),"
-                                "  '%s', '%s', '%s', '%s', '%s')",
+                                "  '%s', '%s', '%s', '%s',"
+                                "  (SELECT id FROM report_host_detail_values"
+                                "   WHERE hash = '%s' AND value = '%s'"
+                                "   LIMIT 1))",
                                 report, quoted_host, quoted_source_type,
                                 quoted_source_name, quoted_source_desc,
-                                quoted_name, quoted_value);
+                                quoted_name, hash, quoted_value);
 
         g_free (quoted_host);
         g_free (quoted_source_type);
@@ -22588,11 +23686,15 @@ create_report (array_t *results, const char *task_id, const char *task_name,
         g_free (quoted_source_desc);
         g_free (quoted_name);
         g_free (quoted_value);
+        g_free (hash);
 
         /* Limit the number of details inserted at a time. */
         if (insert_count == CREATE_REPORT_INSERT_SIZE)
           {
+            g_string_append (insert_values, REPORT_HOST_DETAIL_VALUES_NEW);
+            sql (insert_values->str);
             sql (insert->str);
+            g_string_truncate (insert_values, 0);
             g_string_truncate (insert, 0);
             count++;
             insert_count = 0;
@@ -22610,10 +23712,281 @@ create_report (array_t *results, const char *task_id, const char *task_name,
       }
 
   if (first == 0)
-    sql (insert->str);
+    {
+      g_string_append (insert_values, REPORT_HOST_DETAIL_VALUES_NEW);
+      sql (insert_values->str);
+      sql (insert->str);
+    }
+
+  g_debug ("%s: added %i host details with %lli new values",
+           __FUNCTION__, detail_count,
+           sql_int64_0 ("SELECT max (id) FROM report_host_detail_values;")
+           - values_before);
 
   sql_commit ();
   g_string_free (insert, TRUE);
+  g_string_free (insert_values, TRUE);
+}
+
+/**
+ * @brief Data for create_report_insert_binary.
+ */
+typedef struct
+{
+  report_t report;  ///< Report.
+  task_t task;      ///< Task of report.
+  user_t owner;     ///< Owner of task.
+} create_report_insert_t;
+
+/**
+ * @brief Insert a block of a binary report into an uploaded report.
+ *
+ * @param[in]   results       Array of create_report_result_t pointers.
+ * @param[in]   host_starts   Array of create_report_result_t host starts.
+ * @param[in]   host_ends     Array of create_report_result_t host ends.
+ * @param[in]   details       Array of host_detail_t pointers.
+ * @param[in]   data          create_report_insert_t.
+ *
+ * @return 0.
+ */
+static int
+create_report_insert_binary (array_t *results, array_t *host_starts,
+                             array_t *host_ends, array_t *details, void *data)
+{
+  create_report_insert_t *insert;
+
+  insert = (create_report_insert_t *) data;
+  create_report_insert (insert->report, insert->task, insert->owner,
+                        results, host_starts, host_ends, details);
+  return 0;
+}
+
+/**
+ * @brief Create a report from an array of results.
+ *
+ * @param[in]   results       Array of create_report_result_t pointers.
+ * @param[in]   binary        Path of binary report from
+ *                            report_binary_reader_finish, or NULL.  Removed
+ *                            once imported.
+ * @param[in]   binary_results  Number of results in binary report.
+ * @param[in]   task_id       UUID of container task, or NULL to create new one.
+ * @param[in]   task_name     Name for container task.
+ * @param[in]   task_comment  Comment for container task.
+ * @param[in]   in_assets     Whether to create assets from the report.
+ * @param[in]   scan_start    Scan start time text.
+ * @param[in]   scan_end      Scan end time text.
+ * @param[in]   host_starts   Array of create_report_result_t pointers.  Host
+ *                            name in host, time in description.
+ * @param[in]   host_ends     Array of create_report_result_t pointers.  Host
+ *                            name in host, time in description.
+ * @param[in]   details       Array of host_detail_t pointers.
+ * @param[out]  report_id     Report ID.
+ *
+ * @return 0 success, 99 permission denied, -1 error, -2 failed to generate ID,
+ *         -3 task_name is NULL, -4 failed to find task, -5 task must be
+ *         container, -6 permission to create assets denied.
+ */
+int
+create_report (array_t *results, const gchar *binary, int binary_results,
+               const char *task_id, const char *task_name,
+               const char *task_comment, const char *in_assets,
+               const char *scan_start, const char *scan_end,
+               array_t *host_starts, array_t *host_ends, array_t *details,
+               char **report_id)
+{
+  int in_assets_int;
+  report_t report;
+  user_t owner;
+  task_t task;
+  pid_t pid;
+
+  in_assets_int
+    = (in_assets && strcmp (in_assets, "") && strcmp (in_assets, "0"));
+
+  if (in_assets_int && acl_user_may ("create_asset") == 0)
+    return -6;
+
+  g_debug ("%s", __FUNCTION__);
+
+  if (acl_user_may ("create_report") == 0)
+    return 99;
+
+  if (task_id == NULL && task_name == NULL)
+    return -3;
+
+  /* Find or create the task. */
+
+  sql_begin_immediate ();
+  if (task_id)
+    {
+      int rc = 0;
+
+      /* It's important that the task is not in the trash, because we
+       * are inserting results below.  This find function will fail if
+       * the task is in the trash. */
+      if (find_task_with_permission (task_id, &task, "modify_task"))
+        rc = -1;
+      else if (task == 0)
+        rc = -4;
+      else if (task_target (task))
+        rc = -5;
+      if (rc)
+        {
+          sql_rollback ();
+          return rc;
+        }
+    }
+  else
+    {
+      if (acl_user_may ("create_task") == 0)
+        {
+          sql_rollback ();
+          return 99;
+        }
+
+      task = make_task (g_strdup (task_name),
+                        task_comment ? g_strdup (task_comment) : NULL,
+                        1,  /* Include in assets. */
+                        1); /* Log and generate event. */
+    }
+
+  /* Generate report UUID. */
+
+  *report_id = gvm_uuid_make ();
+  if (*report_id == NULL) return -2;
+
+  /* Create the report. */
+
+  report = make_report (task, *report_id, TASK_STATUS_RUNNING);
+
+  if (scan_start)
+    {
+      sql ("UPDATE reports SET start_time = %i WHERE id = %llu;",
+           parse_iso_time (scan_start),
+           report);
+    }
+
+  if (scan_end)
+    {
+      sql ("UPDATE reports SET end_time = %i WHERE id = %llu;",
+           parse_iso_time (scan_end),
+           report);
+    }
+
+  /* Show that the upload has started. */
+
+  set_task_run_status (task, TASK_STATUS_RUNNING);
+  sql ("UPDATE tasks SET upload_result_count = %llu WHERE id = %llu;",
+       results->len + binary_results,
+       task);
+  sql_commit ();
+
+  /* Fork a child to import the results while the parent responds to the
+   * client. */
+
+  pid = fork ();
+  switch (pid)
+    {
+      case 0:
+        {
+          /* Child.
+           *
+           * Fork again so the parent can wait on the child, to prevent
+           * zombies. */
+          cleanup_manage_process (FALSE);
+          pid = fork ();
+          switch (pid)
+            {
+              case 0:
+                /* Grandchild.  Reopen the database (required after fork) and carry on
+                 * to import the reports, . */
+                reinit_manage_process ();
+                break;
+              case -1:
+                /* Grandchild's parent when error. */
+                g_warning ("%s: fork: %s", __FUNCTION__, strerror (errno));
+                exit (EXIT_FAILURE);
+                break;
+              default:
+                /* Grandchild's parent.  Exit, to close parent's wait. */
+                g_debug ("%s: %i forked %i", __FUNCTION__, getpid (), pid);
+                exit (EXIT_SUCCESS);
+                break;
+            }
+        }
+        break;
+      case -1:
+        /* Parent when error. */
+        g_warning ("%s: fork: %s", __FUNCTION__, strerror (errno));
+        global_current_report = report;
+        set_task_interrupted (task,
+                              "Failed to fork child to import report."
+                              "  Setting task status to Interrupted.");
+        global_current_report = 0;
+        return -1;
+        break;
+      default:
+        {
+          int status;
+
+          /* Parent.  Wait to prevent zombie, then return to respond to client. */
+          g_debug ("%s: %i forked %i", __FUNCTION__, getpid (), pid);
+          while (waitpid (pid, &status, 0) < 0)
+            {
+              if (errno == ECHILD)
+                {
+                  g_warning ("%s: Failed to get child exit status",
+                             __FUNCTION__);
+                  return -1;
+                }
+              if (errno == EINTR)
+                continue;
+              g_warning ("%s: waitpid: %s",
+                         __FUNCTION__,
+                         strerror (errno));
+              return -1;
+            }
+          return 0;
+          break;
+        }
+    }
+
+  proctitle_set ("gvmd: Importing results");
+
+  /* Add the results. */
+
+  if (sql_int64 (&owner,
+                 "SELECT owner FROM tasks WHERE tasks.id = %llu",
+                 task))
+    {
+      g_warning ("%s: failed to get owner of task", __FUNCTION__);
+      return -1;
+    }
+
+  create_report_insert (report, task, owner, results, host_starts, host_ends,
+                        details);
+
+  if (binary)
+    {
+      create_report_insert_t insert;
+
+      g_debug ("%s: add binary report", __FUNCTION__);
+      insert.report = report;
+      insert.task = task;
+      insert.owner = owner;
+      if (report_binary_import (binary, create_report_insert_binary,
+                                &insert))
+        g_warning ("%s: failed to import all of binary report",
+                   __FUNCTION__);
+      unlink (binary);
+    }
+
+  sql ("INSERT INTO result_nvt_reports (result_nvt, report)"
+       " SELECT distinct result_nvt, %llu FROM results"
+       " WHERE results.report = %llu;",
+       report,
+       report);
+
 
   current_scanner_task = task;
   global_current_report = report;
@@ -23657,6 +25030,27 @@ where_qod (int min_qod)
     "severity", "original_severity", "vulnerability", "date", "report_id",    \
     "solution_type", "qod", "qod_type", "task_id", "cve", "hostname", NULL }
 
+/**
+ * @brief SQL to check if a result may have notes or overrides.
+ *
+ * Split into an NVT wide and a result specific lookup, so that each can use
+ * an index of the table instead of scanning it for every result.
+ *
+ * @param[in]  table  "notes" or "overrides".
+ */
+#define RESULT_SQL_MAY_HAVE(table)                                            \
+  "(SELECT CASE"                                                              \
+  "        WHEN EXISTS (SELECT * FROM " table                                 \
+  "                     WHERE nvt = results.nvt"                              \
+  "                     AND result = 0"                                       \
+  "                     AND (task = 0 OR task = results.task))"               \
+  "             OR EXISTS (SELECT * FROM " table                              \
+  "                        WHERE result = results.id"                         \
+  "                        AND (task = 0 OR task = results.task))"            \
+  "        THEN 1"                                                            \
+  "        ELSE 0"                                                            \
+  "        END)"
+
 // TODO Combine with RESULT_ITERATOR_COLUMNS.
 /**
  * @brief Result iterator filterable columns, for severity only version .
@@ -23745,24 +25139,10 @@ where_qod (int min_qod)
       "             END)",                                                    \
       NULL,                                                                   \
       KEYWORD_TYPE_STRING },                                                  \
-    { "(SELECT CASE"                                                          \
-      "        WHEN EXISTS (SELECT * FROM notes"                              \
-      "                     WHERE (result = results.id"                       \
-      "                            OR (result = 0 AND nvt = results.nvt))"    \
-      "                     AND (task = 0 OR task = results.task))"           \
-      "        THEN 1"                                                        \
-      "        ELSE 0"                                                        \
-      "        END)",                                                         \
+    { RESULT_SQL_MAY_HAVE ("notes"),                                          \
       NULL,                                                                   \
       KEYWORD_TYPE_INTEGER },                                                 \
-    { "(SELECT CASE"                                                          \
-      "        WHEN EXISTS (SELECT * FROM overrides"                          \
-      "                     WHERE (result = results.id"                       \
-      "                            OR (result = 0 AND nvt = results.nvt))"    \
-      "                     AND (task = 0 OR task = results.task))"           \
-      "        THEN 1"                                                        \
-      "        ELSE 0"                                                        \
-      "        END)",                                                         \
+    { RESULT_SQL_MAY_HAVE ("overrides"),                                      \
       NULL,                                                                   \
       KEYWORD_TYPE_INTEGER },                                                 \
     { TICKET_SQL_RESULT_MAY_HAVE_TICKETS,                                     \
@@ -23909,24 +25289,10 @@ where_qod (int min_qod)
       "             END)",                                                    \
       NULL,                                                                   \
       KEYWORD_TYPE_STRING },                                                  \
-    { "(SELECT CASE"                                                          \
-      "        WHEN EXISTS (SELECT * FROM notes"                              \
-      "                     WHERE (result = results.id"                       \
-      "                            OR (result = 0 AND nvt = results.nvt))"    \
-      "                     AND (task = 0 OR task = results.task))"           \
-      "        THEN 1"                                                        \
-      "        ELSE 0"                                                        \
-      "        END)",                                                         \
+    { RESULT_SQL_MAY_HAVE ("notes"),                                          \
       NULL,                                                                   \
       KEYWORD_TYPE_INTEGER },                                                 \
-    { "(SELECT CASE"                                                          \
-      "        WHEN EXISTS (SELECT * FROM overrides"                          \
-      "                     WHERE (result = results.id"                       \
-      "                            OR (result = 0 AND nvt = results.nvt))"    \
-      "                     AND (task = 0 OR task = results.task))"           \
-      "        THEN 1"                                                        \
-      "        ELSE 0"                                                        \
-      "        END)",                                                         \
+    { RESULT_SQL_MAY_HAVE ("overrides"),                                      \
       NULL,                                                                   \
       KEYWORD_TYPE_INTEGER },                                                 \
     { TICKET_SQL_RESULT_MAY_HAVE_TICKETS,                                     \
@@ -24325,7 +25691,9 @@ init_result_get_iterator_severity (iterator_t* iterator, const get_data_t *get,
                                  report ? TRUE : FALSE,
                                  extra_order,
                                  with_clauses,
-                                 1);
+                                 1,
+                                 NULL,
+                                 NULL);
   table_order_if_sort_not_specified = 0;
   column_array_free (filterable_columns);
   g_free (with_clauses);
@@ -24404,6 +25772,111 @@ init_result_get_iterator (iterator_t* iterator, const get_data_t *get,
   return ret;
 }
 
+/**
+ * @brief Initialise an iterator over a page of the ports of report results.
+ *
+ * Gives each host and port pair of all the filtered results once, with the
+ * highest severity of the pair.  The pagination applies to the pairs, not
+ * to the results.
+ *
+ * @param[in]  iterator    Iterator.
+ * @param[in]  get         GET data.
+ * @param[in]  report      Report to restrict returned results to.
+ * @param[in]  first       First pair to return.  0 indexed.
+ * @param[in]  max         Maximum number of pairs to return, -1 for all.
+ * @param[in]  sort_order  Whether to sort ascending or descending.
+ * @param[in]  sort_field  Field to sort on.
+ *
+ * @return 0 success, 1 failed to find result, 2 failed to find filter (filt_id),
+ *         -1 error.
+ */
+static int
+init_result_port_iterator (iterator_t* iterator, const get_data_t *get,
+                           report_t report, int first, int max,
+                           int sort_order, const char *sort_field)
+{
+  static const char *filter_columns[] = RESULT_ITERATOR_FILTER_COLUMNS;
+  static column_t columns_no_cert[] = RESULT_ITERATOR_COLUMNS_NO_CERT;
+  int ret;
+  get_data_t get_all;
+  gchar *filter, *outer_clauses;
+  int autofp, apply_overrides, dynamic_severity;
+  gchar *extra_tables, *extra_where;
+
+  if (get->filt_id && strcmp (get->filt_id, FILT_ID_NONE))
+    {
+      filter = filter_term (get->filt_id);
+      if (filter == NULL)
+        return 2;
+    }
+  else
+    filter = NULL;
+
+  apply_overrides
+    = filter_term_apply_overrides (filter ? filter : get->filter);
+  autofp = filter_term_autofp (filter ? filter : get->filter);
+  dynamic_severity = setting_dynamic_severity_int ();
+
+  extra_tables
+    = result_iterator_opts_table (autofp, apply_overrides, dynamic_severity);
+
+  extra_where = results_extra_where (get->trash, report, NULL,
+                                     autofp, apply_overrides, dynamic_severity,
+                                     filter ? filter : get->filter);
+
+  free (filter);
+
+  if (sort_field && strcmp (sort_field, "port") == 0)
+    outer_clauses = g_strdup_printf (" GROUP BY host, location"
+                                     " ORDER BY location %s, host"
+                                     " LIMIT %s OFFSET %i",
+                                     sort_order ? "ASC" : "DESC",
+                                     sql_select_limit (max),
+                                     first);
+  else
+    outer_clauses = g_strdup_printf (" GROUP BY host, location"
+                                     " ORDER BY host, max_severity %s,"
+                                     "          location %s"
+                                     " LIMIT %s OFFSET %i",
+                                     sort_order ? "ASC" : "DESC",
+                                     sort_order ? "ASC" : "DESC",
+                                     sql_select_limit (max),
+                                     first);
+
+  /* Group all the filtered results, and paginate the pairs instead. */
+  get_all = *get;
+  get_all.ignore_pagination = 1;
+
+  /* The CERT columns are not needed for the ports, so always use the
+   * cheaper columns. */
+  ret = init_get_iterator2_with (iterator,
+                                 "result",
+                                 &get_all,
+                                 /* SELECT columns. */
+                                 columns_no_cert,
+                                 NULL,
+                                 /* Filterable columns not in SELECT columns. */
+                                 NULL,
+                                 NULL,
+                                 filter_columns,
+                                 0,
+                                 extra_tables,
+                                 extra_where,
+                                 TRUE,
+                                 report ? TRUE : FALSE,
+                                 NULL,
+                                 NULL,
+                                 0,
+                                 "host, location,"
+                                 " max (coalesce (severity, 0.0))"
+                                 " AS max_severity",
+                                 outer_clauses);
+  g_free (outer_clauses);
+  g_free (extra_tables);
+  g_free (extra_where);
+  return ret;
+}
+
 /**
  * @brief Count the number of results.
  *
@@ -24650,7 +26123,7 @@ DEF_ACCESS (result_iterator_original_type, GET_ITERATOR_COLUMN_COUNT + 3);
  * @return The type of the result.  Caller must only use before calling
  *         cleanup_iterator.
  */
-static const char*
+const char*
 result_iterator_type (iterator_t *iterator)
 {
   if (iterator->done) return NULL;
@@ -24753,7 +26226,7 @@ result_iterator_original_severity (iterator_t *iterator)
  * @return The severity of the result.  Caller must only use before calling
  *         cleanup_iterator.
  */
-static const char*
+const char*
 result_iterator_severity (iterator_t *iterator)
 {
   const char* ret;
@@ -25016,7 +26489,7 @@ init_report_host_iterator (iterator_t* iterator, report_t report, const char *ho
                        " FROM report_hosts WHERE id = %llu"
                        " AND report = %llu"
                        "%s%s%s"
-                       " ORDER BY order_inet (host);",
+                       " ORDER BY host_inet IS NULL, host_inet, host;",
                        report_host,
                        report,
                        host ? " AND host = '" : "",
@@ -25038,7 +26511,7 @@ init_report_host_iterator (iterator_t* iterator, report_t report, const char *ho
                        "              LIMIT 1))"
                        " FROM report_hosts WHERE report = %llu"
                        "%s%s%s"
-                       " ORDER BY order_inet (host);",
+                       " ORDER BY host_inet IS NULL, host_inet, host;",
                        report,
                        host ? " AND host = '" : "",
                        host ? host : "",
@@ -25054,7 +26527,7 @@ init_report_host_iterator (iterator_t* iterator, report_t report, const char *ho
                        " ''"
                        " FROM report_hosts WHERE id = %llu"
                        "%s%s%s"
-                       " ORDER BY order_inet (host);",
+                       " ORDER BY host_inet IS NULL, host_inet, host;",
                        report_host,
                        host ? " AND host = '" : "",
                        host ? host : "",
@@ -25067,7 +26540,7 @@ init_report_host_iterator (iterator_t* iterator, report_t report, const char *ho
                        " ''"
                        " FROM report_hosts"
                        "%s%s%s"
-                       " ORDER BY order_inet (host);",
+                       " ORDER BY host_inet IS NULL, host_inet, host;",
                        host ? " WHERE host = '" : "",
                        host ? host : "",
                        host ? "'" : "");
@@ -25082,7 +26555,7 @@ init_report_host_iterator (iterator_t* iterator, report_t report, const char *ho
  *
  * @return Report host.
  */
-static report_host_t
+report_host_t
 host_iterator_report_host (iterator_t* iterator)
 {
   if (iterator->done) return 0;
@@ -25321,7 +26794,7 @@ report_errors_iterator_result (iterator_t* iterator)
  * @param[in]  report_host  Report host whose details the iterator loops over.
  *                          All report_hosts if NULL.
  */
-static void
+void
 init_report_host_details_iterator (iterator_t* iterator,
                                    report_host_t report_host)
 {
@@ -25353,7 +26826,6 @@ init_report_host_details_iterator (iterator_t* iterator,
  * @return The name of the report host detail.  Caller must use only before
  *         calling cleanup_iterator.
  */
-static
 DEF_ACCESS (report_host_details_iterator_name, 1);
 
 /**
@@ -25364,7 +26836,6 @@ DEF_ACCESS (report_host_details_iterator_name, 1);
  * @return The value of the report host detail.  Caller must use only before
  *         calling cleanup_iterator.
  */
-static
 DEF_ACCESS (report_host_details_iterator_value, 2);
 
 /**
@@ -25375,7 +26846,6 @@ DEF_ACCESS (report_host_details_iterator_value, 2);
  * @return The source type of the report host detail.  Caller must use only
  *         before calling cleanup_iterator.
  */
-static
 DEF_ACCESS (report_host_details_iterator_source_type, 3);
 
 /**
@@ -25386,7 +26856,6 @@ DEF_ACCESS (report_host_details_iterator_source_type, 3);
  * @return The source name of the report host detail.  Caller must use only
  *         before calling cleanup_iterator.
  */
-static
 DEF_ACCESS (report_host_details_iterator_source_name, 4);
 
 /**
@@ -25397,7 +26866,6 @@ DEF_ACCESS (report_host_details_iterator_source_name, 4);
  * @return The source description of the report host detail.  Caller must use
  *         only before calling cleanup_iterator.
  */
-static
 DEF_ACCESS (report_host_details_iterator_source_desc, 5);
 
 /**
@@ -25719,7 +27187,7 @@ set_task_end_time_epoch (task_t task, time_t time)
  *
  * @return Start time of scan, in a newly allocated string.
  */
-static char*
+char*
 scan_start_time (report_t report)
 {
   char *time = sql_string ("SELECT iso_time (start_time)"
@@ -25808,7 +27276,7 @@ set_scan_start_time_otp (report_t report, const char* timestamp)
  *
  * @return End time of scan, in a newly allocated string.
  */
-static char*
+char*
 scan_end_time (report_t report)
 {
   char *time = sql_string ("SELECT iso_time (end_time)"
@@ -26619,6 +28087,157 @@ report_severity (report_t report, int overrides, int min_qod)
   return severity;
 }
 
+/**
+ * @brief Get the summary of a report for the current user.
+ *
+ * The summary is read from the task report summaries.  If it is missing it
+ * is calculated, and stored if the report is complete.
+ *
+ * @param[in]   report           Report.
+ * @param[in]   override         Whether to apply overrides.
+ * @param[in]   min_qod          Minimum QoD of results to count.
+ * @param[out]  holes            Number of hole messages.
+ * @param[out]  infos            Number of info messages.
+ * @param[out]  logs             Number of log messages.
+ * @param[out]  warnings         Number of warning messages.
+ * @param[out]  false_positives  Number of false positive messages.
+ * @param[out]  severity         Maximum severity score.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+report_summary (report_t report, int override, int min_qod, int *holes,
+                int *infos, int *logs, int *warnings, int *false_positives,
+                double *severity)
+{
+  iterator_t summaries;
+  get_data_t *get;
+  int found, end_time;
+
+  /* Summaries depend on the severity settings of the user, and are not
+   * stored for dynamic severity, like the report counts cache. */
+
+  if (current_credentials.uuid && strcmp (current_credentials.uuid, "")
+      && setting_dynamic_severity_int () == 0)
+    {
+      init_iterator (&summaries,
+                     "SELECT high, low, log, medium, false_positive,"
+                     "       severity"
+                     " FROM task_report_summaries"
+                     " WHERE report = %llu"
+                     "   AND override = %i"
+                     "   AND min_qod = %i"
+                     "   AND \"user\" = (SELECT id FROM users"
+                     "                   WHERE users.uuid = '%s')"
+                     "   AND (end_time = 0 OR end_time >= m_now ());",
+                     report, override, min_qod, current_credentials.uuid);
+      found = next (&summaries);
+      if (found)
+        {
+          *holes = iterator_int (&summaries, 0);
+          *infos = iterator_int (&summaries, 1);
+          *logs = iterator_int (&summaries, 2);
+          *warnings = iterator_int (&summaries, 3);
+          *false_positives = iterator_int (&summaries, 4);
+          *severity = iterator_double (&summaries, 5);
+        }
+      cleanup_iterator (&summaries);
+      if (found)
+        return 0;
+    }
+  else
+    found = -1;
+
+  /* Count the logs and false positives too, as report_counts_id is faster
+   * with all five. */
+  get = report_results_get_data (1, -1, override, 0, min_qod);
+  if (report_counts_id (report, NULL, holes, infos, logs, warnings,
+                        false_positives, severity, get, NULL))
+    {
+      get_data_reset (get);
+      free (get);
+      return -1;
+    }
+  get_data_reset (get);
+  free (get);
+
+  if (found == -1
+      || sql_int ("SELECT scan_run_status FROM reports WHERE id = %llu;",
+                  report)
+         != TASK_STATUS_DONE)
+    return 0;
+
+  /* Store the summary, valid until the first applied override expires. */
+
+  if (override)
+    end_time = sql_int ("SELECT coalesce (min (end_time), 0)"
+                        " FROM overrides, results"
+                        " WHERE overrides.nvt = results.nvt"
+                        " AND results.report = %llu"
+                        " AND overrides.end_time >= m_now ();",
+                        report);
+  else
+    end_time = 0;
+
+  sql ("DELETE FROM task_report_summaries"
+       " WHERE report = %llu"
+       "   AND override = %i"
+       "   AND min_qod = %i"
+       "   AND \"user\" = (SELECT id FROM users"
+       "                   WHERE users.uuid = '%s');",
+       report, override, min_qod, current_credentials.uuid);
+
+  sql ("INSERT INTO task_report_summaries"
+       " (task, report, \"user\", override, min_qod, date, high, medium, low,"
+       "  log, false_positive, severity, end_time)"
+       " SELECT task, id, (SELECT id FROM users WHERE users.uuid = '%s'),"
+       "        %i, %i, date, %i, %i, %i, %i, %i, %0.1f, %i"
+       " FROM reports WHERE id = %llu;",
+       current_credentials.uuid, override, min_qod, *holes, *warnings,
+       *infos, *logs, *false_positives, *severity, end_time, report);
+
+  return 0;
+}
+
+/**
+ * @brief Get the message counts for a report from the report summaries.
+ *
+ * Like report_counts, but reads the stored summary of the report when
+ * there is one.
+ *
+ * @param[in]   report_id    ID of report.
+ * @param[out]  debugs       Number of debug messages.  Always 0.
+ * @param[out]  holes        Number of hole messages.
+ * @param[out]  infos        Number of info messages.
+ * @param[out]  logs         Number of log messages.
+ * @param[out]  warnings     Number of warning messages.
+ * @param[out]  false_positives  Number of false positives.
+ * @param[out]  severity     Maximum severity score.
+ * @param[in]   override     Whether to override the threat.
+ * @param[in]   min_qod      Min QOD.
+ *
+ * @return 0 on success, -1 on error.
+ */
+int
+report_summary_counts (const char* report_id, int* debugs, int* holes,
+                       int* infos, int* logs, int* warnings,
+                       int* false_positives, double* severity,
+                       int override, int min_qod)
+{
+  report_t report;
+
+  if (find_report_with_permission (report_id, &report, "get_reports"))
+    return -1;
+  if (report == 0)
+    return -1;
+
+  if (debugs)
+    *debugs = 0;
+
+  return report_summary (report, override, min_qod, holes, infos, logs,
+                         warnings, false_positives, severity);
+}
+
 /**
  * @brief Delete a report.
  *
@@ -26633,6 +28252,7 @@ delete_report_internal (report_t report)
 {
   task_t task;
   char *slave_task_uuid;
+  gchar *where;
 
   if (sql_int ("SELECT count(*) FROM reports WHERE id = %llu"
                " AND (scan_run_status = %u OR scan_run_status = %u"
@@ -26696,9 +28316,9 @@ delete_report_internal (report_t report)
 
   /* Remove the report data. */
 
-  sql ("DELETE FROM report_host_details WHERE report_host IN"
-       " (SELECT id FROM report_hosts WHERE report = %llu);",
-       report);
+  where = g_strdup_printf ("report = %llu", report);
+  delete_report_host_details (where);
+  g_free (where);
   sql ("DELETE FROM report_hosts WHERE report = %llu;", report);
 
   sql ("DELETE FROM tag_resources"
@@ -26723,6 +28343,8 @@ delete_report_internal (report_t report)
        "   AND resource = %llu;",
        report);
   sql ("DELETE FROM report_counts WHERE report = %llu;", report);
+  sql ("DELETE FROM report_counts_refresh WHERE report = %llu;", report);
+  sql ("DELETE FROM task_report_summaries WHERE report = %llu;", report);
   sql ("DELETE FROM result_nvt_reports WHERE report = %llu;", report);
   sql ("DELETE FROM reports WHERE id = %llu;", report);
 
@@ -26966,22 +28588,27 @@ set_report_slave_task_uuid (report_t report, const char *uuid)
 void
 trim_report (report_t report)
 {
+  gchar *where;
+
   /* Remove results for all hosts. */
 
   sql ("DELETE FROM results WHERE id IN"
        " (SELECT results.id FROM results"
        "  WHERE results.report = %llu);",
        report);
+  sql ("UPDATE reports SET port_count = NULL WHERE id = %llu;", report);
 
   /* Remove all hosts and host details. */
 
-  sql ("DELETE FROM report_host_details WHERE report_host IN"
-       " (SELECT id FROM report_hosts WHERE report = %llu);",
-       report);
+  where = g_strdup_printf ("report = %llu", report);
+  delete_report_host_details (where);
+  g_free (where);
   sql ("DELETE FROM report_hosts"
        " WHERE report = %llu;",
        report);
 
+  report_cache_progress (report);
+
   /* Clear and rebuild counts cache */
   if (setting_auto_cache_rebuild_int ())
     report_cache_counts (report, 1, 1, NULL);
@@ -26997,6 +28624,8 @@ trim_report (report_t report)
 void
 trim_partial_report (report_t report)
 {
+  gchar *where;
+
   /* Remove results for partial hosts. */
 
   sql ("DELETE FROM results WHERE id IN"
@@ -27007,20 +28636,21 @@ trim_partial_report (report_t report)
        "  AND report_hosts.end_time = 0);",
        report,
        report);
+  sql ("UPDATE reports SET port_count = NULL WHERE id = %llu;", report);
 
   /* Remove partial hosts and host details. */
 
-  sql ("DELETE FROM report_host_details WHERE report_host IN"
-       " (SELECT report_hosts.id FROM report_hosts"
-       "  WHERE report_hosts.report = %llu"
-       "  AND report_hosts.end_time = 0);",
-       report);
+  where = g_strdup_printf ("report = %llu AND end_time = 0", report);
+  delete_report_host_details (where);
+  g_free (where);
 
   sql ("DELETE FROM report_hosts"
        " WHERE report = %llu"
        " AND end_time is NULL;",
        report);
 
+  report_cache_progress (report);
+
   /* Clear and rebuild counts cache */
   if (setting_auto_cache_rebuild_int ())
     report_cache_counts (report, 1, 1, NULL);
@@ -27028,182 +28658,6 @@ trim_partial_report (report_t report)
     report_clear_count_cache (report, 1, 1, NULL);
 }
 
-/**
- * @brief Compares two textual port representations, sorting descending
- * @brief by severity
- *
- * @param[in]  arg_one  First threat level.
- * @param[in]  arg_two  Second threat level.
- *
- * @return 1, 0 or -1 if first given severity is less than, equal to or greater
- *         than second.
- */
-static gint
-compare_severity_desc (gconstpointer arg_one, gconstpointer arg_two)
-{
-  double one_severity, two_severity;
-  gchar *one = *((gchar**) arg_one);
-  gchar *two = *((gchar**) arg_two);
-  gint host;
-
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  one_severity = g_strtod (one, NULL);
-  two_severity = g_strtod (two, NULL);
-
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  host = strcmp (one, two);
-  if (host == 0)
-    {
-      if (one_severity > two_severity)
-        return -1;
-      else if (one_severity < two_severity)
-        return 1;
-      else
-        {
-          one = *((gchar**) arg_one);
-          two = *((gchar**) arg_two);
-          return strcmp (two, one);
-        }
-    }
-  return host;
-}
-
-/**
- * @brief Compares two textual port representations, sorting descending
- * @brief by severity
- *
- * @param[in]  arg_one  First port.
- * @param[in]  arg_two  Second port.
- *
- * @return -1, 0 or 1 if first given severity is less than, equal to or greater
- *         than second.
- */
-static gint
-compare_severity_asc (gconstpointer arg_one, gconstpointer arg_two)
-{
-  double one_severity, two_severity;
-  gchar *one = *((gchar**) arg_one);
-  gchar *two = *((gchar**) arg_two);
-  gint host;
-
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  one_severity = g_strtod (one, NULL);
-  two_severity = g_strtod (two, NULL);
-
-  one += strlen (one) + 1;
-  two += strlen (two) + 1;
-  host = strcmp (one, two);
-  if (host == 0)
-    {
-      if (one_severity < two_severity)
-        return -1;
-      else if (one_severity > two_severity)
-        return 1;
-      else
-        {
-          one = *((gchar**) arg_one);
-          two = *((gchar**) arg_two);
-          return strcmp (one, two);
-        }
-    }
-  return host;
-}
-
-/**
- * @brief Some result info, for sorting.
- */
-struct result_buffer
-{
-  gchar *host;                  ///< Host.
-  gchar *port;                  ///< Port.
-  gchar *severity;              ///< Severity.
-  double severity_double;       ///< Severity.
-};
-
-/**
- * @brief Buffer host type.
- */
-typedef struct result_buffer result_buffer_t;
-
-/**
- * @brief Create a result buffer.
- *
- * @param[in]  host      Host.
- * @param[in]  port      Port.
- * @param[in]  severity  Severity.
- * @param[in]  severity_double  Severity.
- *
- * @return Freshly allocated result buffer.
- */
-static result_buffer_t*
-result_buffer_new (const gchar *host, const gchar *port, const gchar *severity,
-                   double severity_double)
-{
-  result_buffer_t *result_buffer;
-  result_buffer = g_malloc (sizeof (result_buffer_t));
-  result_buffer->host = g_strdup (host);
-  result_buffer->port = g_strdup (port);
-  result_buffer->severity = g_strdup (severity);
-  result_buffer->severity_double = severity_double;
-  return result_buffer;
-}
-
-/**
- * @brief Free a result buffer.
- *
- * @param[in]  result_buffer  Result buffer.
- */
-static void
-result_buffer_free (result_buffer_t *result_buffer)
-{
-  g_free (result_buffer->host);
-  g_free (result_buffer->port);
-  g_free (result_buffer->severity);
-  g_free (result_buffer);
-}
-
-/**
- * @brief Compares two buffered results, sorting by host, port then severity.
- *
- * @param[in]  arg_one  First result.
- * @param[in]  arg_two  Second result.
- *
- * @return -1, 0 or 1 if first given result is less than, equal to or greater
- *         than second.
- */
-static gint
-compare_port_severity (gconstpointer arg_one, gconstpointer arg_two)
-{
-  int host;
-  result_buffer_t *one, *two;
-
-  one = *((result_buffer_t**) arg_one);
-  two = *((result_buffer_t**) arg_two);
-
-  host = strcmp (one->host, two->host);
-  if (host == 0)
-    {
-      double severity_cmp;
-      int port;
-
-      port = strcmp (one->port, two->port);
-      if (port != 0)
-        return port;
-
-      severity_cmp = two->severity_double - one->severity_double;
-      if (severity_cmp > 0)
-        return 1;
-      else if (severity_cmp < 0)
-        return -1;
-      else
-        return 0;
-    }
-  return host;
-}
-
 /** @todo Defined in gmp.c! */
 void buffer_results_xml (GString *, iterator_t *, task_t, int, int, int,
                          int, int, int, int, const char *, iterator_t *,
@@ -28372,7 +29826,8 @@ report_result_host_count (report_t report, int min_qod)
 /**
  * @brief Count a report's total number of tcp/ip ports.
  *
- * Ignores port entries in "general/..." form.
+ * Ignores port entries in "general/..." form.  The count is kept in the
+ * report once the scan is over, and cleared when the report is trimmed.
  *
  * @param[in]  report  Report.
  *
@@ -28381,11 +29836,26 @@ report_result_host_count (report_t report, int min_qod)
 static int
 report_port_count (report_t report)
 {
-  return sql_int ("SELECT count (DISTINCT port) FROM results"
-                  " WHERE report = %llu AND port != ''"
-                  "  AND port NOT %s 'general/%';",
-                  report,
-                  sql_ilike_op ());
+  int count;
+
+  count = sql_int ("SELECT coalesce (port_count, -1) FROM reports"
+                   " WHERE id = %llu;",
+                   report);
+  if (count >= 0)
+    return count;
+
+  count = sql_int ("SELECT count (DISTINCT port) FROM results"
+                   " WHERE report = %llu AND port != ''"
+                   "  AND port NOT %s 'general/%';",
+                   report,
+                   sql_ilike_op ());
+
+  /* The results of an active report may still change. */
+  if (report_active (report) == 0)
+    sql ("UPDATE reports SET port_count = %i WHERE id = %llu;",
+         count, report);
+
+  return count;
 }
 
 /**
@@ -28910,114 +30380,25 @@ print_report_assets_xml (FILE *out, const char *host, int first_result, int
  * @param[in]  report           The report.
  * @param[in]  out              File stream.
  * @param[in]  get              Result get data.
- * @param[in]  first_result     The result to start from.  The results are 0
+ * @param[in]  first_result     The port to start from.  The ports are 0
  *                              indexed.
- * @param[in]  max_results      The maximum number of results returned.
+ * @param[in]  max_results      The maximum number of ports returned, -1 for
+ *                              all.
  * @param[in]  sort_order       Whether to sort ascending or descending.
  * @param[in]  sort_field       Field to sort on.
- * @param[out] host_ports       Hash table for counting ports per host.
  *
  * @return 0 on success, -1 error.
  */
 static int
 print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
                        int first_result, int max_results,
-                       int sort_order, const char *sort_field,
-                       GHashTable *host_ports)
+                       int sort_order, const char *sort_field)
 {
-  iterator_t results;
-  result_buffer_t *last_item;
-  GArray *ports = g_array_new (TRUE, FALSE, sizeof (gchar*));
-
-  init_result_get_iterator (&results, get, report, NULL, NULL);
-
-  /* Buffer the results, removing duplicates. */
-
-  last_item = NULL;
-  while (next (&results))
-    {
-      const char *port = result_iterator_port (&results);
-      const char *host = result_iterator_host (&results);
-      double cvss_double;
-
-      cvss_double = result_iterator_severity_double (&results);
-
-      if (last_item
-          && strcmp (port, last_item->port) == 0
-          && strcmp (host, last_item->host) == 0
-          && last_item->severity_double <= cvss_double)
-        {
-          last_item->severity_double = cvss_double;
-          g_free (last_item->severity);
-          last_item->severity = g_strdup (result_iterator_severity (&results));
-        }
-      else
-        {
-          const char *cvss;
-          result_buffer_t *item;
-
-          cvss = result_iterator_severity (&results);
-          if (cvss == NULL)
-            {
-              cvss_double = 0.0;
-              cvss = "0.0";
-            }
-          item = result_buffer_new (host, port, cvss, cvss_double);
-          g_array_append_val (ports, item);
-          last_item = item;
-        }
-
-    }
-
-  /* Handle sorting by threat and ROWID. */
-
-  if (sort_field == NULL || strcmp (sort_field, "port"))
-    {
-      int index, length;
-
-      /** @todo Sort by ROWID if was requested. */
-
-      /* Sort by port then severity. */
-
-      g_array_sort (ports, compare_port_severity);
-
-      /* Remove duplicates. */
-
-      last_item = NULL;
-      for (index = 0, length = ports->len; index < length; index++)
-        {
-          result_buffer_t *item;
-
-          item = g_array_index (ports, result_buffer_t*, index);
-          if (last_item
-              && (strcmp (item->port, last_item->port) == 0)
-              && (strcmp (item->host, last_item->host) == 0))
-            {
-              if (item->severity_double > last_item->severity_double)
-                {
-                  gchar *severity;
-                  severity = last_item->severity;
-                  last_item->severity = item->severity;
-                  item->severity = severity;
-                  last_item->severity_double = item->severity_double;
-                }
-              g_array_remove_index (ports, index);
-              length = ports->len;
-              index--;
-            }
-          else
-            last_item = item;
-        }
-
-      /* Sort by severity. */
+  iterator_t ports;
 
-      if (sort_order)
-        g_array_sort (ports, compare_severity_asc);
-      else
-        g_array_sort (ports, compare_severity_desc);
-    }
-
-  /* Write to file from the buffer. */
+  if (init_result_port_iterator (&ports, get, report, first_result,
+                                 max_results, sort_order, sort_field))
+    return -1;
 
   PRINT (out,
            "<ports"
@@ -29028,39 +30409,29 @@ print_report_port_xml (report_t report, FILE *out, const get_data_t *get,
            first_result + 1,
            max_results,
            report_port_count (report));
-  {
-    result_buffer_t *item;
-    int index = 0;
-
-    while ((item = g_array_index (ports, result_buffer_t*, index++)))
-      {
-        int host_port_count
-              = GPOINTER_TO_INT (g_hash_table_lookup (host_ports, item->host));
+  while (next (&ports))
+    {
+      const char *host, *port;
+      double severity;
 
-        PRINT (out,
-               "<port>"
-               "<host>%s</host>"
-               "%s"
-               "<severity>%1.1f</severity>"
-               "<threat>%s</threat>"
-               "</port>",
-               item->host,
-               item->port,
-               item->severity_double,
-               severity_to_level (g_strtod (item->severity, NULL), 0));
+      host = iterator_string (&ports, 0);
+      port = iterator_string (&ports, 1);
+      severity = iterator_double (&ports, 2);
 
-        if (g_str_has_prefix(item->port, "general/") == FALSE)
-          {
-            g_hash_table_replace (host_ports,
-                                  g_strdup (item->host),
-                                  GINT_TO_POINTER (host_port_count + 1));
-          }
-        result_buffer_free (item);
-      }
-    g_array_free (ports, TRUE);
-  }
+      PRINT (out,
+             "<port>"
+             "<host>%s</host>"
+             "%s"
+             "<severity>%1.1f</severity>"
+             "<threat>%s</threat>"
+             "</port>",
+             host,
+             port,
+             severity,
+             severity_to_level (severity, 0));
+    }
+  cleanup_iterator (&ports);
   PRINT (out, "</ports>");
-  cleanup_iterator (&results);
 
   return 0;
 }
@@ -29089,6 +30460,127 @@ report_active (report_t report)
   return 0;
 }
 
+/**
+ * @brief Calculate the progress of a single report host.
+ *
+ * @param[in]  current_port  Port currently being scanned.
+ * @param[in]  max_port      Last port to be scanned, -1 if host is dead.
+ *
+ * @return Progress of host, between 0 and 100.
+ */
+static int
+report_host_progress (int current_port, int max_port)
+{
+  int progress;
+
+  if (max_port)
+    {
+      progress = (current_port * 100) / max_port;
+      if (progress < 0) progress = 0;
+      else if (progress > 100) progress = 100;
+    }
+  else
+    progress = current_port ? 100 : 0;
+
+  return progress;
+}
+
+/**
+ * @brief Recalculate the cached progress counters of a report.
+ *
+ * The counters are maintained incrementally by set_scan_ports, so this is
+ * only needed when report hosts are removed from a report.
+ *
+ * @param[in]  report  Report.
+ */
+static void
+report_cache_progress (report_t report)
+{
+  sql ("UPDATE reports"
+       " SET progress_sum"
+       "       = (SELECT coalesce (sum (CASE"
+       "                                WHEN max_port = -1"
+       "                                THEN 0"
+       "                                WHEN max_port IS NOT NULL"
+       "                                     AND max_port != 0"
+       "                                THEN (CASE"
+       "                                      WHEN current_port * 100"
+       "                                           / max_port"
+       "                                           > 100"
+       "                                      THEN 100"
+       "                                      WHEN current_port * 100"
+       "                                           / max_port"
+       "                                           < 0"
+       "                                      THEN 0"
+       "                                      ELSE current_port * 100"
+       "                                           / max_port"
+       "                                      END)"
+       "                                WHEN coalesce (current_port, 0) = 0"
+       "                                THEN 0"
+       "                                ELSE 100"
+       "                                END),"
+       "                           0)"
+       "          FROM report_hosts WHERE report = %llu),"
+       "     progress_dead"
+       "       = (SELECT count (*) FROM report_hosts"
+       "          WHERE report = %llu AND max_port = -1)"
+       " WHERE id = %llu;",
+       report,
+       report,
+       report);
+}
+
+/**
+ * @brief Get the maximum number of hosts a report can have.
+ *
+ * This is the number of hosts in the target of the report's task.  The value
+ * is cached in the report, so that the hosts only have to be counted once.
+ *
+ * @param[in]  report  Report.
+ * @param[in]  task    Report's task.
+ *
+ * @return Maximum number of hosts in target.
+ */
+static long
+report_max_hosts (report_t report, task_t task)
+{
+  target_t target;
+  char *hosts, *exclude_hosts, *cached;
+  long maximum_hosts;
+
+  cached = sql_string ("SELECT progress_max_hosts FROM reports"
+                       " WHERE id = %llu;",
+                       report);
+  if (cached)
+    {
+      maximum_hosts = atol (cached);
+      free (cached);
+      return maximum_hosts;
+    }
+
+  target = task_target (task);
+  if (task_target_in_trash (task))
+    {
+      hosts = target ? trash_target_hosts (target) : NULL;
+      exclude_hosts = target ? trash_target_exclude_hosts
+                                (target) : NULL;
+    }
+  else
+    {
+      hosts = target ? target_hosts (target) : NULL;
+      exclude_hosts = target ? target_exclude_hosts (target) : NULL;
+    }
+  maximum_hosts = hosts ? manage_count_hosts_max (hosts, exclude_hosts, 0) : 0;
+  g_free (hosts);
+  g_free (exclude_hosts);
+
+  sql ("UPDATE reports SET progress_max_hosts = %li WHERE id = %llu;",
+       maximum_hosts,
+       report);
+
+  return maximum_hosts;
+}
+
 /**
  * @brief Get progress for active report.
  *
@@ -29101,52 +30593,53 @@ report_active (report_t report)
 static int
 report_progress_active (report_t report, long maximum_hosts, gchar **hosts_xml)
 {
-  long total = 0, num_hosts = 0, dead_hosts = 0;
+  long total, dead_hosts;
   int total_progress;
-  iterator_t hosts;
-  GString *string;
-
-  string = g_string_new ("");
+  iterator_t counts;
 
-  init_report_host_iterator (&hosts, report, NULL, 0);
-  while (next (&hosts))
+  init_iterator (&counts,
+                 "SELECT coalesce (progress_sum, 0),"
+                 "       coalesce (progress_dead, 0)"
+                 " FROM reports WHERE id = %llu;",
+                 report);
+  if (next (&counts))
     {
-      unsigned int max_port, current_port;
-      long progress;
+      total = iterator_int64 (&counts, 0);
+      dead_hosts = iterator_int64 (&counts, 1);
+    }
+  else
+    total = dead_hosts = 0;
+  cleanup_iterator (&counts);
 
-      max_port = host_iterator_max_port (&hosts);
-      current_port = host_iterator_current_port (&hosts);
-      if (max_port)
-        {
-          if (max_port == -1)
-            dead_hosts++;
-          progress = (current_port * 100) / max_port;
-          if (progress < 0) progress = 0;
-          else if (progress > 100) progress = 100;
-        }
-      else
-        progress = current_port ? 100 : 0;
+  if (hosts_xml)
+    {
+      iterator_t hosts;
+      GString *string;
 
-      total += progress;
-      num_hosts++;
+      string = g_string_new ("");
 
-      if (hosts_xml)
+      init_report_host_iterator (&hosts, report, NULL, 0);
+      while (next (&hosts))
         g_string_append_printf (string,
                                 "<host_progress>"
                                 "<host>%s</host>"
-                                "%li"
+                                "%i"
                                 "</host_progress>",
                                 host_iterator_host (&hosts),
-                                progress);
+                                report_host_progress
+                                 (host_iterator_current_port (&hosts),
+                                  host_iterator_max_port (&hosts)));
+      cleanup_iterator (&hosts);
+
+      *hosts_xml = g_string_free (string, FALSE);
     }
-  cleanup_iterator (&hosts);
 
   total_progress = (maximum_hosts - dead_hosts)
                    ? (total / (maximum_hosts - dead_hosts)) : 0;
 
 #if 1
   g_debug ("   total: %li", total);
-  g_debug ("   num_hosts: %li", num_hosts);
+  g_debug ("   dead_hosts: %li", dead_hosts);
   g_debug ("   maximum_hosts: %li", maximum_hosts);
   g_debug ("   total_progress: %i", total_progress);
 #endif
@@ -29154,11 +30647,6 @@ report_progress_active (report_t report, long maximum_hosts, gchar **hosts_xml)
   if (total_progress == 0) total_progress = 1;
   else if (total_progress == 100) total_progress = 99;
 
-  if (hosts_xml)
-    *hosts_xml = g_string_free (string, FALSE);
-  else
-    g_string_free (string, TRUE);
-
   return total_progress;
 }
 
@@ -29174,10 +30662,7 @@ report_progress_active (report_t report, long maximum_hosts, gchar **hosts_xml)
 int
 report_progress (report_t report, task_t task, gchar **hosts_xml)
 {
-  target_t target;
-  char *hosts, *exclude_hosts;
   int progress;
-  long maximum_hosts;
 
   if (report == 0)
     {
@@ -29194,24 +30679,9 @@ report_progress (report_t report, task_t task, gchar **hosts_xml)
       return progress;
     }
 
-  target = task_target (task);
-  if (task_target_in_trash (task))
-    {
-      hosts = target ? trash_target_hosts (target) : NULL;
-      exclude_hosts = target ? trash_target_exclude_hosts
-                                (target) : NULL;
-    }
-  else
-    {
-      hosts = target ? target_hosts (target) : NULL;
-      exclude_hosts = target ? target_exclude_hosts (target) : NULL;
-    }
-  maximum_hosts = hosts ? manage_count_hosts_max (hosts, exclude_hosts, 0) : 0;
-  g_free (hosts);
-  g_free (exclude_hosts);
-
   if (report_active (report))
-    return report_progress_active (report, maximum_hosts, hosts_xml);
+    return report_progress_active (report, report_max_hosts (report, task),
+                                   hosts_xml);
 
   if (hosts_xml)
     *hosts_xml = g_strdup ("");
@@ -29324,6 +30794,47 @@ tz_revert (gchar *zone, char *tz, char *old_tz_override)
   return 0;
 }
 
+/**
+ * @brief Get the clean filter term of a report, with the report defaults.
+ *
+ * @param[in]  term  Filter term.
+ *
+ * @return Freshly allocated clean term, with min_qod and apply_overrides.
+ */
+static gchar *
+report_clean_filter_term (const gchar *term)
+{
+  gchar *clean, *term_value;
+
+  clean = manage_clean_filter (term);
+
+  term_value = filter_term_value (clean, "min_qod");
+  if (term_value == NULL)
+    {
+      gchar *new_filter;
+      new_filter = g_strdup_printf ("min_qod=%i %s",
+                                    MIN_QOD_DEFAULT,
+                                    clean);
+      g_free (clean);
+      clean = new_filter;
+    }
+  g_free (term_value);
+
+  term_value = filter_term_value (clean, "apply_overrides");
+  if (term_value == NULL)
+    {
+      gchar *new_filter;
+      new_filter = g_strdup_printf ("apply_overrides=%i %s",
+                                    APPLY_OVERRIDES_DEFAULT,
+                                    clean);
+      g_free (clean);
+      clean = new_filter;
+    }
+  g_free (term_value);
+
+  return clean;
+}
+
 /**
  * @brief Print the XML for a report to a file.
  *
@@ -29388,6 +30899,279 @@ host_summary_append (GString *host_summary_buffer, const char *host,
     }
 }
 
+/**
+ * @brief Maximum number of page results per insert.
+ */
+#define REPORT_PAGE_RESULTS_BATCH 500
+
+/**
+ * @brief Page results waiting to be inserted, as SQL VALUES rows.
+ */
+static GString *report_page_results_values = NULL;
+
+/**
+ * @brief Number of rows in report_page_results_values.
+ */
+static int report_page_results_count = 0;
+
+/**
+ * @brief Start collecting the results on the current page of a report.
+ *
+ * The results are kept in the temporary table report_page_results, in page
+ * order, so that the host sections can be counted in SQL.
+ */
+static void
+report_page_results_init ()
+{
+  sql ("CREATE TEMPORARY TABLE IF NOT EXISTS report_page_results"
+       " (id %s PRIMARY KEY, host text, level text, port text);",
+       sql_is_sqlite3 () ? "INTEGER" : "SERIAL");
+  sql ("DELETE FROM report_page_results;");
+
+  if (report_page_results_values == NULL)
+    report_page_results_values = g_string_new ("");
+  g_string_truncate (report_page_results_values, 0);
+  report_page_results_count = 0;
+}
+
+/**
+ * @brief Insert the page results that are waiting.
+ */
+static void
+report_page_results_flush ()
+{
+  if (report_page_results_count == 0)
+    return;
+
+  sql ("INSERT INTO report_page_results (host, level, port) VALUES %s;",
+       report_page_results_values->str);
+  g_string_truncate (report_page_results_values, 0);
+  report_page_results_count = 0;
+}
+
+/**
+ * @brief Add a result on the current page of a report.
+ *
+ * The results are inserted in batches of REPORT_PAGE_RESULTS_BATCH.  Call
+ * report_page_results_flush before reading report_page_results.
+ *
+ * @param[in]  host   Host of result.
+ * @param[in]  level  Level of result, or NULL to only record the host.
+ * @param[in]  port   Port of result, or NULL to leave out of port counts.
+ */
+static void
+report_page_results_add (const char *host, const char *level,
+                         const char *port)
+{
+  gchar *quoted_host, *quoted_level, *quoted_port;
+
+  quoted_host = sql_insert (host);
+  quoted_level = sql_insert (level);
+  quoted_port = sql_insert (port);
+  g_string_append_printf (report_page_results_values,
+                          "%s(%s, %s, %s)",
+                          report_page_results_count ? ", " : "",
+                          quoted_host,
+                          quoted_level,
+                          quoted_port);
+  g_free (quoted_host);
+  g_free (quoted_level);
+  g_free (quoted_port);
+
+  if (++report_page_results_count == REPORT_PAGE_RESULTS_BATCH)
+    report_page_results_flush ();
+}
+
+/**
+ * @brief Report host columns for the report page host iterator.
+ */
+#define REPORT_PAGE_HOST_COLUMNS                                      \
+  "report_hosts.id, report_hosts.host,"                               \
+  " iso_time (report_hosts.start_time),"                              \
+  " iso_time (report_hosts.end_time),"                                \
+  " report_hosts.current_port, report_hosts.max_port,"                \
+  " report_hosts.report,"                                             \
+  " (SELECT uuid FROM reports WHERE id = report_hosts.report),"       \
+  " (SELECT uuid FROM hosts"                                          \
+  "  WHERE id = (SELECT host FROM host_identifiers"                   \
+  "              WHERE source_type = 'Report Host'"                   \
+  "              AND name = 'ip'"                                     \
+  "              AND source_id = (SELECT uuid"                        \
+  "                               FROM reports"                       \
+  "                               WHERE id = report_hosts.report)"    \
+  "              AND value = report_hosts.host"                       \
+  "              LIMIT 1)),"                                          \
+  " coalesce (page.holes, 0), coalesce (page.warnings, 0),"           \
+  " coalesce (page.infos, 0), coalesce (page.logs, 0),"               \
+  " coalesce (page.false_positives, 0), coalesce (page.ports, 0)"
+
+/**
+ * @brief Page counts per host, from report_page_results.
+ */
+#define REPORT_PAGE_HOST_COUNTS                                       \
+  "(SELECT host, min (id) AS first,"                                  \
+  "        sum (CASE WHEN level = 'High' THEN 1 ELSE 0 END)"          \
+  "        AS holes,"                                                 \
+  "        sum (CASE WHEN level = 'Medium' THEN 1 ELSE 0 END)"        \
+  "        AS warnings,"                                              \
+  "        sum (CASE WHEN level = 'Low' THEN 1 ELSE 0 END)"           \
+  "        AS infos,"                                                 \
+  "        sum (CASE WHEN level = 'Log' THEN 1 ELSE 0 END)"           \
+  "        AS logs,"                                                  \
+  "        sum (CASE WHEN level = 'False Positive' THEN 1 ELSE 0 END)" \
+  "        AS false_positives,"                                       \
+  "        count (DISTINCT CASE WHEN port LIKE 'general/%%'"          \
+  "                        THEN NULL ELSE port END)"                  \
+  "        AS ports"                                                  \
+  " FROM report_page_results"                                         \
+  " GROUP BY host)"                                                   \
+  " AS page"
+
+/**
+ * @brief Initialise an iterator over the host sections of a report page.
+ *
+ * The iterator has the columns of the report host iterator, followed by the
+ * page counts of the host.
+ *
+ * With result_hosts_only the hosts are those of the results on the page, in
+ * the order in which they first appear on the page.  A host that is not in
+ * the report is taken from the delta report, if there is one.  Otherwise the
+ * hosts are all hosts of the report, in report host order.
+ *
+ * @param[in]  iterator           Iterator.
+ * @param[in]  report             Report.
+ * @param[in]  delta              Delta report, or 0.
+ * @param[in]  result_hosts_only  Whether to only include hosts with results.
+ */
+static void
+init_report_page_host_iterator (iterator_t *iterator, report_t report,
+                                report_t delta, int result_hosts_only)
+{
+  if (result_hosts_only)
+    init_iterator (iterator,
+                   "SELECT " REPORT_PAGE_HOST_COLUMNS
+                   " FROM " REPORT_PAGE_HOST_COUNTS
+                   " JOIN report_hosts"
+                   " ON report_hosts.id"
+                   "    = coalesce ((SELECT id FROM report_hosts"
+                   "                 WHERE report = %llu"
+                   "                 AND host = page.host"
+                   "                 LIMIT 1),"
+                   "                (SELECT id FROM report_hosts"
+                   "                 WHERE report = %llu"
+                   "                 AND host = page.host"
+                   "                 LIMIT 1))"
+                   " ORDER BY page.first;",
+                   report,
+                   delta);
+  else
+    init_iterator (iterator,
+                   "SELECT " REPORT_PAGE_HOST_COLUMNS
+                   " FROM report_hosts"
+                   " LEFT JOIN " REPORT_PAGE_HOST_COUNTS
+                   " ON page.host = report_hosts.host"
+                   " WHERE report_hosts.report = %llu"
+                   " ORDER BY report_hosts.host_inet IS NULL,"
+                   "          report_hosts.host_inet, report_hosts.host;",
+                   report);
+}
+
+/**
+ * @brief Print the XML for a single host of a report to a file.
+ *
+ * @param[in]  out                  File stream to write to.
+ * @param[in]  hosts                Report page host iterator.
+ * @param[in]  host_summary_buffer  Host summary, or NULL.
+ *
+ * @return 0 on success, -1 error.
+ */
+static int
+print_report_host_xml (FILE *out, iterator_t *hosts,
+                       GString *host_summary_buffer)
+{
+  int holes, warnings, infos, logs, false_positives;
+
+  holes = iterator_int (hosts, 9);
+  warnings = iterator_int (hosts, 10);
+  infos = iterator_int (hosts, 11);
+  logs = iterator_int (hosts, 12);
+  false_positives = iterator_int (hosts, 13);
+
+  host_summary_append (host_summary_buffer,
+                       host_iterator_host (hosts),
+                       host_iterator_start_time (hosts),
+                       host_iterator_end_time (hosts));
+  PRINT (out,
+         "<host>"
+         "<ip>%s</ip>"
+         "<asset asset_id=\"%s\"/>"
+         "<start>%s</start>"
+         "<end>%s</end>"
+         "<port_count><page>%d</page></port_count>"
+         "<result_count>"
+         "<page>%d</page>"
+         "<hole><page>%d</page></hole>"
+         "<warning><page>%d</page></warning>"
+         "<info><page>%d</page></info>"
+         "<log><page>%d</page></log>"
+         "<false_positive><page>%d</page></false_positive>"
+         "</result_count>",
+         host_iterator_host (hosts),
+         host_iterator_asset_uuid (hosts)
+           ? host_iterator_asset_uuid (hosts)
+           : "",
+         host_iterator_start_time (hosts),
+         host_iterator_end_time (hosts)
+           ? host_iterator_end_time (hosts)
+           : "",
+         iterator_int (hosts, 14),
+         holes + warnings + infos + logs + false_positives,
+         holes,
+         warnings,
+         infos,
+         logs,
+         false_positives);
+
+  if (print_report_host_details_xml (host_iterator_report_host (hosts), out))
+    return -1;
+
+  PRINT (out,
+         "</host>");
+
+  return 0;
+}
+
+/**
+ * @brief Print the XML for the hosts of a report to a file.
+ *
+ * Each host section is written as soon as the iterator reaches it, with the
+ * page counts taken from report_page_results.
+ *
+ * @param[in]  out                  File stream to write to.
+ * @param[in]  report               Report.
+ * @param[in]  delta                Delta report, or 0.
+ * @param[in]  result_hosts_only    Whether to only include hosts with results.
+ * @param[in]  host_summary_buffer  Host summary, or NULL.
+ *
+ * @return 0 on success, -1 error.
+ */
+static int
+print_report_hosts_xml (FILE *out, report_t report, report_t delta,
+                        int result_hosts_only, GString *host_summary_buffer)
+{
+  iterator_t hosts;
+
+  init_report_page_host_iterator (&hosts, report, delta, result_hosts_only);
+  while (next (&hosts))
+    if (print_report_host_xml (out, &hosts, host_summary_buffer))
+      {
+        cleanup_iterator (&hosts);
+        return -1;
+      }
+  cleanup_iterator (&hosts);
+  return 0;
+}
+
 /**
  * @brief Init delta iterators for print_report_xml.
  *
@@ -29526,7 +31310,6 @@ init_delta_iterators (report_t report, iterator_t *results, report_t delta,
  * @param[in]  f_warnings       Result count.
  * @param[in]  orig_f_false_positives  Result count.
  * @param[in]  f_false_positives       Result count.
- * @param[in]  result_hosts   Result hosts.
  *
  * @return 0 on success, -1 error.
  */
@@ -29544,8 +31327,7 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                         int *orig_f_infos, int *f_infos,
                         int *orig_f_logs, int *f_logs,
                         int *orig_f_warnings, int *f_warnings,
-                        int *orig_f_false_positives, int *f_false_positives,
-                        array_t *result_hosts)
+                        int *orig_f_false_positives, int *f_false_positives)
 {
   gboolean done, delta_done;
   int changed, gone, new, same;
@@ -29660,8 +31442,8 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                   return -1;
                 g_string_free (buffer, TRUE);
                 if (result_hosts_only)
-                  array_add_new_string (result_hosts,
-                                        result_iterator_host (delta_results));
+                  report_page_results_add (result_iterator_host (delta_results),
+                                           NULL, NULL);
                 add_port (ports, delta_results);
                 max_results--;
                 if (max_results == 0)
@@ -29706,8 +31488,8 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                   return -1;
                 g_string_free (buffer, TRUE);
                 if (result_hosts_only)
-                  array_add_new_string (result_hosts,
-                                        result_iterator_host (results));
+                  report_page_results_add (result_iterator_host (results),
+                                           NULL, NULL);
                 add_port (ports, results);
                 max_results--;
                 if (max_results == 0)
@@ -29857,8 +31639,8 @@ print_report_delta_xml (FILE *out, iterator_t *results,
           if (used)
             {
               if (result_hosts_only)
-                array_add_new_string (result_hosts,
-                                      result_iterator_host (results));
+                report_page_results_add (result_iterator_host (results),
+                                         NULL, NULL);
               add_port (ports, results);
             }
           done = !next (results);
@@ -29870,8 +31652,8 @@ print_report_delta_xml (FILE *out, iterator_t *results,
           if (used)
             {
               if (result_hosts_only)
-                array_add_new_string (result_hosts,
-                                      result_iterator_host (results));
+                report_page_results_add (result_iterator_host (results),
+                                         NULL, NULL);
               add_port (ports, results);
             }
           done = !next (results);
@@ -29942,9 +31724,8 @@ print_report_delta_xml (FILE *out, iterator_t *results,
                 }
 
               if (result_hosts_only)
-                array_add_new_string (result_hosts,
-                                      result_iterator_host
-                                       (delta_results));
+                report_page_results_add (result_iterator_host (delta_results),
+                                         NULL, NULL);
 
               add_port (ports, delta_results);
             }
@@ -30267,7 +32048,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   int min_qod_int;
   char *uuid, *tsk_uuid = NULL, *start_time, *end_time;
   int total_result_count, filtered_result_count;
-  array_t *result_hosts;
   iterator_t results, delta_results;
   int debugs, holes, infos, logs, warnings, false_positives;
   int f_debugs, f_holes, f_infos, f_logs, f_warnings, f_false_positives;
@@ -30278,10 +32058,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   gchar *tz, *zone;
   char *old_tz_override;
   GString *filters_buffer, *filters_extra_buffer, *host_summary_buffer;
-  gchar *term_value;
-  GHashTable *f_host_ports;
-  GHashTable *f_host_holes, *f_host_warnings, *f_host_infos;
-  GHashTable *f_host_logs, *f_host_false_positives;
   task_status_t run_status;
 
   /* Init some vars to prevent warnings from older compilers. */
@@ -30289,12 +32065,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   orig_filtered_result_count = 0;
   orig_f_false_positives = orig_f_warnings = orig_f_logs = orig_f_infos = 0;
   orig_f_holes = orig_f_debugs = 0;
-  f_host_ports = NULL;
-  f_host_holes = NULL;
-  f_host_warnings = NULL;
-  f_host_infos = NULL;
-  f_host_logs = NULL;
-  f_host_false_positives = NULL;
 
   /** @todo Leaks on error in PRINT and PRINT_XML.  The process normally exits
    *        then anyway. */
@@ -30552,34 +32322,9 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
       report_scan_run_status (report, &run_status);
     }
 
-  clean = manage_clean_filter (term
-                                ? term
-                                : (get->filter ? get->filter : ""));
-
-  term_value = filter_term_value (clean, "min_qod");
-  if (term_value == NULL)
-    {
-      gchar *new_filter;
-      new_filter = g_strdup_printf ("min_qod=%i %s",
-                                    MIN_QOD_DEFAULT,
-                                    clean);
-      g_free (clean);
-      clean = new_filter;
-    }
-  g_free (term_value);
-
-  term_value = filter_term_value (clean, "apply_overrides");
-  if (term_value == NULL)
-    {
-      gchar *new_filter;
-      new_filter = g_strdup_printf ("apply_overrides=%i %s",
-                                    APPLY_OVERRIDES_DEFAULT,
-                                    clean);
-      g_free (clean);
-      clean = new_filter;
-    }
-  g_free (term_value);
-
+  clean = report_clean_filter_term (term
+                                     ? term
+                                     : (get->filter ? get->filter : ""));
   g_free (term);
   term = clean;
 
@@ -30955,17 +32700,15 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
 
   /* Port summary. */
 
-  f_host_ports = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                        g_free, NULL);
-
   if (get->details && (delta == 0))
     {
-      if (print_report_port_xml (report, out, get, first_result, max_results,
-                                 sort_order, sort_field, f_host_ports))
+      if (print_report_port_xml (report, out, get,
+                                 ignore_pagination ? 0 : first_result,
+                                 ignore_pagination ? -1 : max_results,
+                                 sort_order, sort_field))
         {
           g_free (term);
           tz_revert (zone, tz, old_tz_override);
-          g_hash_table_destroy (f_host_ports);
           return -1;
         }
     }
@@ -30989,7 +32732,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
                                 term, sort_field))
         {
           g_free (term);
-          g_hash_table_destroy (f_host_ports);
           return -1;
         }
       g_free (term);
@@ -31000,10 +32742,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
       g_free (term);
       res = init_result_get_iterator (&results, get, report, NULL, NULL);
       if (res)
-        {
-          g_hash_table_destroy (f_host_ports);
-          return -1;
-        }
+        return -1;
     }
   else
     g_free (term);
@@ -31016,22 +32755,9 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
              /* Add 1 for 1 indexing. */
              ignore_pagination ? 1 : first_result + 1,
              ignore_pagination ? -1 : max_results);
-  if (get->details && result_hosts_only)
-    result_hosts = make_array ();
-  else
-    /* Quiet erroneous compiler warning. */
-    result_hosts = NULL;
-
-  f_host_holes = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                        g_free, NULL);
-  f_host_warnings = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                           g_free, NULL);
-  f_host_infos = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                      g_free, NULL);
-  f_host_logs = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                      g_free, NULL);
-  f_host_false_positives = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                  g_free, NULL);
+
+  if (get->details)
+    report_page_results_init ();
 
   if (delta && get->details)
     {
@@ -31046,8 +32772,7 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
                                   &orig_f_infos, &f_infos,
                                   &orig_f_logs, &f_logs,
                                   &orig_f_warnings, &f_warnings,
-                                  &orig_f_false_positives, &f_false_positives,
-                                  result_hosts))
+                                  &orig_f_false_positives, &f_false_positives))
         {
           fclose (out);
           g_free (sort_field);
@@ -31058,12 +32783,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
           cleanup_iterator (&results);
           cleanup_iterator (&delta_results);
           tz_revert (zone, tz, old_tz_override);
-          g_hash_table_destroy (f_host_ports);
-          g_hash_table_destroy (f_host_holes);
-          g_hash_table_destroy (f_host_warnings);
-          g_hash_table_destroy (f_host_infos);
-          g_hash_table_destroy (f_host_logs);
-          g_hash_table_destroy (f_host_false_positives);
 
           return -1;
         }
@@ -31075,8 +32794,6 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
       cert_loaded = manage_cert_loaded ();
       while (next (&results))
         {
-          const char* level;
-          GHashTable *f_host_result_counts;
           GString *buffer = g_string_new ("");
 
           buffer_results_xml (buffer,
@@ -31095,36 +32812,9 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
                               cert_loaded);
           PRINT_XML (out, buffer->str);
           g_string_free (buffer, TRUE);
-          if (result_hosts_only)
-            array_add_new_string (result_hosts,
-                                  result_iterator_host (&results));
-
-          level = result_iterator_level (&results);
-          if (strcasecmp (level, "log") == 0)
-            f_host_result_counts = f_host_logs;
-          else if (strcasecmp (level, "high") == 0)
-            f_host_result_counts = f_host_holes;
-          else if (strcasecmp (level, "medium") == 0)
-            f_host_result_counts = f_host_warnings;
-          else if (strcasecmp (level, "low") == 0)
-            f_host_result_counts = f_host_infos;
-          else if (strcasecmp (level, "false positive") == 0)
-            f_host_result_counts = f_host_false_positives;
-          else
-            f_host_result_counts = NULL;
-
-          if (f_host_result_counts)
-            {
-              const char *result_host = result_iterator_host (&results);
-              int result_count
-                    = GPOINTER_TO_INT
-                        (g_hash_table_lookup (f_host_result_counts, result_host));
-
-              g_hash_table_replace (f_host_result_counts,
-                                    g_strdup (result_host),
-                                    GINT_TO_POINTER (result_count + 1));
-            }
-
+          report_page_results_add (result_iterator_host (&results),
+                                   result_iterator_level (&results),
+                                   result_iterator_port (&results));
         }
       PRINT (out, "</results>");
     }
@@ -31196,6 +32886,10 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
              "</severity>",
              severity,
              f_severity);
+
+      PRINT (out,
+             "<counts_refreshing>%i</counts_refreshing>",
+             report_counts_refreshing (report));
     }
 
   if (host_summary)
@@ -31208,204 +32902,21 @@ print_report_xml_start (report_t report, report_t delta, task_t task,
   else
     host_summary_buffer = NULL;
 
-  if (get->details && result_hosts_only)
-    {
-      gchar *result_host;
-      int index = 0;
-      array_terminate (result_hosts);
-      while ((result_host = g_ptr_array_index (result_hosts, index++)))
-        {
-          gboolean present;
-          iterator_t hosts;
-          init_report_host_iterator (&hosts, report, result_host, 0);
-          present = next (&hosts);
-          if (delta && (present == FALSE))
-            {
-              cleanup_iterator (&hosts);
-              init_report_host_iterator (&hosts, delta, result_host, 0);
-              present = next (&hosts);
-            }
-          if (present)
-            {
-              const char *current_host;
-              int ports_count;
-              int holes_count, warnings_count, infos_count;
-              int logs_count, false_positives_count;
-
-              current_host = host_iterator_host (&hosts);
-
-              ports_count
-                = GPOINTER_TO_INT
-                    (g_hash_table_lookup (f_host_ports, current_host));
-              holes_count
-                = GPOINTER_TO_INT
-                    (g_hash_table_lookup ( f_host_holes, current_host));
-              warnings_count
-                = GPOINTER_TO_INT
-                    (g_hash_table_lookup ( f_host_warnings, current_host));
-              infos_count
-                = GPOINTER_TO_INT
-                    (g_hash_table_lookup ( f_host_infos, current_host));
-              logs_count
-                = GPOINTER_TO_INT
-                    (g_hash_table_lookup ( f_host_logs, current_host));
-              false_positives_count
-                = GPOINTER_TO_INT
-                    (g_hash_table_lookup ( f_host_false_positives, current_host));
-
-              host_summary_append (host_summary_buffer,
-                                   result_host,
-                                   host_iterator_start_time (&hosts),
-                                   host_iterator_end_time (&hosts));
-              PRINT (out,
-                     "<host>"
-                     "<ip>%s</ip>"
-                     "<asset asset_id=\"%s\"/>"
-                     "<start>%s</start>"
-                     "<end>%s</end>"
-                     "<port_count><page>%d</page></port_count>"
-                     "<result_count>"
-                     "<page>%d</page>"
-                     "<hole><page>%d</page></hole>"
-                     "<warning><page>%d</page></warning>"
-                     "<info><page>%d</page></info>"
-                     "<log><page>%d</page></log>"
-                     "<false_positive><page>%d</page></false_positive>"
-                     "</result_count>",
-                     result_host,
-                     host_iterator_asset_uuid (&hosts)
-                       ? host_iterator_asset_uuid (&hosts)
-                       : "",
-                     host_iterator_start_time (&hosts),
-                     host_iterator_end_time (&hosts)
-                       ? host_iterator_end_time (&hosts)
-                       : "",
-                     ports_count,
-                     (holes_count + warnings_count + infos_count
-                      + logs_count + false_positives_count),
-                     holes_count,
-                     warnings_count,
-                     infos_count,
-                     logs_count,
-                     false_positives_count);
-
-              if (print_report_host_details_xml
-                   (host_iterator_report_host (&hosts), out))
-                {
-                  tz_revert (zone, tz, old_tz_override);
-                  if (host_summary_buffer)
-                    g_string_free (host_summary_buffer, TRUE);
-                  g_hash_table_destroy (f_host_ports);
-                  g_hash_table_destroy (f_host_holes);
-                  g_hash_table_destroy (f_host_warnings);
-                  g_hash_table_destroy (f_host_infos);
-                  g_hash_table_destroy (f_host_logs);
-                  g_hash_table_destroy (f_host_false_positives);
-                  return -1;
-                }
+  if (get->details)
+    report_page_results_flush ();
 
-              PRINT (out,
-                     "</host>");
-            }
-          cleanup_iterator (&hosts);
-        }
-      array_free (result_hosts);
-    }
-  else if (get->details)
+  if (get->details
+      && print_report_hosts_xml (out, report, delta, result_hosts_only,
+                                 host_summary_buffer))
     {
-      iterator_t hosts;
-      init_report_host_iterator (&hosts, report, NULL, 0);
-      while (next (&hosts))
-        {
-          const char *current_host;
-          int ports_count;
-          int holes_count, warnings_count, infos_count;
-          int logs_count, false_positives_count;
-
-          current_host = host_iterator_host (&hosts);
-
-          ports_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_ports, current_host));
-          holes_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_holes, current_host));
-          warnings_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_warnings, current_host));
-          infos_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_infos, current_host));
-          logs_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_logs, current_host));
-          false_positives_count
-            = GPOINTER_TO_INT
-                (g_hash_table_lookup (f_host_false_positives, current_host));
-
-          host_summary_append (host_summary_buffer,
-                               host_iterator_host (&hosts),
-                               host_iterator_start_time (&hosts),
-                               host_iterator_end_time (&hosts));
-          PRINT (out,
-                 "<host>"
-                 "<ip>%s</ip>"
-                 "<asset asset_id=\"%s\"/>"
-                 "<start>%s</start>"
-                 "<end>%s</end>"
-                 "<port_count><page>%d</page></port_count>"
-                 "<result_count>"
-                 "<page>%d</page>"
-                 "<hole><page>%d</page></hole>"
-                 "<warning><page>%d</page></warning>"
-                 "<info><page>%d</page></info>"
-                 "<log><page>%d</page></log>"
-                 "<false_positive><page>%d</page></false_positive>"
-                 "</result_count>",
-                 host_iterator_host (&hosts),
-                 host_iterator_asset_uuid (&hosts)
-                   ? host_iterator_asset_uuid (&hosts)
-                   : "",
-                 host_iterator_start_time (&hosts),
-                 host_iterator_end_time (&hosts)
-                   ? host_iterator_end_time (&hosts)
-                   : "",
-                 ports_count,
-                 (holes_count + warnings_count + infos_count
-                  + logs_count + false_positives_count),
-                 holes_count,
-                 warnings_count,
-                 infos_count,
-                 logs_count,
-                 false_positives_count);
-
-          if (print_report_host_details_xml
-               (host_iterator_report_host (&hosts), out))
-            {
-              tz_revert (zone, tz, old_tz_override);
-              if (host_summary_buffer)
-                g_string_free (host_summary_buffer, TRUE);
-              g_hash_table_destroy (f_host_ports);
-              g_hash_table_destroy (f_host_holes);
-              g_hash_table_destroy (f_host_warnings);
-              g_hash_table_destroy (f_host_infos);
-              g_hash_table_destroy (f_host_logs);
-              g_hash_table_destroy (f_host_false_positives);
-              return -1;
-            }
-
-          PRINT (out,
-                 "</host>");
-        }
-      cleanup_iterator (&hosts);
+      tz_revert (zone, tz, old_tz_override);
+      if (host_summary_buffer)
+        g_string_free (host_summary_buffer, TRUE);
+      return -1;
     }
 
-  g_hash_table_destroy (f_host_ports);
-  g_hash_table_destroy (f_host_holes);
-  g_hash_table_destroy (f_host_warnings);
-  g_hash_table_destroy (f_host_infos);
-  g_hash_table_destroy (f_host_logs);
-  g_hash_table_destroy (f_host_false_positives);
+  if (get->details)
+    sql ("DELETE FROM report_page_results;");
 
   end_time = scan_end_time (report);
   PRINT (out,
@@ -31496,6 +33007,57 @@ print_report_xml_end (gchar *xml_start, gchar *xml_full,
   return 0;
 }
 
+/**
+ * @brief Get the filter term and timezone that a binary report was made with.
+ *
+ * These are the values that print_report_xml_start returns for XML reports.
+ *
+ * @param[in]  get                 GET data for report.
+ * @param[out] filter_term_return  NULL or location for filter term.
+ * @param[out] zone_return         NULL or location for timezone.
+ *
+ * @return 0 success, -1 failed to find filter.
+ */
+static int
+report_binary_filter_returns (const get_data_t *get,
+                              gchar **filter_term_return, gchar **zone_return)
+{
+  gchar *term, *clean;
+
+  if (get->filt_id && strlen (get->filt_id)
+      && strcmp (get->filt_id, FILT_ID_NONE))
+    {
+      term = filter_term (get->filt_id);
+      if (term == NULL)
+        return -1;
+    }
+  else
+    term = g_strdup (get->filter ? get->filter : "");
+
+  clean = report_clean_filter_term (term);
+  g_free (term);
+
+  if (zone_return)
+    {
+      gchar *zone;
+
+      zone = filter_term_value (clean, "timezone");
+      if (zone == NULL || strlen (zone) == 0)
+        {
+          g_free (zone);
+          zone = setting_timezone ();
+        }
+      *zone_return = zone ? zone : g_strdup ("");
+    }
+
+  if (filter_term_return)
+    *filter_term_return = clean;
+  else
+    g_free (clean);
+
+  return 0;
+}
+
 /**
  * @brief Generate a report.
  *
@@ -31554,35 +33116,56 @@ manage_report (report_t report, report_t delta_report, const get_data_t *get,
       return NULL;
     }
 
-  xml_start = g_strdup_printf ("%s/report-start.xml", xml_dir);
-  ret = print_report_xml_start (report, delta_report, task, xml_start, get,
-                                type, notes_details, overrides_details,
-                                1 /* result_tags */,
-                                NULL, 0, NULL, NULL, 0, 0, /* host params */
-                                0 /* ignore_pagination */,
-                                filter_term_return, zone_return, host_summary);
-  if (ret)
+  report_format_id = report_format_uuid (report_format);
+
+  if (report_format_id
+      && strcmp (report_format_id, REPORT_BINARY_FORMAT_UUID) == 0)
     {
-      g_free (xml_start);
-      gvm_file_remove_recurse (xml_dir);
-      return NULL;
+      /* Binary reports are written straight from the database, without
+       * generating the XML report. */
+      output_file = g_strdup_printf ("%s/report.gvmb", xml_dir);
+      if (report_binary_write (report, get, output_file)
+          || report_binary_filter_returns (get, filter_term_return,
+                                           zone_return))
+        {
+          g_free (output_file);
+          output_file = NULL;
+        }
     }
+  else
+    {
+      xml_start = g_strdup_printf ("%s/report-start.xml", xml_dir);
+      ret = print_report_xml_start (report, delta_report, task, xml_start,
+                                    get, type, notes_details,
+                                    overrides_details,
+                                    1 /* result_tags */,
+                                    NULL, 0, NULL, NULL, 0, 0,
+                                    /* host params */
+                                    0 /* ignore_pagination */,
+                                    filter_term_return, zone_return,
+                                    host_summary);
+      if (ret)
+        {
+          g_free (report_format_id);
+          g_free (xml_start);
+          gvm_file_remove_recurse (xml_dir);
+          return NULL;
+        }
 
-  xml_file = g_strdup_printf ("%s/report.xml", xml_dir);
-
-  /* Apply report format(s) */
-  report_format_id = report_format_uuid (report_format);
+      xml_file = g_strdup_printf ("%s/report.xml", xml_dir);
 
-  output_file = apply_report_format (report_format_id,
-                                     xml_start, xml_file, xml_dir,
-                                     &used_rfps);
+      /* Apply report format(s) */
+      output_file = apply_report_format (report_format_id,
+                                         xml_start, xml_file, xml_dir,
+                                         &used_rfps);
+      g_free (xml_file);
+      g_free (xml_start);
+    }
 
   if (output_file == NULL)
     {
       g_warning ("%s: No file returned for report format", __FUNCTION__);
     }
-  g_free (xml_file);
-  g_free (xml_start);
 
   /* Read the script output from file. */
   if (output_file == NULL)
@@ -32315,36 +33898,62 @@ manage_send_report (report_t report, report_t delta_report,
       return -1;
     }
 
-  xml_start = g_strdup_printf ("%s/report-start.xml", xml_dir);
-  ret = print_report_xml_start (report, delta_report, task, xml_start, get,
-                                type, notes_details, overrides_details,
-                                result_tags,
-                                host, pos, host_search_phrase, host_levels,
-                                host_first_result, host_max_results,
-                                ignore_pagination, NULL, NULL, NULL);
-  if (ret)
+  report_format_id = report_format_uuid (report_format);
+  if (report_format_id
+      && strcmp (report_format_id, REPORT_BINARY_FORMAT_UUID) == 0)
     {
-      g_free (xml_start);
-      gvm_file_remove_recurse (xml_dir);
-      if (ret == 2)
-        return 2;
-      return -1;
+      /* Binary reports are written straight from the database. */
+
+      g_free (report_format_id);
+      if (report == 0)
+        {
+          gvm_file_remove_recurse (xml_dir);
+          return -1;
+        }
+
+      output_file = g_strdup_printf ("%s/report.gvmb", xml_dir);
+      if (report_binary_write (report, get, output_file))
+        {
+          g_free (output_file);
+          gvm_file_remove_recurse (xml_dir);
+          return -1;
+        }
     }
+  else
+    {
+      xml_start = g_strdup_printf ("%s/report-start.xml", xml_dir);
+      ret = print_report_xml_start (report, delta_report, task, xml_start,
+                                    get, type, notes_details,
+                                    overrides_details, result_tags,
+                                    host, pos, host_search_phrase,
+                                    host_levels, host_first_result,
+                                    host_max_results, ignore_pagination,
+                                    NULL, NULL, NULL);
+      if (ret)
+        {
+          g_free (report_format_id);
+          g_free (xml_start);
+          gvm_file_remove_recurse (xml_dir);
+          if (ret == 2)
+            return 2;
+          return -1;
+        }
 
-  xml_file = g_strdup_printf ("%s/report.xml", xml_dir);
+      xml_file = g_strdup_printf ("%s/report.xml", xml_dir);
 
-  /* Apply report format(s). */
-  report_format_id = report_format_uuid (report_format);
+      /* Apply report format(s). */
 
-  output_file = apply_report_format (report_format_id,
-                                     xml_start, xml_file, xml_dir,
-                                     &used_rfps);
+      output_file = apply_report_format (report_format_id,
+                                         xml_start, xml_file, xml_dir,
+                                         &used_rfps);
 
-  if (output_file == NULL)
-    {
-      g_warning ("%s: No file returned for report format", __FUNCTION__);
+      if (output_file == NULL)
+        {
+          g_warning ("%s: No file returned for report format",
+                     __FUNCTION__);
+        }
+      g_free (report_format_id);
     }
-  g_free (report_format_id);
 
   /* Send the report. */
 
@@ -32784,7 +34393,6 @@ task_trend (task_t task, int override, int min_qod)
   int holes_a, warns_a, infos_a, logs_a, false_positives_a;
   int holes_b, warns_b, infos_b, logs_b, false_positives_b;
   double severity_a, severity_b;
-  get_data_t *get;
 
   /* Ensure there are enough reports. */
 
@@ -32811,11 +34419,8 @@ task_trend (task_t task, int override, int min_qod)
   if (last_report == 0)
     return "";
 
-  /* Count the logs and false positives too, as report_counts_id is faster
-   * with all five. */
-  get = report_results_get_data (1, -1, override, 0, min_qod);
-  if (report_counts_id (last_report, NULL, &holes_a, &infos_a, &logs_a, &warns_a,
-                        &false_positives_a, &severity_a, get, NULL))
+  if (report_summary (last_report, override, min_qod, &holes_a, &infos_a,
+                      &logs_a, &warns_a, &false_positives_a, &severity_a))
     /** @todo Either fail better or abort at SQL level. */
     abort ();
 
@@ -32823,22 +34428,14 @@ task_trend (task_t task, int override, int min_qod)
 
   task_second_last_report (task, &second_last_report);
   if (second_last_report == 0)
-    {
-      get_data_reset (get);
-      free (get);
-      return "";
-    }
+    return "";
 
-  /* Count the logs and false positives too, as report_counts_id is faster
-   * with all five. */
-  if (report_counts_id (second_last_report, NULL, &holes_b, &infos_b, &logs_b,
-                        &warns_b, &false_positives_b, &severity_b, get, NULL))
+  if (report_summary (second_last_report, override, min_qod, &holes_b,
+                      &infos_b, &logs_b, &warns_b, &false_positives_b,
+                      &severity_b))
     /** @todo Either fail better or abort at SQL level. */
     abort ();
 
-  get_data_reset (get);
-  free (get);
-
   return task_trend_calc (holes_a, warns_a, infos_a, severity_a,
                           holes_b, warns_b, infos_b, severity_b);
 }
@@ -33327,6 +34924,8 @@ delete_task (task_t task, int ultimate)
            " WHERE report IN (SELECT id FROM reports WHERE task = %llu);",
            task);
 
+      sql ("DELETE FROM task_report_summaries WHERE task = %llu;", task);
+
       sql ("UPDATE tasks SET hidden = 2 WHERE id = %llu;", task);
     }
 
@@ -33386,41 +34985,178 @@ delete_task_lock (task_t task, int ultimate)
 }
 
 /**
- * @brief Delete all trash tasks.
+ * @brief Hide all trash tasks of the current user, for the trash reaper.
+ *
+ * The small per-task rows are removed here with one statement each.  The
+ * tasks are then marked as being reaped (hidden 3), which hides them and
+ * their reports everywhere.  The reports and results, which make up most of
+ * the work, are deleted later by manage_reap_trash.
  *
  * The caller must do the transaction.
+ */
+static void
+hide_trash_tasks ()
+{
+  sql ("UPDATE tickets SET task = -1"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE hidden = 2"
+       "                AND owner = (SELECT id FROM users"
+       "                             WHERE uuid = '%s'));",
+       current_credentials.uuid);
+  sql ("UPDATE tickets_trash SET task = -1"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE hidden = 2"
+       "                AND owner = (SELECT id FROM users"
+       "                             WHERE uuid = '%s'));",
+       current_credentials.uuid);
+  sql ("DELETE FROM task_alerts"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE hidden = 2"
+       "                AND owner = (SELECT id FROM users"
+       "                             WHERE uuid = '%s'));",
+       current_credentials.uuid);
+  sql ("DELETE FROM task_files"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE hidden = 2"
+       "                AND owner = (SELECT id FROM users"
+       "                             WHERE uuid = '%s'));",
+       current_credentials.uuid);
+  sql ("DELETE FROM task_preferences"
+       " WHERE task IN (SELECT id FROM tasks"
+       "                WHERE hidden = 2"
+       "                AND owner = (SELECT id FROM users"
+       "                             WHERE uuid = '%s'));",
+       current_credentials.uuid);
+  sql ("UPDATE tasks SET hidden = 3"
+       " WHERE hidden = 2"
+       " AND owner = (SELECT id FROM users WHERE uuid = '%s');",
+       current_credentials.uuid);
+}
+
+/**
+ * @brief Delete the reports and results of tasks removed from the trashcan.
  *
- * @return 0 on success, -1 on error.
+ * Forks a child to do the deletion, so that the parent can return to the
+ * main loop.  A lock file ensures that only one child reaps at a time.
+ *
+ * Each report is deleted in its own transaction, so that other processes
+ * are only ever held up for the deletion of a single report.  A task is
+ * deleted once all of its reports are gone.
+ *
+ * @param[in]  sigmask_current  Sigmask to restore in child.
  */
-static int
-delete_trash_tasks ()
+void
+manage_reap_trash (sigset_t *sigmask_current)
 {
-  iterator_t tasks;
+  int lockfile, index;
+  array_t *tasks;
+  iterator_t rows;
+  task_t *task;
 
-  init_user_task_iterator (&tasks, 1, 1);
-  while (next (&tasks))
+  if (sql_int ("SELECT count (*) FROM tasks WHERE hidden = 3;") == 0)
+    return;
+
+  if (fork_locked_child (sigmask_current, "gvm-reap-trash", __FUNCTION__,
+                         &lockfile))
+    return;
+
+  proctitle_set ("gvmd: Reaping trash");
+
+  tasks = make_array ();
+  init_iterator (&rows, "SELECT id FROM tasks WHERE hidden = 3;");
+  while (next (&rows))
     {
-      task_t task;
+      task = g_malloc0 (sizeof (task_t));
+      *task = iterator_int64 (&rows, 0);
+      array_add (tasks, task);
+    }
+  cleanup_iterator (&rows);
 
-      task = get_iterator_resource (&tasks);
+  for (index = 0; index < tasks->len; index++)
+    {
+      report_t report;
 
-      if (delete_reports (task))
+      task = (task_t*) g_ptr_array_index (tasks, index);
+
+      while (sql_int64 (&report,
+                        "SELECT id FROM reports WHERE task = %llu LIMIT 1;",
+                        *task)
+             == 0)
         {
-          cleanup_iterator (&tasks);
-          return -1;
+          sql_begin_immediate ();
+          if (delete_report_internal (report))
+            {
+              g_warning ("%s: failed to delete report %llu of task %llu",
+                         __FUNCTION__, report, *task);
+              sql_rollback ();
+              break;
+            }
+          sql_commit ();
         }
 
-      tickets_remove_task (task);
-
-      sql ("DELETE FROM results WHERE task = %llu;", task);
-      sql ("DELETE FROM task_alerts WHERE task = %llu;", task);
-      sql ("DELETE FROM task_files WHERE task = %llu;", task);
-      sql ("DELETE FROM task_preferences WHERE task = %llu;", task);
-      sql ("DELETE FROM tasks WHERE id = %llu;", task);
+      sql_begin_immediate ();
+      if (sql_int ("SELECT count (*) FROM reports WHERE task = %llu;",
+                   *task))
+        {
+          /* Leave the task for the next round. */
+          sql_rollback ();
+          continue;
+        }
+      sql ("DELETE FROM results WHERE task = %llu;", *task);
+      sql ("DELETE FROM results_trash WHERE task = %llu;", *task);
+      sql ("DELETE FROM task_alerts WHERE task = %llu;", *task);
+      sql ("DELETE FROM task_files WHERE task = %llu;", *task);
+      sql ("DELETE FROM task_preferences WHERE task = %llu;", *task);
+      sql ("DELETE FROM tasks WHERE id = %llu AND hidden = 3;", *task);
+      sql_commit ();
     }
-  cleanup_iterator (&tasks);
+  array_free (tasks);
 
-  return 0;
+  exit_locked_child (lockfile, __FUNCTION__);
+}
+
+/**
+ * @brief Remove queued host detail values that no detail refers to.
+ *
+ * delete_report_host_details queues the values of the deleted details.  The
+ * sweep holds a lock that excludes concurrent inserts, so that a value is
+ * never removed while a new detail is about to refer to it.
+ *
+ * @param[in]  sigmask_current  Sigmask to restore in child.
+ */
+void
+manage_sweep_report_host_detail_values (sigset_t *sigmask_current)
+{
+  int lockfile;
+  long long int last;
+
+  if (sql_int ("SELECT NOT EXISTS (SELECT * FROM"
+               "                   report_host_detail_values_sweep);"))
+    return;
+
+  if (fork_locked_child (sigmask_current, "gvm-sweep-host-detail-values",
+                         __FUNCTION__, &lockfile))
+    return;
+
+  proctitle_set ("gvmd: Sweeping host detail values");
+
+  sql_begin_immediate ();
+  if (sql_is_sqlite3 () == 0)
+    sql ("LOCK TABLE report_host_detail_values"
+         " IN SHARE ROW EXCLUSIVE MODE;");
+  /* Leave entries queued during the sweep for the next round. */
+  last = sql_int64_0 ("SELECT max (id) FROM report_host_detail_values_sweep;");
+  sql ("DELETE FROM report_host_detail_values"
+       " WHERE id IN (SELECT value_id FROM report_host_detail_values_sweep"
+       "              WHERE id <= %llu)"
+       " AND NOT EXISTS (SELECT * FROM report_host_detail_rows"
+       "                 WHERE value_id = report_host_detail_values.id);",
+       last);
+  sql ("DELETE FROM report_host_detail_values_sweep WHERE id <= %llu;",
+       last);
+  sql_commit ();
+
+  exit_locked_child (lockfile, __FUNCTION__);
 }
 
 /**
@@ -33474,9 +35210,40 @@ void
 set_scan_ports (report_t report, const char* host, unsigned int current,
                 unsigned int max)
 {
+  iterator_t report_hosts;
+  int progress_change, dead_change;
+
+  /* Work out the change to the progress counters of the report. */
+
+  progress_change = 0;
+  dead_change = 0;
+  init_iterator (&report_hosts,
+                 "SELECT current_port, max_port FROM report_hosts"
+                 " WHERE host = '%s' AND report = %llu;",
+                 host, report);
+  while (next (&report_hosts))
+    {
+      int old_current, old_max;
+
+      old_current = iterator_int (&report_hosts, 0);
+      old_max = iterator_int (&report_hosts, 1);
+
+      progress_change += report_host_progress (current, max)
+                         - report_host_progress (old_current, old_max);
+      dead_change += ((int) max == -1) - (old_max == -1);
+    }
+  cleanup_iterator (&report_hosts);
+
   sql ("UPDATE report_hosts SET current_port = %i, max_port = %i"
        " WHERE host = '%s' AND report = %llu;",
        current, max, host, report);
+
+  if (progress_change || dead_change)
+    sql ("UPDATE reports"
+         " SET progress_sum = coalesce (progress_sum, 0) + %i,"
+         "     progress_dead = coalesce (progress_dead, 0) + %i"
+         " WHERE id = %llu;",
+         progress_change, dead_change, report);
 }
 
 /**
@@ -36202,49 +37969,70 @@ char*
 target_port_range (target_t target)
 {
   GString *range;
-  iterator_t ranges;
+  iterator_t intervals;
+  port_list_t port_list;
+  char *uuid;
+
   range = g_string_new ("");
-  init_port_range_iterator (&ranges, target_port_list (target), 0, 1,
-                            "type, CAST (start AS INTEGER)");
-  if (next (&ranges))
+  port_list = target_port_list (target);
+  if (port_list == 0)
+    return g_string_free (range, FALSE);
+
+  uuid = port_list_uuid (port_list);
+  if (uuid == NULL
+      || acl_user_has_access_uuid ("port_list", uuid, "get_port_lists", 0)
+         == 0)
     {
-      const char *start, *end;
-      int type;
+      free (uuid);
+      return g_string_free (range, FALSE);
+    }
+  free (uuid);
+
+  /* The compiled intervals are already sorted and merged. */
 
-      start = port_range_iterator_start (&ranges);
-      end = port_range_iterator_end (&ranges);
-      type = port_range_iterator_type_int (&ranges);
+  init_iterator (&intervals,
+                 "SELECT type, start, \"end\" FROM port_list_intervals"
+                 " WHERE port_list = %llu"
+                 " ORDER BY type, start;",
+                 port_list);
+  if (next (&intervals))
+    {
+      int type, start, end;
+
+      type = iterator_int (&intervals, 0);
+      start = iterator_int (&intervals, 1);
+      end = iterator_int (&intervals, 2);
 
       /* Scanner can only handle: T:1-3,5-6,9,U:1-2 */
 
-      if (end && strcmp (end, "0") && strcmp (end, start))
-        g_string_append_printf (range, "%s%s-%s",
+      if (end > start)
+        g_string_append_printf (range, "%s%i-%i",
                                 (type == PORT_PROTOCOL_UDP ? "U:" : "T:"),
                                 start, end);
       else
-        g_string_append_printf (range, "%s%s",
+        g_string_append_printf (range, "%s%i",
                                 (type == PORT_PROTOCOL_UDP ? "U:" : "T:"),
                                 start);
-      while (next (&ranges))
+      while (next (&intervals))
         {
           int tcp;
 
-          start = port_range_iterator_start (&ranges);
-          end = port_range_iterator_end (&ranges);
           tcp = (type == PORT_PROTOCOL_TCP);
-          type = port_range_iterator_type_int (&ranges);
+          type = iterator_int (&intervals, 0);
+          start = iterator_int (&intervals, 1);
+          end = iterator_int (&intervals, 2);
 
-          if (end && strcmp (end, "0") && strcmp (end, start))
-            g_string_append_printf (range, ",%s%s-%s",
+          if (end > start)
+            g_string_append_printf (range, ",%s%i-%i",
                                     (tcp && type == PORT_PROTOCOL_UDP ? "U:" : ""),
                                     start, end);
           else
-            g_string_append_printf (range, ",%s%s",
+            g_string_append_printf (range, ",%s%i",
                                     (tcp && type == PORT_PROTOCOL_UDP ? "U:" : ""),
                                     start);
         }
     }
-  cleanup_iterator (&ranges);
+  cleanup_iterator (&intervals);
   return g_string_free (range, FALSE);
 }
 
@@ -37235,6 +39023,7 @@ delete_config (const char *config_id, int ultimate)
                           LOCATION_TRASH);
     }
 
+  config_otp_cache_clear (config);
   sql ("DELETE FROM config_preferences WHERE config = %llu;", config);
   sql ("DELETE FROM configs WHERE id = %llu;", config);
 
@@ -37878,6 +39667,96 @@ DEF_ACCESS (otp_pref_iterator_name, 0);
  */
 DEF_ACCESS (otp_pref_iterator_value, 1);
 
+/**
+ * @brief Get the cached scanner payload of a config.
+ *
+ * The cache is only used if it was made from the current modification time
+ * of the config and the current NVT feed version.
+ *
+ * @param[in]   config         Config.
+ * @param[out]  plugins        Semicolon separated plugin OIDs.
+ * @param[out]  server_prefs   Serialized SERVER_PREFS, NULL if not cached.
+ * @param[out]  plugins_prefs  Serialized PLUGINS_PREFS, NULL if not cached.
+ *
+ * @return 0 success, 1 no usable cache.
+ */
+int
+config_otp_cache (config_t config, gchar **plugins, gchar **server_prefs,
+                  gchar **plugins_prefs)
+{
+  iterator_t cache;
+  int ret;
+
+  init_iterator (&cache,
+                 "SELECT plugins, server_prefs, plugins_prefs"
+                 " FROM config_otp_caches"
+                 " WHERE config = %llu"
+                 " AND modification_time = (SELECT modification_time"
+                 "                          FROM configs"
+                 "                          WHERE id = %llu)"
+                 " AND feed_version = (SELECT value FROM meta"
+                 "                     WHERE name = 'nvts_feed_version');",
+                 config,
+                 config);
+  ret = 1;
+  if (next (&cache))
+    {
+      *plugins = g_strdup (iterator_string (&cache, 0));
+      *server_prefs = g_strdup (iterator_string (&cache, 1));
+      *plugins_prefs = g_strdup (iterator_string (&cache, 2));
+      ret = 0;
+    }
+  cleanup_iterator (&cache);
+  return ret;
+}
+
+/**
+ * @brief Cache the scanner payload of a config.
+ *
+ * @param[in]  config         Config.
+ * @param[in]  plugins        Semicolon separated plugin OIDs.
+ * @param[in]  server_prefs   Serialized SERVER_PREFS, or NULL.
+ * @param[in]  plugins_prefs  Serialized PLUGINS_PREFS, or NULL.
+ */
+void
+set_config_otp_cache (config_t config, const gchar *plugins,
+                      const gchar *server_prefs, const gchar *plugins_prefs)
+{
+  gchar *quoted_plugins, *quoted_server_prefs, *quoted_plugins_prefs;
+
+  quoted_plugins = sql_insert (plugins);
+  quoted_server_prefs = sql_insert (server_prefs);
+  quoted_plugins_prefs = sql_insert (plugins_prefs);
+
+  sql ("DELETE FROM config_otp_caches WHERE config = %llu;", config);
+  sql ("INSERT INTO config_otp_caches"
+       " (config, modification_time, feed_version, plugins, server_prefs,"
+       "  plugins_prefs)"
+       " SELECT id, modification_time,"
+       "        (SELECT value FROM meta WHERE name = 'nvts_feed_version'),"
+       "        %s, %s, %s"
+       " FROM configs WHERE id = %llu;",
+       quoted_plugins,
+       quoted_server_prefs,
+       quoted_plugins_prefs,
+       config);
+
+  g_free (quoted_plugins);
+  g_free (quoted_server_prefs);
+  g_free (quoted_plugins_prefs);
+}
+
+/**
+ * @brief Drop the cached scanner payload of a config.
+ *
+ * @param[in]  config  Config.
+ */
+static void
+config_otp_cache_clear (config_t config)
+{
+  sql ("DELETE FROM config_otp_caches WHERE config = %llu;", config);
+}
+
 /**
  * @brief Return the NVT selector associated with a config.
  *
@@ -37954,6 +39833,7 @@ manage_set_config_preference (const gchar *config_id, const char* nvt,
            " AND name = '%s';",
            config,
            quoted_name);
+      config_otp_cache_clear (config);
 
       sql_commit ();
 
@@ -38084,6 +39964,8 @@ manage_set_config_preference (const gchar *config_id, const char* nvt,
            quoted_value);
     }
 
+  config_otp_cache_clear (config);
+
   sql_commit ();
 
   g_free (quoted_name);
@@ -38183,7 +40065,6 @@ manage_set_config_nvts (const gchar *config_id, const char* family,
   config_t config;
   char *selector;
   gchar *quoted_family, *quoted_selector;
-  int new_nvt_count = 0, old_nvt_count;
 
   sql_begin_immediate ();
 
@@ -38225,10 +40106,6 @@ manage_set_config_nvts (const gchar *config_id, const char* family,
                                    family,
                                    config_families_growing (config)))
     {
-      iterator_t nvts;
-
-      old_nvt_count = nvt_selector_nvt_count (selector, family, 1);
-
       free (selector);
 
       /* Clear any NVT selectors for this family from the config. */
@@ -38240,37 +40117,15 @@ manage_set_config_nvts (const gchar *config_id, const char* family,
            quoted_selector,
            quoted_family);
 
-      /* Exclude all no's. */
-
-      new_nvt_count = family_nvt_count (family);
-
-      init_nvt_iterator (&nvts, (nvt_t) 0, config, family, NULL, 1, NULL);
-      while (next (&nvts))
-        {
-          const char *oid = nvt_iterator_oid (&nvts);
-          gchar *quoted_oid;
-
-          if (member (selected_nvts, oid)) continue;
-
-          quoted_oid = sql_quote (oid);
-          sql ("INSERT INTO nvt_selectors"
-               " (name, exclude, type, family_or_nvt, family)"
-               " VALUES ('%s', 1, "
-               G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-               ", '%s', '%s');",
-               quoted_selector,
-               quoted_oid,
-               quoted_family);
-          g_free (quoted_oid);
+      /* Exclude all no's, by excluding the whole family and then removing
+       * the excludes of the yes's. */
 
-          new_nvt_count--;
-        }
-      cleanup_iterator (&nvts);
+      nvt_selector_add_family_nvts (quoted_selector, quoted_family, 1);
+      if (selected_nvts)
+        nvt_selector_remove_nvts (quoted_selector, selected_nvts, 1);
     }
   else
     {
-      old_nvt_count = nvt_selector_nvt_count (selector, family, 0);
-
       free (selector);
 
       /* Clear any NVT selectors for this family from the config. */
@@ -38285,41 +40140,22 @@ manage_set_config_nvts (const gchar *config_id, const char* family,
       /* Include all yes's. */
 
       if (selected_nvts)
-        {
-          gchar *nvt;
-          new_nvt_count = 0;
-
-          while ((nvt = (gchar*) g_ptr_array_index (selected_nvts,
-                                                    new_nvt_count)))
-            {
-              gchar *quoted_nvt = sql_quote (nvt);
-              sql ("INSERT INTO nvt_selectors"
-                   " (name, exclude, type, family_or_nvt, family)"
-                   " VALUES ('%s', 0, "
-                   G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-                   ", '%s', '%s');",
-                   quoted_selector,
-                   quoted_nvt,
-                   quoted_family);
-              g_free (quoted_nvt);
-              new_nvt_count++;
-            }
-        }
+        nvt_selector_add_nvts (quoted_selector,
+                               selected_nvts,
+                               quoted_family,
+                               0);
     }
 
-  /* Update the cached config info. */
+  /* Update the cached config info.  The counts are recalculated from the
+   * selector, because the number of changed rows is not available on every
+   * backend. */
 
-  sql ("UPDATE configs SET family_count = family_count + %i,"
-       " nvt_count = nvt_count - %i + %i,"
-       " modification_time = m_now ()"
-       " WHERE id = %llu;",
-       old_nvt_count == 0
-        ? (new_nvt_count == 0 ? 0 : 1)
-        : (new_nvt_count == 0 ? -1 : 0),
-       old_nvt_count,
-       MAX (new_nvt_count, 0),
+  update_config_caches (config);
+  sql ("UPDATE configs SET modification_time = m_now () WHERE id = %llu;",
        config);
 
+  config_otp_cache_clear (config);
+
   sql_commit ();
 
   g_free (quoted_family);
@@ -38582,13 +40418,12 @@ static void
 update_config_cache (iterator_t *configs)
 {
   const char *selector;
-  gchar *quoted_selector, *quoted_name;
+  gchar *quoted_selector;
   int families_growing;
 
   if (config_iterator_type (configs) > 0)
     return;
 
-  quoted_name = sql_quote (get_iterator_name (configs));
   selector = config_iterator_nvt_selector (configs);
   families_growing = nvt_selector_families_growing (selector);
   quoted_selector = sql_quote (selector);
@@ -38596,14 +40431,13 @@ update_config_cache (iterator_t *configs)
   sql ("UPDATE configs"
        " SET family_count = %i, nvt_count = %i,"
        " families_growing = %i, nvts_growing = %i"
-       " WHERE name = '%s';",
+       " WHERE id = %llu;",
        nvt_selector_family_count (quoted_selector, families_growing),
        nvt_selector_nvt_count (quoted_selector, NULL, families_growing),
        families_growing,
        nvt_selector_nvts_growing_2 (quoted_selector, families_growing),
-       quoted_name);
+       get_iterator_resource (configs));
 
-  g_free (quoted_name);
   g_free (quoted_selector);
 }
 
@@ -38677,6 +40511,23 @@ update_config_cache_init (const char *uuid)
 
 /* FIX From old NVTs section. */
 
+/**
+ * @brief Check whether the SecInfo change log has entries of a kind.
+ *
+ * @param[in]  type    SecInfo type, for example "cve".
+ * @param[in]  change  SECINFO_CHANGE_NEW or SECINFO_CHANGE_UPDATED.
+ *
+ * @return 1 if there are entries, else 0.
+ */
+static int
+secinfo_changes_exist (const char *type, int change)
+{
+  return sql_int ("SELECT EXISTS (SELECT * FROM secinfo_changes"
+                  "               WHERE type = '%s' AND change = %i);",
+                  type,
+                  change);
+}
+
 /**
  * @brief Check for new SCAP SecInfo after an update.
  */
@@ -38685,34 +40536,13 @@ check_for_new_scap ()
 {
   if (manage_scap_loaded ())
     {
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM cves"
-                   "  WHERE creation_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'scap_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0));"))
+      if (secinfo_changes_exist ("cve", SECINFO_CHANGE_NEW))
         event (EVENT_NEW_SECINFO, "cve", 0, 0);
 
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM cpes"
-                   "  WHERE creation_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'scap_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0));"))
+      if (secinfo_changes_exist ("cpe", SECINFO_CHANGE_NEW))
         event (EVENT_NEW_SECINFO, "cpe", 0, 0);
 
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM ovaldefs"
-                   "  WHERE creation_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'scap_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0));"))
+      if (secinfo_changes_exist ("ovaldef", SECINFO_CHANGE_NEW))
         event (EVENT_NEW_SECINFO, "ovaldef", 0, 0);
     }
 }
@@ -38725,24 +40555,10 @@ check_for_new_cert ()
 {
   if (manage_cert_loaded ())
     {
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM cert_bund_advs"
-                   "  WHERE creation_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'cert_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0));"))
+      if (secinfo_changes_exist ("cert_bund_adv", SECINFO_CHANGE_NEW))
         event (EVENT_NEW_SECINFO, "cert_bund_adv", 0, 0);
 
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM dfn_cert_advs"
-                   "  WHERE creation_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'cert_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0));"))
+      if (secinfo_changes_exist ("dfn_cert_adv", SECINFO_CHANGE_NEW))
         event (EVENT_NEW_SECINFO, "dfn_cert_adv", 0, 0);
     }
 }
@@ -38916,29 +40732,17 @@ new_cves_list (event_t event, const void* event_data, alert_t alert,
   else if (event == EVENT_NEW_SECINFO)
     init_iterator (&rows,
                    "SELECT uuid, name, cvss, description FROM cves"
-                   " WHERE creation_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " ORDER BY creation_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'cve' AND change = %i)"
+                   " ORDER BY creation_time DESC;",
+                   SECINFO_CHANGE_NEW);
   else
     init_iterator (&rows,
                    "SELECT uuid, name, cvss, description FROM cves"
-                   " WHERE modification_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " AND creation_time"
-                   "     <= coalesce (CAST ((SELECT value FROM meta"
-                   "                         WHERE name"
-                   "                               = 'scap_check_time')"
-                   "                        AS INTEGER),"
-                   "                  0)"
-                   " ORDER BY modification_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'cve' AND change = %i)"
+                   " ORDER BY modification_time DESC;",
+                   SECINFO_CHANGE_UPDATED);
 
   while (next (&rows))
     {
@@ -39007,29 +40811,17 @@ new_cpes_list (event_t event, const void* event_data, alert_t alert,
   else if (event == EVENT_NEW_SECINFO)
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM cpes"
-                   " WHERE creation_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " ORDER BY creation_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'cpe' AND change = %i)"
+                   " ORDER BY creation_time DESC;",
+                   SECINFO_CHANGE_NEW);
   else
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM cpes"
-                   " WHERE modification_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " AND creation_time"
-                   "     <= coalesce (CAST ((SELECT value FROM meta"
-                   "                         WHERE name"
-                   "                               = 'scap_check_time')"
-                   "                        AS INTEGER),"
-                   "                  0)"
-                   " ORDER BY modification_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'cpe' AND change = %i)"
+                   " ORDER BY modification_time DESC;",
+                   SECINFO_CHANGE_UPDATED);
 
   while (next (&rows))
     {
@@ -39097,29 +40889,17 @@ new_cert_bunds_list (event_t event, const void* event_data, alert_t alert,
   else if (event == EVENT_NEW_SECINFO)
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM cert_bund_advs"
-                   " WHERE creation_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'cert_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " ORDER BY creation_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'cert_bund_adv' AND change = %i)"
+                   " ORDER BY creation_time DESC;",
+                   SECINFO_CHANGE_NEW);
   else
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM cert_bund_advs"
-                   " WHERE modification_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'cert_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " AND creation_time"
-                   "     <= coalesce (CAST ((SELECT value FROM meta"
-                   "                         WHERE name"
-                   "                               = 'cert_check_time')"
-                   "                        AS INTEGER),"
-                   "                  0)"
-                   " ORDER BY modification_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'cert_bund_adv' AND change = %i)"
+                   " ORDER BY modification_time DESC;",
+                   SECINFO_CHANGE_UPDATED);
 
   while (next (&rows))
     {
@@ -39184,29 +40964,17 @@ new_dfn_certs_list (event_t event, const void* event_data, alert_t alert,
   else if (event == EVENT_NEW_SECINFO)
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM dfn_cert_advs"
-                   " WHERE creation_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'cert_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " ORDER BY creation_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'dfn_cert_adv' AND change = %i)"
+                   " ORDER BY creation_time DESC;",
+                   SECINFO_CHANGE_NEW);
   else
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM dfn_cert_advs"
-                   " WHERE modification_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'cert_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " AND creation_time"
-                   "     <= coalesce (CAST ((SELECT value FROM meta"
-                   "                         WHERE name"
-                   "                               = 'cert_check_time')"
-                   "                        AS INTEGER),"
-                   "                  0)"
-                   " ORDER BY modification_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'dfn_cert_adv' AND change = %i)"
+                   " ORDER BY modification_time DESC;",
+                   SECINFO_CHANGE_UPDATED);
 
   while (next (&rows))
     {
@@ -39271,29 +41039,17 @@ new_oval_defs_list (event_t event, const void* event_data, alert_t alert,
   else if (event == EVENT_NEW_SECINFO)
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM ovaldefs"
-                   " WHERE creation_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " ORDER BY creation_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'ovaldef' AND change = %i)"
+                   " ORDER BY creation_time DESC;",
+                   SECINFO_CHANGE_NEW);
   else
     init_iterator (&rows,
                    "SELECT uuid, name, title FROM ovaldefs"
-                   " WHERE modification_time"
-                   "       > coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0)"
-                   " AND creation_time"
-                   "     <= coalesce (CAST ((SELECT value FROM meta"
-                   "                         WHERE name"
-                   "                               = 'scap_check_time')"
-                   "                        AS INTEGER),"
-                   "                  0)"
-                   " ORDER BY modification_time DESC;");
+                   " WHERE uuid IN (SELECT uuid FROM secinfo_changes"
+                   "                WHERE type = 'ovaldef' AND change = %i)"
+                   " ORDER BY modification_time DESC;",
+                   SECINFO_CHANGE_UPDATED);
 
   while (next (&rows))
     {
@@ -39440,52 +41196,13 @@ check_for_updated_scap ()
 {
   if (manage_scap_loaded ())
     {
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM cves"
-                   "  WHERE modification_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'scap_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0)"
-                   "  AND creation_time"
-                   "      <= coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0));"))
+      if (secinfo_changes_exist ("cve", SECINFO_CHANGE_UPDATED))
         event (EVENT_UPDATED_SECINFO, "cve", 0, 0);
 
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM cpes"
-                   "  WHERE modification_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'scap_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0)"
-                   "  AND creation_time"
-                   "      <= coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0));"))
+      if (secinfo_changes_exist ("cpe", SECINFO_CHANGE_UPDATED))
         event (EVENT_UPDATED_SECINFO, "cpe", 0, 0);
 
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM ovaldefs"
-                   "  WHERE modification_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'scap_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0)"
-                   "  AND creation_time"
-                   "      <= coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'scap_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0));"))
+      if (secinfo_changes_exist ("ovaldef", SECINFO_CHANGE_UPDATED))
         event (EVENT_UPDATED_SECINFO, "ovaldef", 0, 0);
     }
 }
@@ -39498,36 +41215,10 @@ check_for_updated_cert ()
 {
   if (manage_cert_loaded ())
     {
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM cert_bund_advs"
-                   "  WHERE modification_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'cert_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0)"
-                   "  AND creation_time"
-                   "      <= coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'cert_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0));"))
+      if (secinfo_changes_exist ("cert_bund_adv", SECINFO_CHANGE_UPDATED))
         event (EVENT_UPDATED_SECINFO, "cert_bund_adv", 0, 0);
 
-      if (sql_int ("SELECT EXISTS"
-                   " (SELECT * FROM dfn_cert_advs"
-                   "  WHERE modification_time"
-                   "        > coalesce (CAST ((SELECT value FROM meta"
-                   "                           WHERE name"
-                   "                                 = 'cert_check_time')"
-                   "                          AS INTEGER),"
-                   "                    0)"
-                   "  AND creation_time"
-                   "      <= coalesce (CAST ((SELECT value FROM meta"
-                   "                          WHERE name"
-                   "                                = 'cert_check_time')"
-                   "                         AS INTEGER),"
-                   "                   0));"))
+      if (secinfo_changes_exist ("dfn_cert_adv", SECINFO_CHANGE_UPDATED))
         event (EVENT_UPDATED_SECINFO, "dfn_cert_adv", 0, 0);
     }
 }
@@ -39901,6 +41592,159 @@ init_family_iterator (iterator_t* iterator, int all, const char* selector,
  */
 DEF_ACCESS (family_iterator_name, 0);
 
+/**
+ * @brief Initialise an iterator over the families of an NVT selector.
+ *
+ * Unlike init_family_iterator, this also gets the growing flag, the number
+ * of NVTs and the number of selected NVTs of each family, using a single
+ * query with grouped counts.
+ *
+ * @param[in]  iterator  Iterator.
+ * @param[in]  all       True if selector is an "all" selector, else 0.
+ * @param[in]  selector  Name of NVT selector.
+ */
+void
+init_selector_family_iterator (iterator_t* iterator, int all,
+                               const char* selector)
+{
+  gchar *quoted_selector, *families, *growing;
+
+  quoted_selector = sql_quote (selector);
+
+  if (all)
+    {
+      /* Constraining the universe.  A family is growing unless there is a
+       * family exclude. */
+      families = g_strdup_printf
+                  ("SELECT distinct family FROM nvts"
+                   " WHERE family != 'Credentials'"
+                   " EXCEPT"
+                   " SELECT distinct family FROM nvt_selectors"
+                   " WHERE type = " G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
+                   " AND exclude = 1"
+                   " AND name = '%s'"
+                   " UNION"
+                   " SELECT distinct family FROM nvt_selectors"
+                   " WHERE type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+                   " AND exclude = 0"
+                   " AND name = '%s'",
+                   quoted_selector,
+                   quoted_selector);
+      growing = g_strdup ("coalesce (family_selections.excludes, 0) = 0");
+    }
+  else
+    {
+      /* Generating from empty.  A family is growing if there is a family
+       * include. */
+      families = g_strdup_printf
+                  ("SELECT distinct family FROM nvt_selectors"
+                   " WHERE (type = 1 OR type = 2) AND name = '%s'"
+                   " AND family != 'Credentials'",
+                   quoted_selector);
+      growing = g_strdup ("coalesce (family_selections.includes, 0) > 0");
+    }
+
+  init_iterator (iterator,
+                 "SELECT families.family,"
+                 "       CASE WHEN %s THEN 1 ELSE 0 END,"
+                 "       coalesce (family_nvts.count, 0),"
+                 "       CASE WHEN %s"
+                 "            THEN coalesce (family_nvts.count, 0)"
+                 "                 - coalesce (nvt_selections.excludes, 0)"
+                 "            ELSE coalesce (nvt_selections.includes, 0)"
+                 "            END"
+                 " FROM (%s) AS families"
+                 " LEFT JOIN (SELECT family, count (*) AS count"
+                 "            FROM nvts GROUP BY family)"
+                 "           AS family_nvts"
+                 "        ON family_nvts.family = families.family"
+                 " LEFT JOIN (SELECT family_or_nvt AS family,"
+                 "                   sum (CASE WHEN exclude = 1 THEN 1 ELSE 0"
+                 "                        END) AS excludes,"
+                 "                   sum (CASE WHEN exclude = 0 THEN 1 ELSE 0"
+                 "                        END) AS includes"
+                 "            FROM nvt_selectors"
+                 "            WHERE name = '%s'"
+                 "            AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
+                 "            GROUP BY family_or_nvt)"
+                 "           AS family_selections"
+                 "        ON family_selections.family = families.family"
+                 " LEFT JOIN (SELECT family,"
+                 "                   sum (CASE WHEN exclude = 1 THEN 1 ELSE 0"
+                 "                        END) AS excludes,"
+                 "                   sum (CASE WHEN exclude = 0 THEN 1 ELSE 0"
+                 "                        END) AS includes"
+                 "            FROM nvt_selectors"
+                 "            WHERE name = '%s'"
+                 "            AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+                 "            GROUP BY family)"
+                 "           AS nvt_selections"
+                 "        ON nvt_selections.family = families.family"
+                 " ORDER BY families.family ASC;",
+                 growing,
+                 growing,
+                 families,
+                 quoted_selector,
+                 quoted_selector);
+
+  g_free (growing);
+  g_free (families);
+  g_free (quoted_selector);
+}
+
+/**
+ * @brief Get the name from a selector family iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name, or NULL if iteration is complete.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (selector_family_iterator_name, 0);
+
+/**
+ * @brief Get whether the family of a selector family iterator is growing.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return 1 growing, 0 static, -1 if iteration is complete.
+ */
+int
+selector_family_iterator_growing (iterator_t* iterator)
+{
+  if (iterator->done) return -1;
+  return iterator_int (iterator, 1);
+}
+
+/**
+ * @brief Get the number of NVTs in the family of a selector family iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Number of NVTs in the family, -1 if iteration is complete.
+ */
+int
+selector_family_iterator_max_nvt_count (iterator_t* iterator)
+{
+  if (iterator->done) return -1;
+  return iterator_int (iterator, 2);
+}
+
+/**
+ * @brief Get the number of selected NVTs from a selector family iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Number of NVTs of the family selected by the selector, -1 if
+ *         iteration is complete.
+ */
+int
+selector_family_iterator_nvt_count (iterator_t* iterator)
+{
+  if (iterator->done) return -1;
+  return iterator_int (iterator, 3);
+}
+
 /**
  * @brief Get whether an NVT selector family is growing.
  *
@@ -40179,30 +42023,6 @@ nvt_selector_set_family (const char* quoted_selector,
   g_free (quoted_family_or_nvt);
 }
 
-/**
- * @brief Check whether a family is selected.
- *
- * Only works for "generating from empty" selection.
- *
- * @param[in]  quoted_selector  SQL-quoted selector name.
- * @param[in]  quoted_family    SQL-quoted family name (NULL for families).
- *
- * @return 1 if selected, else 0.
- */
-static int
-family_is_selected (const char* quoted_selector, const char* quoted_family)
-{
-  return sql_int ("SELECT count(*) FROM nvt_selectors"
-                  " WHERE name = '%s'"
-                  " AND (type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
-                  "      AND family = '%s')"
-                  " OR (type = " G_STRINGIFY (NVT_SELECTOR_TYPE_FAMILY)
-                  "     AND family_or_nvt = '%s');",
-                  quoted_selector,
-                  quoted_family,
-                  quoted_family);
-}
-
 /**
  * @brief Check whether an NVT selector has a particular selector.
  *
@@ -40229,6 +42049,182 @@ nvt_selector_has (const char* quoted_selector, const char* family_or_nvt,
                   family_or_nvt);
 }
 
+/**
+ * @brief Maximum number of NVTs in a single NVT selector statement.
+ */
+#define NVT_SELECTOR_BATCH_SIZE 500
+
+/**
+ * @brief Add a selector for every NVT in a family to an NVT selector.
+ *
+ * @param[in]  quoted_selector  SQL-quoted selector name.
+ * @param[in]  quoted_family    SQL-quoted family name.
+ * @param[in]  exclude          1 exclude selectors, 0 include selectors.
+ */
+static void
+nvt_selector_add_family_nvts (const char* quoted_selector,
+                              const char* quoted_family,
+                              int exclude)
+{
+  sql ("INSERT INTO nvt_selectors"
+       " (name, exclude, type, family_or_nvt, family)"
+       " SELECT '%s', %i, " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT) ", oid, '%s'"
+       " FROM nvts WHERE family = '%s';",
+       quoted_selector,
+       exclude,
+       quoted_family,
+       quoted_family);
+}
+
+/**
+ * @brief Invert the NVT selectors of a family in an NVT selector.
+ *
+ * Removes every NVT selector of the family that has the opposite of exclude,
+ * and adds a selector with exclude for every other NVT in the family.
+ *
+ * @param[in]  quoted_selector  SQL-quoted selector name.
+ * @param[in]  quoted_family    SQL-quoted family name.
+ * @param[in]  exclude          1 exclude selectors, 0 include selectors.
+ */
+static void
+nvt_selector_invert_family_nvts (const char* quoted_selector,
+                                 const char* quoted_family,
+                                 int exclude)
+{
+  sql ("INSERT INTO nvt_selectors"
+       " (name, exclude, type, family_or_nvt, family)"
+       " SELECT '%s', %i, " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT) ", oid, '%s'"
+       " FROM nvts WHERE family = '%s'"
+       " AND oid NOT IN (SELECT family_or_nvt FROM nvt_selectors"
+       "                 WHERE name = '%s'"
+       "                 AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+       "                 AND exclude = %i);",
+       quoted_selector,
+       exclude,
+       quoted_family,
+       quoted_family,
+       quoted_selector,
+       exclude == 0);
+
+  sql ("DELETE FROM nvt_selectors"
+       " WHERE name = '%s'"
+       " AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+       " AND exclude = %i"
+       " AND family_or_nvt IN (SELECT oid FROM nvts WHERE family = '%s');",
+       quoted_selector,
+       exclude == 0,
+       quoted_family);
+}
+
+/**
+ * @brief Add selectors for a list of NVTs to an NVT selector.
+ *
+ * The NVTs are inserted in batches of NVT_SELECTOR_BATCH_SIZE.
+ *
+ * @param[in]  quoted_selector  SQL-quoted selector name.
+ * @param[in]  nvts             NULL terminated array of NVT OIDs.
+ * @param[in]  quoted_family    SQL-quoted family name.
+ * @param[in]  exclude          1 exclude selectors, 0 include selectors.
+ */
+static void
+nvt_selector_add_nvts (const char* quoted_selector, GPtrArray *nvts,
+                       const char* quoted_family, int exclude)
+{
+  GString *values;
+  const gchar *nvt;
+  int index;
+
+  values = g_string_new ("");
+  index = 0;
+  while ((nvt = (gchar*) g_ptr_array_index (nvts, index++)))
+    {
+      gchar *quoted_nvt;
+
+      quoted_nvt = sql_quote (nvt);
+      g_string_append_printf (values,
+                              "%s('%s', %i, "
+                              G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+                              ", '%s', '%s')",
+                              values->len ? ", " : "",
+                              quoted_selector,
+                              exclude,
+                              quoted_nvt,
+                              quoted_family);
+      g_free (quoted_nvt);
+
+      if (index % NVT_SELECTOR_BATCH_SIZE == 0)
+        {
+          sql ("INSERT INTO nvt_selectors"
+               " (name, exclude, type, family_or_nvt, family)"
+               " VALUES %s;",
+               values->str);
+          g_string_truncate (values, 0);
+        }
+    }
+
+  if (values->len)
+    sql ("INSERT INTO nvt_selectors"
+         " (name, exclude, type, family_or_nvt, family)"
+         " VALUES %s;",
+         values->str);
+  g_string_free (values, TRUE);
+}
+
+/**
+ * @brief Remove the selectors for a list of NVTs from an NVT selector.
+ *
+ * The NVTs are removed in batches of NVT_SELECTOR_BATCH_SIZE.
+ *
+ * @param[in]  quoted_selector  SQL-quoted selector name.
+ * @param[in]  nvts             NULL terminated array of NVT OIDs.
+ * @param[in]  exclude          1 exclude selectors, 0 include selectors.
+ */
+static void
+nvt_selector_remove_nvts (const char* quoted_selector, GPtrArray *nvts,
+                          int exclude)
+{
+  GString *oids;
+  const gchar *nvt;
+  int index;
+
+  oids = g_string_new ("");
+  index = 0;
+  while ((nvt = (gchar*) g_ptr_array_index (nvts, index++)))
+    {
+      gchar *quoted_nvt;
+
+      quoted_nvt = sql_quote (nvt);
+      g_string_append_printf (oids, "%s'%s'",
+                              oids->len ? ", " : "",
+                              quoted_nvt);
+      g_free (quoted_nvt);
+
+      if (index % NVT_SELECTOR_BATCH_SIZE == 0)
+        {
+          sql ("DELETE FROM nvt_selectors"
+               " WHERE name = '%s'"
+               " AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+               " AND exclude = %i"
+               " AND family_or_nvt IN (%s);",
+               quoted_selector,
+               exclude,
+               oids->str);
+          g_string_truncate (oids, 0);
+        }
+    }
+
+  if (oids->len)
+    sql ("DELETE FROM nvt_selectors"
+         " WHERE name = '%s'"
+         " AND type = " G_STRINGIFY (NVT_SELECTOR_TYPE_NVT)
+         " AND exclude = %i"
+         " AND family_or_nvt IN (%s);",
+         quoted_selector,
+         exclude,
+         oids->str);
+  g_string_free (oids, TRUE);
+}
+
 /**
  * @brief Refresh NVT selection of a config from given families.
  *
@@ -40250,7 +42246,7 @@ manage_set_config_families (const gchar *config_id,
   config_t config;
   iterator_t families;
   gchar *quoted_selector;
-  int constraining;
+  int constraining, changed;
   char *selector;
 
   sql_begin_immediate ();
@@ -40300,8 +42296,11 @@ manage_set_config_families (const gchar *config_id,
     }
   quoted_selector = sql_quote (selector);
 
-  /* Loop through all the known families. */
+  /* Loop through all the known families.  Each family is updated with set
+   * operations over the NVTs of the family, and the cached counts of the
+   * config are recalculated once at the end. */
 
+  changed = 0;
   init_family_iterator (&families, 1, NULL, 1);
   while (next (&families))
     {
@@ -40310,8 +42309,7 @@ manage_set_config_families (const gchar *config_id,
       family = family_iterator_name (&families);
       if (family)
         {
-          int old_nvt_count, new_nvt_count = 0, was_selected, max_nvt_count;
-          int family_growing;
+          int old_nvt_count, max_nvt_count, family_growing;
           int growing_all = member (growing_all_families, family);
           int static_all = member (static_all_families, family);
           gchar *quoted_family = sql_quote (family);
@@ -40338,9 +42336,6 @@ manage_set_config_families (const gchar *config_id,
                   continue;
                 }
 
-              was_selected = family_is_selected (quoted_selector,
-                                                 quoted_family);
-
               /* Flush all selectors in the family from the config. */
 
               nvt_selector_remove (quoted_selector,
@@ -40349,8 +42344,6 @@ manage_set_config_families (const gchar *config_id,
 
               if (static_all)
                 {
-                  iterator_t nvts;
-
                   /* Static selection of all the NVT's currently in the
                    * family. */
 
@@ -40372,17 +42365,9 @@ manage_set_config_families (const gchar *config_id,
 
                   /* Add an include for every NVT in the family. */
 
-                  init_nvt_iterator (&nvts, (nvt_t) 0, (config_t) 0, family,
-                                     NULL, 1, NULL);
-                  while (next (&nvts))
-                    {
-                      nvt_selector_add (quoted_selector,
-                                        nvt_iterator_oid (&nvts),
-                                        quoted_family,
-                                        0);
-                      new_nvt_count++;
-                    }
-                  cleanup_iterator (&nvts);
+                  nvt_selector_add_family_nvts (quoted_selector,
+                                                quoted_family,
+                                                0);
                 }
               else if (growing_all)
                 {
@@ -40403,25 +42388,9 @@ manage_set_config_families (const gchar *config_id,
                                         0);
 
                     }
-
-                  new_nvt_count = max_nvt_count;
                 }
 
-              /* Update the cached config info. */
-
-              sql ("UPDATE configs SET nvt_count = nvt_count - %i + %i,"
-                   " nvts_growing = %i, family_count = family_count + %i,"
-                   " modification_time = m_now ()"
-                   " WHERE id = %llu;",
-                   old_nvt_count,
-                   new_nvt_count,
-                   growing_all
-                    ? 1
-                    /* Recalculate the NVT growing state. */
-                    : nvt_selector_nvts_growing_2 (quoted_selector,
-                                                   constraining),
-                   was_selected ? 0 : 1,
-                   config);
+              changed = 1;
             }
           else
             {
@@ -40435,8 +42404,6 @@ manage_set_config_families (const gchar *config_id,
 
                   if (old_nvt_count == max_nvt_count)
                     {
-                      iterator_t nvts;
-
                       /* All were selected.  Clear selection, ensuring that
                        * the family is growing in the process.  */
 
@@ -40453,27 +42420,13 @@ manage_set_config_families (const gchar *config_id,
 
                       /* Add an exclude for every NVT in the family. */
 
-                      init_nvt_iterator (&nvts, (nvt_t) 0, (config_t) 0,
-                                         family, NULL, 1, NULL);
-                      while (next (&nvts))
-                        nvt_selector_add (quoted_selector,
-                                          nvt_iterator_oid (&nvts),
-                                          quoted_family,
-                                          1);
-                      cleanup_iterator (&nvts);
-
-                      /* Update the cached config info. */
-
-                      sql ("UPDATE configs SET nvt_count = nvt_count - %i,"
-                           " nvts_growing = 1, modification_time = m_now ()"
-                           " WHERE id = %llu;",
-                           old_nvt_count,
-                           config);
+                      nvt_selector_add_family_nvts (quoted_selector,
+                                                    quoted_family,
+                                                    1);
+                      changed = 1;
                     }
                   else if (family_growing == 0)
                     {
-                      iterator_t nvts;
-
                       if (constraining == 0)
                         nvt_selector_add (quoted_selector,
                                           quoted_family,
@@ -40483,30 +42436,10 @@ manage_set_config_families (const gchar *config_id,
                       /* Remove any included NVT, add excludes for all
                        * other NVT's. */
 
-                      init_nvt_iterator (&nvts, (nvt_t) 0, (config_t) 0,
-                                         family, NULL, 1, NULL);
-                      while (next (&nvts))
-                        if (nvt_selector_has (quoted_selector,
-                                              nvt_iterator_oid (&nvts),
-                                              NVT_SELECTOR_TYPE_NVT,
-                                              0))
-                          nvt_selector_remove_selector
-                           (quoted_selector,
-                            nvt_iterator_oid (&nvts),
-                            NVT_SELECTOR_TYPE_NVT);
-                        else
-                          nvt_selector_add (quoted_selector,
-                                            nvt_iterator_oid (&nvts),
-                                            quoted_family,
-                                            1);
-                      cleanup_iterator (&nvts);
-
-                      /* Update the cached config info. */
-
-                      sql ("UPDATE configs SET nvts_growing = 1,"
-                           " modification_time = m_now ()"
-                           " WHERE id = %llu;",
-                           config);
+                      nvt_selector_invert_family_nvts (quoted_selector,
+                                                       quoted_family,
+                                                       1);
+                      changed = 1;
                     }
                 }
               else
@@ -40528,24 +42461,10 @@ manage_set_config_families (const gchar *config_id,
                                           quoted_family,
                                           NULL,
                                           1);
-
-                      /* Update the cached config info. */
-
-                      sql ("UPDATE configs SET nvts_growing = %i,"
-                           " nvt_count = nvt_count - %i,"
-                           " family_count = family_count - 1,"
-                           " modification_time = m_now ()"
-                           " WHERE id = %llu;",
-                           /* Recalculate the NVT growing state. */
-                           nvt_selector_nvts_growing_2 (quoted_selector,
-                                                        constraining),
-                           old_nvt_count,
-                           config);
+                      changed = 1;
                     }
                   else if (family_growing)
                     {
-                      iterator_t nvts;
-
                       if (constraining)
                         nvt_selector_add (quoted_selector,
                                           quoted_family,
@@ -40559,33 +42478,10 @@ manage_set_config_families (const gchar *config_id,
                       /* Remove any excluded NVT; add includes for all
                        * other NVT's. */
 
-                      init_nvt_iterator (&nvts, (nvt_t) 0, (config_t) 0,
-                                         family, NULL, 1, NULL);
-                      while (next (&nvts))
-                        if (nvt_selector_has (quoted_selector,
-                                              nvt_iterator_oid (&nvts),
-                                              NVT_SELECTOR_TYPE_NVT,
-                                              1))
-                          nvt_selector_remove_selector
-                            (quoted_selector,
-                             nvt_iterator_oid (&nvts),
-                             NVT_SELECTOR_TYPE_NVT);
-                        else
-                          nvt_selector_add (quoted_selector,
-                                            nvt_iterator_oid (&nvts),
-                                            quoted_family,
-                                            0);
-                      cleanup_iterator (&nvts);
-
-                      /* Update the cached config info. */
-
-                      sql ("UPDATE configs SET nvts_growing = %i,"
-                           " modification_time = m_now ()"
-                           " WHERE id = %llu;",
-                           /* Recalculate the NVT growing state. */
-                           nvt_selector_nvts_growing_2 (quoted_selector,
-                                                        constraining),
-                           config);
+                      nvt_selector_invert_family_nvts (quoted_selector,
+                                                       quoted_family,
+                                                       0);
+                      changed = 1;
                     }
                 }
             }
@@ -40595,6 +42491,17 @@ manage_set_config_families (const gchar *config_id,
     }
   cleanup_iterator (&families);
 
+  /* Update the cached config info. */
+
+  if (changed)
+    {
+      update_config_caches (config);
+      sql ("UPDATE configs SET modification_time = m_now ()"
+           " WHERE id = %llu;",
+           config);
+      config_otp_cache_clear (config);
+    }
+
   sql_commit ();
 
   g_free (quoted_selector);
@@ -41064,20 +42971,45 @@ manage_nvt_preferences_enable ()
        sql_schema ());
 }
 
+/**
+ * @brief SQL columns for an NVT preference iterator.
+ *
+ * The value of the preference in the config and the name of the NVT are
+ * included, so that these do not have to be looked up per preference.  The
+ * config value is ordered by type to ensure that the NVT pref comes first, in
+ * case an error in the GSA added the NVT pref as a Scanner pref.
+ */
+#define NVT_PREFERENCE_ITERATOR_COLUMNS                                      \
+  "nvt_preferences.name, nvt_preferences.value,"                             \
+  " (SELECT value FROM config_preferences"                                   \
+  "  WHERE config = %llu"                                                    \
+  "  AND config_preferences.name = nvt_preferences.name"                     \
+  "  ORDER BY type LIMIT 1),"                                                \
+  " CASE WHEN strpos (nvt_preferences.name, ':') > 0"                        \
+  "      THEN (SELECT nvts.name FROM nvts"                                   \
+  "            WHERE oid = substr (nvt_preferences.name, 1,"                 \
+  "                                strpos (nvt_preferences.name, ':') - 1)"  \
+  "            LIMIT 1)"                                                     \
+  "      ELSE NULL"                                                          \
+  "      END"
+
 /**
  * @brief Initialise an NVT preference iterator.
  *
  * @param[in]  iterator  Iterator.
  * @param[in]  oid       OID of NVT, NULL for all preferences.
+ * @param[in]  config    Config to get preference values from, 0 for none.
  */
 void
-init_nvt_preference_iterator (iterator_t* iterator, const char *oid)
+init_nvt_preference_iterator (iterator_t* iterator, const char *oid,
+                              config_t config)
 {
   if (oid)
     {
       gchar *quoted_oid = sql_quote (oid);
       init_iterator (iterator,
-                     "SELECT name, value FROM nvt_preferences"
+                     "SELECT " NVT_PREFERENCE_ITERATOR_COLUMNS
+                     " FROM nvt_preferences"
                      " WHERE name %s '%s:%%'"
                      " AND name != 'cache_folder'"
                      " AND name != 'include_folders'"
@@ -41090,6 +43022,7 @@ init_nvt_preference_iterator (iterator_t* iterator, const char *oid)
                      " AND name != 'max_checks'"
                      " AND name != 'max_hosts'"
                      " ORDER BY name ASC",
+                     config,
                      sql_ilike_op (),
                      quoted_oid,
                      quoted_oid,
@@ -41098,7 +43031,8 @@ init_nvt_preference_iterator (iterator_t* iterator, const char *oid)
     }
   else
     init_iterator (iterator,
-                   "SELECT name, value FROM nvt_preferences"
+                   "SELECT " NVT_PREFERENCE_ITERATOR_COLUMNS
+                   " FROM nvt_preferences"
                    " WHERE name != 'cache_folder'"
                    " AND name != 'include_folders'"
                    " AND name != 'nasl_no_signature_check'"
@@ -41110,10 +43044,13 @@ init_nvt_preference_iterator (iterator_t* iterator, const char *oid)
                    " AND name != 'max_checks'"
                    " AND name != 'max_hosts'"
                    " ORDER BY name ASC",
+                   config,
                    sql_ilike_op (),
                    sql_ilike_op ());
 }
 
+#undef NVT_PREFERENCE_ITERATOR_COLUMNS
+
 /**
  * @brief Get the name from an NVT preference iterator.
  *
@@ -41213,35 +43150,34 @@ nvt_preference_iterator_oid (iterator_t* iterator)
  * @brief Get the config value from an NVT preference iterator.
  *
  * @param[in]  iterator  Iterator.
- * @param[in]  config    Config.
  *
- * @return Freshly allocated config value.
+ * @return Freshly allocated config value, or the default value if the config
+ *         of the iterator does not set the preference.
  */
 char*
-nvt_preference_iterator_config_value (iterator_t* iterator, config_t config)
+nvt_preference_iterator_config_value (iterator_t* iterator)
 {
-  gchar *quoted_name, *value;
   const char *ret;
   if (iterator->done) return NULL;
 
-  quoted_name = sql_quote (iterator_string (iterator, 0));
-  value = sql_string ("SELECT value FROM config_preferences"
-                      " WHERE config = %llu"
-                      " AND name = '%s'"
-                      /* Ensure that the NVT pref comes first, in case an
-                       * error in the GSA added the NVT pref as a Scanner
-                       * pref. */
-                      " ORDER BY type",
-                      config,
-                      quoted_name);
-  g_free (quoted_name);
-  if (value) return value;
+  ret = iterator_string (iterator, 2);
+  if (ret) return g_strdup (ret);
 
   ret = iterator_string (iterator, 1);
   if (ret) return g_strdup (ret);
   return NULL;
 }
 
+/**
+ * @brief Get the NVT name from an NVT preference iterator.
+ *
+ * @param[in]  iterator  Iterator.
+ *
+ * @return Name of the NVT of the preference, or NULL.  Freed by
+ *         cleanup_iterator.
+ */
+DEF_ACCESS (nvt_preference_iterator_nvt_name, 3);
+
 /**
  * @brief Get the number preferences available for an NVT.
  *
@@ -46031,10 +47967,7 @@ create_override (const char* active, const char* nvt, const char* text,
   gchar *quoted_text, *quoted_hosts, *quoted_port, *quoted_severity;
   double severity_dbl, new_severity_dbl;
   GHashTable *reports;
-  GHashTableIter reports_iter;
-  report_t *reports_ptr;
   gchar *override_id, *users_where;
-  int auto_cache_rebuild;
   override_t new_override;
 
   if (acl_user_may ("create_override") == 0)
@@ -46177,17 +48110,7 @@ create_override (const char* active, const char* nvt, const char* text,
                                              "id");
 
   reports = reports_for_override (new_override);
-  reports_ptr = NULL;
-  g_hash_table_iter_init (&reports_iter, reports);
-  auto_cache_rebuild = setting_auto_cache_rebuild_int ();
-  while (g_hash_table_iter_next (&reports_iter,
-                                 ((gpointer*)&reports_ptr), NULL))
-    {
-      if (auto_cache_rebuild)
-        report_cache_counts (*reports_ptr, 0, 1, users_where);
-      else
-        report_clear_count_cache (*reports_ptr, 0, 1, users_where);
-    }
+  reports_refresh_override_counts (reports, users_where);
   g_hash_table_destroy (reports);
   g_free (override_id);
   g_free (users_where);
@@ -46242,10 +48165,7 @@ delete_override (const char *override_id, int ultimate)
 {
   override_t override;
   GHashTable *reports;
-  GHashTableIter reports_iter;
-  report_t *reports_ptr;
   gchar *users_where;
-  int auto_cache_rebuild;
 
   sql_begin_immediate ();
 
@@ -46321,17 +48241,7 @@ delete_override (const char *override_id, int ultimate)
 
   sql ("DELETE FROM overrides WHERE id = %llu;", override);
 
-  g_hash_table_iter_init (&reports_iter, reports);
-  reports_ptr = NULL;
-  auto_cache_rebuild = setting_auto_cache_rebuild_int ();
-  while (g_hash_table_iter_next (&reports_iter,
-                                 ((gpointer*)&reports_ptr), NULL))
-    {
-      if (auto_cache_rebuild)
-        report_cache_counts (*reports_ptr, 0, 1, users_where);
-      else
-        report_clear_count_cache (*reports_ptr, 0, 1, users_where);
-    }
+  reports_refresh_override_counts (reports, users_where);
   g_hash_table_destroy (reports);
   g_free (users_where);
 
@@ -46662,27 +48572,13 @@ modify_override (const gchar *override_id, const char *active, const char *nvt,
 
   if (cache_invalidated)
     {
-      GHashTableIter reports_iter;
-      report_t *reports_ptr;
       gchar *users_where;
-      int auto_cache_rebuild;
 
       users_where = acl_users_with_access_where ("override", override_id, NULL,
                                                  "id");
 
       reports_add_for_override (reports, override);
-
-      g_hash_table_iter_init (&reports_iter, reports);
-      reports_ptr = NULL;
-      auto_cache_rebuild = setting_auto_cache_rebuild_int ();
-      while (g_hash_table_iter_next (&reports_iter,
-                                    ((gpointer*)&reports_ptr), NULL))
-        {
-          if (auto_cache_rebuild)
-            report_cache_counts (*reports_ptr, 0, 1, users_where);
-          else
-            report_clear_count_cache (*reports_ptr, 0, 1, users_where);
-        }
+      reports_refresh_override_counts (reports, users_where);
       g_free (users_where);
     }
 
@@ -56693,6 +58589,84 @@ ranges_sort_merge (array_t *ranges)
     }
 }
 
+/**
+ * @brief Rebuild the compiled port set of a port list.
+ *
+ * The compiled set is the port list's ranges, sorted and merged into
+ * non-overlapping intervals per protocol.  Target port ranges, port counts
+ * and the port_list result filter read from it instead of the raw ranges.
+ *
+ * @param[in]  port_list  Port list.
+ * @param[in]  trash      Whether the port list is in the trashcan.
+ */
+static void
+port_list_compile (port_list_t port_list, int trash)
+{
+  iterator_t ranges;
+  array_t *intervals;
+  range_t *range;
+  int index;
+
+  sql ("DELETE FROM port_list_intervals%s WHERE port_list = %llu;",
+       trash ? "_trash" : "",
+       port_list);
+
+  intervals = make_array ();
+  init_iterator (&ranges,
+                 "SELECT type, start, \"end\" FROM port_ranges%s"
+                 " WHERE port_list = %llu;",
+                 trash ? "_trash" : "",
+                 port_list);
+  while (next (&ranges))
+    {
+      range = g_malloc0 (sizeof (range_t));
+      range->type = iterator_int (&ranges, 0);
+      range->start = iterator_int (&ranges, 1);
+      range->end = iterator_int (&ranges, 2);
+      if (range->end < range->start)
+        range->end = range->start;
+      array_add (intervals, range);
+    }
+  cleanup_iterator (&ranges);
+
+  ranges_sort_merge (intervals);
+  array_terminate (intervals);
+  index = 0;
+  while ((range = (range_t*) g_ptr_array_index (intervals, index++)))
+    sql ("INSERT INTO port_list_intervals%s"
+         " (port_list, type, start, \"end\")"
+         " VALUES (%llu, %i, %i, %i);",
+         trash ? "_trash" : "",
+         port_list,
+         range->type,
+         range->start,
+         range->end);
+  array_free (intervals);
+}
+
+/**
+ * @brief Compile every port list that has no compiled port set yet.
+ */
+static void
+port_lists_compile_missing ()
+{
+  iterator_t port_lists;
+
+  init_iterator (&port_lists,
+                 "SELECT id, 0 FROM port_lists"
+                 " WHERE id NOT IN (SELECT port_list FROM port_list_intervals)"
+                 " AND id IN (SELECT port_list FROM port_ranges)"
+                 " UNION ALL"
+                 " SELECT id, 1 FROM port_lists_trash"
+                 " WHERE id NOT IN (SELECT port_list"
+                 "                  FROM port_list_intervals_trash)"
+                 " AND id IN (SELECT port_list FROM port_ranges_trash);");
+  while (next (&port_lists))
+    port_list_compile (iterator_int64 (&port_lists, 0),
+                       iterator_int (&port_lists, 1));
+  cleanup_iterator (&port_lists);
+}
+
 /**
  * @brief Create a port list, with database locked.
  *
@@ -56754,6 +58728,7 @@ create_port_list_lock (const char *quoted_id, const char *quoted_name,
          range->start,
          range->end,
          range->exclude);
+  port_list_compile (*port_list, 0);
   return 0;
 }
 
@@ -57011,6 +58986,7 @@ copy_port_list (const char* name, const char* comment,
        "  FROM port_ranges WHERE port_list = %llu;",
        new,
        old);
+  port_list_compile (new, 0);
 
   sql_commit ();
   if (new_port_list) *new_port_list = new;
@@ -57201,6 +59177,8 @@ create_port_range (const char *port_list_id, const char *type,
   if (port_range_return)
     *port_range_return = sql_last_insert_id ();
 
+  port_list_compile (port_list, 0);
+
   sql_commit ();
 
   return 0;
@@ -57276,6 +59254,8 @@ delete_port_list (const char *port_list_id, int ultimate)
       permissions_set_orphans ("port_list", port_list, LOCATION_TRASH);
       tags_remove_resource ("port_list", port_list, LOCATION_TRASH);
 
+      sql ("DELETE FROM port_list_intervals_trash WHERE port_list = %llu;",
+           port_list);
       sql ("DELETE FROM port_ranges_trash WHERE port_list = %llu;", port_list);
       sql ("DELETE FROM port_lists_trash WHERE id = %llu;", port_list);
       sql_commit ();
@@ -57309,6 +59289,7 @@ delete_port_list (const char *port_list_id, int ultimate)
            " FROM port_ranges WHERE port_list = %llu;",
            trash_port_list,
            port_list);
+      port_list_compile (trash_port_list, 1);
 
       /* Update the location of the port_list in any trashcan targets. */
       sql ("UPDATE targets_trash"
@@ -57330,6 +59311,7 @@ delete_port_list (const char *port_list_id, int ultimate)
       tags_remove_resource ("port_list", port_list, LOCATION_TABLE);
     }
 
+  sql ("DELETE FROM port_list_intervals WHERE port_list = %llu;", port_list);
   sql ("DELETE FROM port_ranges WHERE port_list = %llu;", port_list);
   sql ("DELETE FROM port_lists WHERE id = %llu;", port_list);
 
@@ -57372,6 +59354,7 @@ int
 delete_port_range (const char *port_range_id, int dummy)
 {
   port_range_t port_range = 0;
+  port_list_t port_list;
 
   sql_begin_immediate ();
 
@@ -57410,7 +59393,11 @@ delete_port_range (const char *port_range_id, int dummy)
         port_range))
     return 3;
 
+  port_list = sql_int64_0 ("SELECT port_list FROM port_ranges"
+                           " WHERE id = %llu;",
+                           port_range);
   sql ("DELETE FROM port_ranges WHERE id = %llu;", port_range);
+  port_list_compile (port_list, 0);
 
   sql_commit ();
   return 0;
@@ -57430,39 +59417,22 @@ delete_port_range (const char *port_range_id, int dummy)
    GET_ITERATOR_COLUMNS (port_lists),                              \
    {                                                               \
      /* COUNT ALL ports */                                         \
-     "(SELECT"                                                     \
-     " sum ((CASE"                                                 \
-     "       WHEN \"end\" IS NULL THEN start ELSE \"end\""         \
-     "       END)"                                                 \
-     "      - start"                                               \
-     "      + 1)"                                                  \
-     " FROM port_ranges WHERE port_list = port_lists.id)",         \
+     "(SELECT sum (\"end\" - start + 1) FROM port_list_intervals"  \
+     " WHERE port_list = port_lists.id)",                          \
      "total",                                                      \
      KEYWORD_TYPE_INTEGER                                          \
    },                                                              \
    {                                                               \
      /* COUNT TCP ports */                                         \
-     "(SELECT"                                                     \
-     " sum ((CASE"                                                 \
-     "       WHEN \"end\" IS NULL THEN start ELSE \"end\""         \
-     "       END)"                                                 \
-     "      - start"                                               \
-     "      + 1)"                                                  \
-     " FROM port_ranges WHERE port_list = port_lists.id"           \
-     "                  AND   type = 0)",                          \
+     "(SELECT sum (\"end\" - start + 1) FROM port_list_intervals"  \
+     " WHERE port_list = port_lists.id AND type = 0)",             \
      "tcp",                                                        \
      KEYWORD_TYPE_INTEGER                                          \
    },                                                              \
    {                                                               \
      /* COUNT UDP ports */                                         \
-     "(SELECT"                                                     \
-     " sum ((CASE"                                                 \
-     "       WHEN \"end\" IS NULL THEN start ELSE \"end\""         \
-     "       END)"                                                 \
-     "      - start"                                               \
-     "      + 1)"                                                  \
-     " FROM port_ranges WHERE port_list = port_lists.id"           \
-     "                  AND   type = 1)",                          \
+     "(SELECT sum (\"end\" - start + 1) FROM port_list_intervals"  \
+     " WHERE port_list = port_lists.id AND type = 1)",             \
      "udp",                                                        \
      KEYWORD_TYPE_INTEGER                                          \
    },                                                              \
@@ -57477,39 +59447,24 @@ delete_port_range (const char *port_range_id, int dummy)
    GET_ITERATOR_COLUMNS (port_lists_trash),                        \
    {                                                               \
      /* COUNT ALL ports */                                         \
-     "(SELECT"                                                     \
-     " sum ((CASE"                                                 \
-     "       WHEN \"end\" IS NULL THEN start ELSE \"end\""         \
-     "       END)"                                                 \
-     "      - start"                                               \
-     "      + 1)"                                                  \
-     " FROM port_ranges_trash"                                     \
+     "(SELECT sum (\"end\" - start + 1)"                           \
+     " FROM port_list_intervals_trash"                             \
      " WHERE port_list = port_lists_trash.id)",                    \
      "total",                                                      \
      KEYWORD_TYPE_INTEGER                                          \
    },                                                              \
    {                                                               \
      /* COUNT TCP ports */                                         \
-     "(SELECT"                                                     \
-     " sum ((CASE"                                                 \
-     "       WHEN \"end\" IS NULL THEN start ELSE \"end\""         \
-     "       END)"                                                 \
-     "      - start"                                               \
-     "      + 1)"                                                  \
-     " FROM port_ranges_trash"                                     \
+     "(SELECT sum (\"end\" - start + 1)"                           \
+     " FROM port_list_intervals_trash"                             \
      " WHERE port_list = port_lists_trash.id AND type = 0)",       \
      "tcp",                                                        \
      KEYWORD_TYPE_INTEGER                                          \
    },                                                              \
    {                                                               \
      /* COUNT UDP ports */                                         \
-     "(SELECT"                                                     \
-     " sum ((CASE"                                                 \
-     "       WHEN \"end\" IS NULL THEN start ELSE \"end\""         \
-     "       END)"                                                 \
-     "      - start"                                               \
-     "      + 1)"                                                  \
-     " FROM port_ranges_trash"                                     \
+     "(SELECT sum (\"end\" - start + 1)"                           \
+     " FROM port_list_intervals_trash"                             \
      " WHERE port_list = port_lists_trash.id AND type = 1)",       \
      "udp",                                                        \
      KEYWORD_TYPE_INTEGER                                          \
@@ -60140,10 +62095,7 @@ manage_restore (const char *id)
     {
       override_t override;
       GHashTable *reports;
-      GHashTableIter reports_iter;
-      report_t *reports_ptr;
       gchar *users_where;
-      int auto_cache_rebuild;
 
       sql ("INSERT INTO overrides"
            " (uuid, owner, nvt, creation_time, modification_time, text, hosts,"
@@ -60166,17 +62118,7 @@ manage_restore (const char *id)
                                                  "id");
 
       reports = reports_for_override (override);
-      g_hash_table_iter_init (&reports_iter, reports);
-      reports_ptr = NULL;
-      auto_cache_rebuild = setting_auto_cache_rebuild_int ();
-      while (g_hash_table_iter_next (&reports_iter,
-                                    ((gpointer*)&reports_ptr), NULL))
-        {
-          if (auto_cache_rebuild)
-            report_cache_counts (*reports_ptr, 0, 1, users_where);
-          else
-            report_clear_count_cache (*reports_ptr, 0, 1, users_where);
-        }
+      reports_refresh_override_counts (reports, users_where);
       g_hash_table_destroy (reports);
       g_free (users_where);
 
@@ -60316,6 +62258,7 @@ manage_restore (const char *id)
            " FROM port_ranges_trash WHERE port_list = %llu;",
            table_port_list,
            resource);
+      port_list_compile (table_port_list, 0);
 
       /* Update the port_list in any trashcan targets. */
       sql ("UPDATE targets_trash"
@@ -60332,6 +62275,8 @@ manage_restore (const char *id)
                           sql_last_insert_id (),
                           LOCATION_TABLE);
 
+      sql ("DELETE FROM port_list_intervals_trash WHERE port_list = %llu;",
+           resource);
       sql ("DELETE FROM port_ranges_trash WHERE port_list = %llu;", resource);
       sql ("DELETE FROM port_lists_trash WHERE id = %llu;", resource);
       sql_commit ();
@@ -60832,10 +62777,10 @@ manage_restore (const char *id)
       sql ("INSERT INTO results"
            " (uuid, task, host, port, nvt, result_nvt, type, description,"
            "  report, nvt_version, severity, qod, qod_type, owner, date,"
-           "  hostname)"
+           "  hostname, host_inet)"
            " SELECT uuid, task, host, port, nvt, result_nvt, type,"
            "        description, report, nvt_version, severity, qod,"
-           "         qod_type, owner, date, hostname"
+           "         qod_type, owner, date, hostname, host_inet (host)"
            " FROM results_trash"
            " WHERE report IN (SELECT id FROM reports WHERE task = %llu);",
            resource);
@@ -60852,6 +62797,8 @@ manage_restore (const char *id)
       sql ("DELETE FROM report_counts"
            " WHERE report IN (SELECT id FROM reports WHERE task = %llu);",
            resource);
+      sql ("DELETE FROM task_report_summaries WHERE task = %llu;",
+           resource);
 
       sql ("UPDATE tasks SET hidden = 0 WHERE id = %llu;", resource);
 
@@ -60944,6 +62891,11 @@ manage_empty_trashcan ()
   sql ("DELETE FROM notes_trash" WHERE_OWNER);
   sql ("DELETE FROM overrides_trash" WHERE_OWNER);
   sql ("DELETE FROM permissions_trash" WHERE_OWNER);
+  sql ("DELETE FROM port_list_intervals_trash"
+       " WHERE port_list IN (SELECT id from port_lists_trash"
+       "                     WHERE owner = (SELECT id FROM users"
+       "                                    WHERE uuid = '%s'));",
+       current_credentials.uuid);
   sql ("DELETE FROM port_ranges_trash"
        " WHERE port_list IN (SELECT id from port_lists_trash"
        "                     WHERE owner = (SELECT id FROM users"
@@ -60978,11 +62930,7 @@ manage_empty_trashcan ()
        "                                 WHERE uuid = '%s'));",
        current_credentials.uuid);
   sql ("DELETE FROM targets_trash" WHERE_OWNER);
-  if (delete_trash_tasks ())
-    {
-      sql_rollback ();
-      return -1;
-    }
+  hide_trash_tasks ();
 
   sql ("UPDATE permissions"
        " SET resource = -1"
@@ -61193,12 +63141,13 @@ manage_report_host_add (report_t report, const char *host, time_t start,
   char *quoted_host = sql_quote (host);
 
   sql ("INSERT INTO report_hosts"
-       " (report, host, start_time, end_time, current_port, max_port)"
-       " SELECT %llu, '%s', %lld, %lld, 0, 0"
+       " (report, host, start_time, end_time, current_port, max_port,"
+       "  host_inet)"
+       " SELECT %llu, '%s', %lld, %lld, 0, 0, host_inet ('%s')"
        " WHERE NOT EXISTS (SELECT 1 FROM report_hosts WHERE report = %llu"
        "                   AND host = '%s');",
-       report, quoted_host, (long long) start, (long long) end, report,
-       quoted_host);
+       report, quoted_host, (long long) start, (long long) end, quoted_host,
+       report, quoted_host);
   g_free (quoted_host);
   return sql_last_insert_id ();
 }
@@ -63732,6 +65681,12 @@ modify_setting (const gchar *uuid, const gchar *name,
           /* Severity Class */
           g_free (current_credentials.severity_class);
           current_credentials.severity_class = g_strdup (value);
+
+          /* The level counts in the summaries depend on the class. */
+          sql ("DELETE FROM task_report_summaries"
+               " WHERE \"user\" = (SELECT id FROM users"
+               "                   WHERE uuid = '%s');",
+               current_credentials.uuid);
         }
 
       if (strcmp (uuid, "77ec2444-e7f2-4a80-a59b-f4237782d93f") == 0)
@@ -65116,6 +67071,7 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
   user_t user, inheritor;
   get_data_t get;
   char *current_uuid;
+  gchar *where;
 
   assert (user_id_arg || name_arg);
 
@@ -65354,6 +67310,8 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
            inheritor, user);
       sql ("UPDATE report_counts SET \"user\" = %llu WHERE \"user\" = %llu",
            inheritor, user);
+      sql ("DELETE FROM task_report_summaries WHERE \"user\" = %llu;",
+           user);
       sql ("UPDATE reports SET owner = %llu WHERE owner = %llu;",
            inheritor, user);
       sql ("UPDATE results SET owner = %llu WHERE owner = %llu;",
@@ -65479,13 +67437,21 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
   sql ("DELETE FROM report_counts"
        " WHERE report IN (SELECT id FROM reports WHERE owner = %llu);",
        user);
+  sql ("DELETE FROM report_counts_refresh WHERE \"user\" = %llu", user);
+  sql ("DELETE FROM report_counts_refresh"
+       " WHERE report IN (SELECT id FROM reports WHERE owner = %llu);",
+       user);
+  sql ("DELETE FROM task_report_summaries WHERE \"user\" = %llu", user);
+  sql ("DELETE FROM task_report_summaries"
+       " WHERE report IN (SELECT id FROM reports WHERE owner = %llu);",
+       user);
 
   /* Hosts. */
-  sql ("DELETE FROM report_host_details"
-       " WHERE report_host IN (SELECT id FROM report_hosts"
-       "                       WHERE report IN (SELECT id FROM reports"
-       "                                        WHERE owner = %llu));",
-       user);
+  where = g_strdup_printf ("report IN (SELECT id FROM reports"
+                           "           WHERE owner = %llu)",
+                           user);
+  delete_report_host_details (where);
+  g_free (where);
   sql ("DELETE FROM report_hosts"
        " WHERE report IN (SELECT id FROM reports WHERE owner = %llu);",
        user);
@@ -65574,6 +67540,9 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
   sql ("DELETE FROM config_preferences_trash"
        " WHERE config IN (SELECT id FROM configs_trash WHERE owner = %llu);",
        user);
+  sql ("DELETE FROM config_otp_caches"
+       " WHERE config IN (SELECT id FROM configs WHERE owner = %llu);",
+       user);
   sql ("DELETE FROM configs WHERE owner = %llu;", user);
   sql ("DELETE FROM configs_trash WHERE owner = %llu;", user);
 
@@ -65635,9 +67604,16 @@ delete_user (const char *user_id_arg, const char *name_arg, int ultimate,
       sql_rollback ();
       return 9;
     }
+  sql ("DELETE FROM port_list_intervals"
+       " WHERE port_list IN (SELECT id FROM port_lists WHERE owner = %llu);",
+       user);
   sql ("DELETE FROM port_ranges"
        " WHERE port_list IN (SELECT id FROM port_lists WHERE owner = %llu);",
        user);
+  sql ("DELETE FROM port_list_intervals_trash"
+       " WHERE port_list IN (SELECT id FROM port_lists_trash"
+       "                     WHERE owner = %llu);",
+       user);
   sql ("DELETE FROM port_ranges_trash"
        " WHERE port_list IN (SELECT id FROM port_lists_trash"
        "                     WHERE owner = %llu);",
@@ -68671,6 +70647,8 @@ type_table (const char *type, int trash)
     return NULL;
   else if (strcasecmp (type, "ALLINFO") == 0)
     {
+      if (secinfo_index_ready ())
+        return g_strdup ("secinfo_index AS allinfo");
       return g_strdup (ALL_INFO_UNION_COLUMNS);
     }
   else if (trash && type_trash_in_table (type) == 0)
@@ -69141,6 +71119,302 @@ delete_permissions_cache_for_user (user_t user)
 
 /* Optimize. */
 
+/**
+ * @brief Number of slow queries with a shape before an index is advised.
+ *
+ * Slow queries are sampled, so this stands for about
+ * ADVISE_INDEX_MIN_QUERIES * SLOW_FILTER_QUERY_SAMPLE slow counts.
+ */
+#define ADVISE_INDEX_MIN_QUERIES 5
+
+/**
+ * @brief Seconds that slow filter queries are kept for the index advisor.
+ */
+#define SLOW_FILTER_QUERY_KEEP_SECONDS (30 * 24 * 60 * 60)
+
+/**
+ * @brief Maximum number of slow filter queries kept for the index advisor.
+ */
+#define SLOW_FILTER_QUERY_MAX_ROWS 10000
+
+/**
+ * @brief Seconds between prunes of the slow filter queries.
+ */
+#define SLOW_FILTER_QUERY_PRUNE_SECONDS 3600
+
+/**
+ * @brief Remove old slow filter queries, and cap the number kept.
+ *
+ * In gvmd, periodically called from the main daemon loop.
+ */
+void
+manage_prune_slow_filter_queries ()
+{
+  static time_t last_prune = 0;
+  time_t now;
+
+  now = time (NULL);
+  if (now - last_prune < SLOW_FILTER_QUERY_PRUNE_SECONDS)
+    return;
+  last_prune = now;
+
+  sql ("DELETE FROM slow_filter_queries"
+       " WHERE time < m_now () - %i"
+       " OR id <= (SELECT max (id) FROM slow_filter_queries) - %i;",
+       SLOW_FILTER_QUERY_KEEP_SECONDS,
+       SLOW_FILTER_QUERY_MAX_ROWS);
+}
+
+/**
+ * @brief Get the name of the index advised for a query shape.
+ *
+ * @param[in]  table  Table.
+ * @param[in]  shape  Shape, as logged by log_slow_filter_query.
+ *
+ * @return Freshly allocated index name.
+ */
+static gchar *
+advised_index_name (const char *table, const char *shape)
+{
+  gchar *checksum, *name;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, shape, -1);
+  name = g_strdup_printf ("advised_%s_%.8s", table, checksum);
+  g_free (checksum);
+  return name;
+}
+
+/**
+ * @brief Check whether an index should be advised for a query shape.
+ *
+ * @param[in]  table  Table.
+ * @param[in]  shape  Shape, as logged by log_slow_filter_query.
+ * @param[in]  name   Name of the advised index.
+ *
+ * @return 0 if an index should be advised, 1 if the shape is already
+ *         covered by an index, -1 if the shape does not fit the table.
+ */
+static int
+advised_index_check (const char *table, const char *shape, const char *name)
+{
+  gchar **expressions, **point;
+  int indexed;
+
+  if (plain_column (table, NULL) == NULL)
+    return -1;
+
+  if (manage_index_exists (name))
+    return 1;
+
+  indexed = 0;
+  expressions = g_strsplit (shape, ", ", 0);
+  for (point = expressions; *point; point++)
+    {
+      gchar *column;
+
+      if (g_str_has_prefix (*point, "CAST (") && strstr (*point, " AS "))
+        {
+          /* Older SQLite versions cannot index expressions. */
+          if (manage_expression_indexes ())
+            column = g_strndup (*point + strlen ("CAST ("),
+                                strstr (*point, " AS ") - *point
+                                - strlen ("CAST ("));
+          else
+            column = NULL;
+        }
+      else
+        column = g_strdup (*point);
+
+      if (column == NULL || plain_column (column, NULL) == NULL)
+        indexed = -1;
+      else
+        {
+          int ret;
+
+          ret = manage_column_indexed (table, column);
+          if (ret == -1)
+            indexed = -1;
+          else if (point == expressions
+                   && expressions[1] == NULL
+                   && strcmp (column, *point) == 0)
+            /* A plain index on the column already covers the shape. */
+            indexed = ret;
+        }
+      g_free (column);
+      if (indexed == -1)
+        break;
+    }
+  g_strfreev (expressions);
+  return indexed;
+}
+
+/**
+ * @brief Print how the indexes created by the advisor have done.
+ *
+ * Compares the slow queries logged for the shape of each index before it
+ * was created with the ones logged since.
+ */
+static void
+print_advised_indexes ()
+{
+  iterator_t indexes;
+
+  init_iterator (&indexes,
+                 "SELECT name, table_name, shape, slow_count, slow_duration,"
+                 "       (SELECT count (*) FROM slow_filter_queries"
+                 "        WHERE table_name = advised_indexes.table_name"
+                 "        AND shape = advised_indexes.shape"
+                 "        AND time >= advised_indexes.creation_time),"
+                 "       (SELECT CAST (coalesce (avg (duration), 0)"
+                 "                     AS integer)"
+                 "        FROM slow_filter_queries"
+                 "        WHERE table_name = advised_indexes.table_name"
+                 "        AND shape = advised_indexes.shape"
+                 "        AND time >= advised_indexes.creation_time),"
+                 "       (m_now () - creation_time) / 86400"
+                 " FROM advised_indexes"
+                 " ORDER BY creation_time;");
+  while (next (&indexes))
+    printf ("Advised index %s ON %s (%s): %i slow queries averaging %i ms"
+            " before creation, %i averaging %i ms in the %i days since.\n",
+            iterator_string (&indexes, 0),
+            iterator_string (&indexes, 1),
+            iterator_string (&indexes, 2),
+            iterator_int (&indexes, 3),
+            iterator_int (&indexes, 4),
+            iterator_int (&indexes, 5),
+            iterator_int (&indexes, 6),
+            iterator_int (&indexes, 7));
+  cleanup_iterator (&indexes);
+}
+
+/**
+ * @brief An index advised for a query shape.
+ */
+typedef struct
+{
+  gchar *name;   ///< Name of index.
+  gchar *table;  ///< Table.
+  gchar *shape;  ///< Shape, which is also the indexed expressions.
+  int count;     ///< Number of slow queries with the shape.
+  int duration;  ///< Average duration of the slow queries, in milliseconds.
+} advised_index_t;
+
+/**
+ * @brief Free an advised index.
+ *
+ * @param[in]  advised  Advised index.
+ */
+static void
+advised_index_free (advised_index_t *advised)
+{
+  g_free (advised->name);
+  g_free (advised->table);
+  g_free (advised->shape);
+  g_free (advised);
+}
+
+/**
+ * @brief Advise indexes for the shapes of frequent slow filter queries.
+ *
+ * @param[in]  create  Whether to create the advised indexes, instead of
+ *                     only printing them.  On Postgres the indexes are
+ *                     built concurrently, so that the tables stay writable.
+ *
+ * @return Number of indexes advised or created.
+ */
+static int
+advise_indexes (int create)
+{
+  iterator_t shapes;
+  GSList *advice, *list;
+  int count;
+
+  sql ("DELETE FROM slow_filter_queries WHERE time < m_now () - %i;",
+       SLOW_FILTER_QUERY_KEEP_SECONDS);
+
+  if (create == 0)
+    print_advised_indexes ();
+
+  /* Collect the shapes first, so that no statement is active while the
+   * indexes are created. */
+  advice = NULL;
+  init_iterator (&shapes,
+                 "SELECT table_name, shape, count (*),"
+                 "       CAST (avg (duration) AS integer)"
+                 " FROM slow_filter_queries"
+                 " GROUP BY table_name, shape"
+                 " HAVING count (*) >= %i"
+                 " ORDER BY count (*) DESC;",
+                 ADVISE_INDEX_MIN_QUERIES);
+  while (next (&shapes))
+    {
+      const char *table, *shape;
+      advised_index_t *advised;
+      gchar *name;
+
+      table = iterator_string (&shapes, 0);
+      shape = iterator_string (&shapes, 1);
+      if (table == NULL || shape == NULL)
+        continue;
+
+      name = advised_index_name (table, shape);
+      if (advised_index_check (table, shape, name))
+        {
+          g_free (name);
+          continue;
+        }
+
+      advised = g_malloc (sizeof (advised_index_t));
+      advised->name = name;
+      advised->table = g_strdup (table);
+      advised->shape = g_strdup (shape);
+      advised->count = iterator_int (&shapes, 2);
+      advised->duration = iterator_int (&shapes, 3);
+      advice = g_slist_append (advice, advised);
+    }
+  cleanup_iterator (&shapes);
+
+  count = 0;
+  for (list = advice; list; list = list->next)
+    {
+      advised_index_t *advised;
+      gchar *quoted_shape;
+
+      advised = list->data;
+
+      if (create == 0)
+        {
+          printf ("Proposed index %s ON %s (%s): %i slow queries averaging"
+                  " %i ms.\n",
+                  advised->name, advised->table, advised->shape,
+                  advised->count, advised->duration);
+          count++;
+        }
+      else if (manage_create_index (advised->name, advised->table,
+                                    advised->shape, 1)
+               == 0)
+        {
+          quoted_shape = sql_quote (advised->shape);
+          sql ("DELETE FROM advised_indexes WHERE name = '%s';",
+               advised->name);
+          sql ("INSERT INTO advised_indexes"
+               " (name, table_name, shape, creation_time, slow_count,"
+               "  slow_duration)"
+               " VALUES ('%s', '%s', '%s', m_now (), %i, %i);",
+               advised->name, advised->table, quoted_shape,
+               advised->count, advised->duration);
+          g_free (quoted_shape);
+          printf ("Created index %s ON %s (%s).\n",
+                  advised->name, advised->table, advised->shape);
+          count++;
+        }
+    }
+  g_slist_free_full (advice, (GDestroyNotify) advised_index_free);
+
+  return count;
+}
+
 /**
  * @brief Run one of the optimizations.
  *
@@ -69225,6 +71499,16 @@ manage_optimize (GSList *log_config, const gchar *database, const gchar *name)
       sql ("ANALYZE;");
       success_text = g_strdup_printf ("Optimized: analyze.");
     }
+  else if (strcasecmp (name, "advise-indexes") == 0)
+    {
+      int proposed;
+
+      proposed = advise_indexes (0);
+
+      success_text = g_strdup_printf ("Optimized: advise-indexes."
+                                      " Indexes proposed: %d.",
+                                      proposed);
+    }
   else if (strcasecmp (name, "cleanup-config-prefs") == 0)
     {
       int removed, fixed_values;
@@ -69315,6 +71599,16 @@ manage_optimize (GSList *log_config, const gchar *database, const gchar *name)
                                       " Due date updated for %d tasks.",
                                       changes);
     }
+  else if (strcasecmp (name, "create-advised-indexes") == 0)
+    {
+      int created;
+
+      created = advise_indexes (1);
+
+      success_text = g_strdup_printf ("Optimized: create-advised-indexes."
+                                      " Indexes created: %d.",
+                                      created);
+    }
   else if (strcasecmp (name, "rebuild-permissions-cache") == 0)
     {
       sql_begin_immediate ();
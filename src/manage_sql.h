@@ -276,6 +276,19 @@ name (iterator_t* iterator)                                       \
 }
 
 
+/* Index definitions. */
+
+/**
+ * @brief Database index.
+ */
+typedef struct
+{
+  const char *name;    ///< Name of index.
+  const char *table;   ///< Table the index is on.
+  const char *columns; ///< Indexed columns or expressions.
+} db_index_t;
+
+
 /* Iterator definitions. */
 
 /**
@@ -357,6 +370,16 @@ typedef long long int rowid_t;
 
 int manage_db_empty ();
 
+int manage_index_exists (const char *);
+
+int manage_column_indexed (const char *, const char *);
+
+int manage_expression_indexes ();
+
+int manage_transaction_read_only ();
+
+int manage_create_index (const char *, const char *, const char *, int);
+
 gboolean
 host_nthlast_report_host (const char *, report_host_t *, int);
 
@@ -391,6 +414,11 @@ void init_otp_pref_iterator (iterator_t *, config_t, const char *);
 const char *otp_pref_iterator_name (iterator_t *);
 const char *otp_pref_iterator_value (iterator_t *);
 
+int config_otp_cache (config_t, gchar **, gchar **, gchar **);
+
+void set_config_otp_cache (config_t, const gchar *, const gchar *,
+                           const gchar *);
+
 port_list_t target_port_list (target_t);
 credential_t target_ssh_credential (target_t);
 credential_t target_smb_credential (target_t);
@@ -538,4 +566,37 @@ int
 create_permission_internal (const char *, const char *, const char *, const char *,
                             const char *, const char *, permission_t *);
 
+char *
+scan_start_time (report_t);
+
+char *
+scan_end_time (report_t);
+
+const char *
+result_iterator_type (iterator_t *);
+
+const char *
+result_iterator_severity (iterator_t *);
+
+report_host_t
+host_iterator_report_host (iterator_t *);
+
+void
+init_report_host_details_iterator (iterator_t *, report_host_t);
+
+const char *
+report_host_details_iterator_name (iterator_t *);
+
+const char *
+report_host_details_iterator_value (iterator_t *);
+
+const char *
+report_host_details_iterator_source_type (iterator_t *);
+
+const char *
+report_host_details_iterator_source_name (iterator_t *);
+
+const char *
+report_host_details_iterator_source_desc (iterator_t *);
+
 #endif /* not _GVMD_MANAGE_SQL_H */
@@ -35,6 +35,7 @@
 
 #include "manage_sql.h"
 #include "manage_sql_nvts.h"
+#include "manage_sql_secinfo.h"
 #include "sql.h"
 #include "utils.h"
 
@@ -73,6 +74,17 @@ check_db_nvts ()
   /* Ensure the NVT CVE table is filled. */
   if (sql_int ("SELECT count (*) FROM nvt_cves;") == 0)
     refresh_nvt_cves ();
+
+  /* Ensure the NVT XML caches match the NVTs and the CERT database. */
+  if (sql_int ("SELECT EXISTS (SELECT * FROM nvts"
+               "               WHERE NOT EXISTS"
+               "                      (SELECT * FROM nvt_xml_caches"
+               "                       WHERE oid = nvts.oid"
+               "                       AND modification_time"
+               "                           = nvts.modification_time"
+               "                       AND cert_loaded = %i));",
+               manage_cert_loaded () ? 1 : 0))
+    rebuild_nvt_xml_caches ();
 }
 
 /**
@@ -123,7 +135,8 @@ nvts_feed_version ()
  *
  * @param[in]  feed_version  New feed version.
  *
- * Also queue an update to the nvti cache.
+ * Also queue an update to the nvti cache, and drop the cached scanner
+ * payloads of all configs.
  */
 void
 set_nvts_feed_version (const char *feed_version)
@@ -139,6 +152,8 @@ set_nvts_feed_version (const char *feed_version)
 
   sql ("UPDATE %s.meta SET value = 1 WHERE name = 'update_nvti_cache';",
        sql_schema ());
+
+  sql ("DELETE FROM config_otp_caches;");
 }
 
 /**
@@ -913,6 +928,180 @@ nvt_default_timeout (const char* oid)
                      oid);
 }
 
+/**
+ * @brief Define a code snippet for nvt_feed_xml.
+ *
+ * @param  x  Prefix for names in snippet.
+ */
+#define DEF(x)                                                    \
+      const char* x = nvt_iterator_ ## x (nvts);                  \
+      gchar* x ## _text = x                                       \
+                          ? g_markup_escape_text (x, -1)          \
+                          : g_strdup ("");
+
+/**
+ * @brief Create the feed dependent XML of an NVT.
+ *
+ * This is the part of the detailed NVT XML from CATEGORY to TAGS.
+ *
+ * @param[in]  nvts         NVT iterator.
+ * @param[in]  cert_loaded  Whether the CERT database is loaded.
+ *
+ * @return Freshly allocated XML.
+ */
+gchar *
+nvt_feed_xml (iterator_t *nvts, int cert_loaded)
+{
+  const char *oid = nvt_iterator_oid (nvts);
+  GString *cert_refs_str;
+  iterator_t cert_refs_iterator;
+  gchar *xml;
+
+  DEF (family);
+  DEF (xref);
+  DEF (tag);
+
+#undef DEF
+
+  cert_refs_str = g_string_new ("");
+  if (cert_loaded)
+    {
+      init_nvt_cert_bund_adv_iterator (&cert_refs_iterator, oid, 0, 0);
+      while (next (&cert_refs_iterator))
+        {
+          g_string_append_printf (cert_refs_str,
+                                  "<cert_ref type=\"CERT-Bund\" id=\"%s\"/>",
+                                  get_iterator_name (&cert_refs_iterator));
+        }
+      cleanup_iterator (&cert_refs_iterator);
+
+      init_nvt_dfn_cert_adv_iterator (&cert_refs_iterator, oid, 0, 0);
+      while (next (&cert_refs_iterator))
+        {
+          g_string_append_printf (cert_refs_str,
+                                  "<cert_ref type=\"DFN-CERT\" id=\"%s\"/>",
+                                  get_iterator_name (&cert_refs_iterator));
+        }
+      cleanup_iterator (&cert_refs_iterator);
+    }
+  else
+    {
+      g_string_append (cert_refs_str,
+                       "<warning>database not available</warning>");
+    }
+
+  xml = g_strdup_printf ("<category>%d</category>"
+                         "<family>%s</family>"
+                         "<cvss_base>%s</cvss_base>"
+                         "<qod>"
+                         "<value>%s</value>"
+                         "<type>%s</type>"
+                         "</qod>"
+                         "<cve_id>%s</cve_id>"
+                         "<bugtraq_id>%s</bugtraq_id>"
+                         "<cert_refs>%s</cert_refs>"
+                         "<xrefs>%s</xrefs>"
+                         "<tags>%s</tags>",
+                         nvt_iterator_category (nvts),
+                         family_text,
+                         nvt_iterator_cvss_base (nvts)
+                          ? nvt_iterator_cvss_base (nvts)
+                          : "",
+                         nvt_iterator_qod (nvts),
+                         nvt_iterator_qod_type (nvts),
+                         nvt_iterator_cve (nvts),
+                         nvt_iterator_bid (nvts),
+                         cert_refs_str->str,
+                         xref_text,
+                         tag_text);
+  g_free (family_text);
+  g_free (xref_text);
+  g_free (tag_text);
+  g_string_free (cert_refs_str, 1);
+  return xml;
+}
+
+/**
+ * @brief Rebuild the feed dependent XML caches of all NVTs.
+ *
+ * Called at the end of the NVT and CERT syncs, so that GET requests only
+ * ever read the caches.
+ *
+ * Caller must organise transaction.
+ */
+void
+rebuild_nvt_xml_caches ()
+{
+  iterator_t nvts;
+  int cert_loaded;
+
+  sql ("DELETE FROM nvt_xml_caches;");
+
+  cert_loaded = manage_cert_loaded () ? 1 : 0;
+  init_nvt_iterator (&nvts, 0, 0, NULL, NULL, 1, NULL);
+  while (next (&nvts))
+    {
+      gchar *xml, *quoted_xml;
+
+      xml = nvt_feed_xml (&nvts, cert_loaded);
+      quoted_xml = sql_insert (xml);
+      g_free (xml);
+      sql ("INSERT INTO nvt_xml_caches"
+           " (oid, modification_time, xml, default_timeout, cert_loaded)"
+           " SELECT oid, modification_time, %s,"
+           "        (SELECT value FROM nvt_preferences"
+           "         WHERE name = nvts.name || ':entry:Timeout'),"
+           "        %i"
+           " FROM nvts WHERE id = %llu;",
+           quoted_xml,
+           cert_loaded,
+           get_iterator_resource (&nvts));
+      g_free (quoted_xml);
+    }
+  cleanup_iterator (&nvts);
+}
+
+/**
+ * @brief Get the cached feed dependent XML of an NVT.
+ *
+ * The cache is only used if it was made from the current version of the NVT
+ * and with the current state of the CERT database.
+ *
+ * @param[in]   oid              OID of the NVT.
+ * @param[out]  xml              Cached XML, from CATEGORY to TAGS.
+ * @param[out]  default_timeout  Cached default timeout, or NULL.
+ *
+ * @return 0 success, 1 no usable cache.
+ */
+int
+nvt_xml_cache (const char *oid, gchar **xml, gchar **default_timeout)
+{
+  iterator_t cache;
+  gchar *quoted_oid;
+  int ret;
+
+  quoted_oid = sql_quote (oid);
+  init_iterator (&cache,
+                 "SELECT xml, default_timeout FROM nvt_xml_caches"
+                 " WHERE oid = '%s'"
+                 " AND cert_loaded = %i"
+                 " AND modification_time = (SELECT modification_time"
+                 "                          FROM nvts WHERE oid = '%s');",
+                 quoted_oid,
+                 manage_cert_loaded () ? 1 : 0,
+                 quoted_oid);
+  g_free (quoted_oid);
+  ret = 1;
+  if (next (&cache))
+    {
+      *xml = g_strdup (iterator_string (&cache, 0));
+      *default_timeout = g_strdup (iterator_string (&cache, 1));
+      ret = 0;
+    }
+  cleanup_iterator (&cache);
+  return ret;
+}
+
 /**
  * @brief Get the number of NVTs in one or all families.
  *
@@ -1137,6 +1326,10 @@ manage_complete_nvt_cache_update (GList *nvts_list, GList *nvt_preferences_list)
   update_all_config_caches ();
 
   refresh_nvt_cves ();
+  update_nvt_cert_flags ();
+  rebuild_nvt_xml_caches ();
+
+  secinfo_index_refresh ("nvts");
 
   if (sql_int ("SELECT NOT EXISTS (SELECT * FROM meta"
                "                   WHERE name = 'nvts_check_time')"))
@@ -93,6 +93,15 @@ check_db_nvts ();
 int
 check_config_families ();
 
+gchar *
+nvt_feed_xml (iterator_t *, int);
+
+void
+rebuild_nvt_xml_caches ();
+
+int
+nvt_xml_cache (const char *, gchar **, gchar **);
+
 void
 manage_sync_nvts (int (*) ());
 
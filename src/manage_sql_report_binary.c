@@ -0,0 +1,1434 @@
+/* Copyright (C) 2019 Greenbone Networks GmbH
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * @file manage_sql_report_binary.c
+ * @brief GVM management layer: Binary report format.
+ *
+ * Reader and writer for the binary report interchange format.
+ *
+ * A binary report starts with the magic "GVMB" and a 32 bit version.  This
+ * is followed by a sequence of blocks, each of which is a 32 bit raw length,
+ * a 32 bit compressed length and the zlib compressed block data.  A block
+ * with raw length 0 ends the report.  The raw length of a block is at most
+ * REPORT_BINARY_BLOCK_MAX, so that a reader can decode a report a block at
+ * a time without trusting the compressed data.
+ *
+ * The data of a block is a sequence of records.  Each record is an 8 bit
+ * type, a 32 bit payload length and the payload.  Records never span blocks.
+ *
+ * Strings in a payload are 32 bit references.  0 is NULL.  If the high bit
+ * is set the rest of the reference is the length of a string that follows
+ * inline.  Otherwise the reference is an index into the string table, which
+ * is built up by STRING records that always come before the first use of
+ * the string.  The table holds at most REPORT_BINARY_STRINGS_MAX strings of
+ * at most REPORT_BINARY_INTERN_MAX bytes.  Times are ISO time strings, with
+ * NULL for unknown.
+ *
+ * All integers are little endian.
+ */
+
+#include "manage.h"
+#include "manage_sql.h"
+#include "sql.h"
+#include "utils.h"
+
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#undef G_LOG_DOMAIN
+/**
+ * @brief GLib log domain.
+ */
+#define G_LOG_DOMAIN "md manage"
+
+/* Headers for symbols defined in manage.c which are private to libmanage. */
+
+const char *message_type_threat (const char *);
+
+/**
+ * @brief Magic at the start of a binary report.
+ */
+#define REPORT_BINARY_MAGIC "GVMB"
+
+/**
+ * @brief Size at which the writer compresses and writes out a block.
+ */
+#define REPORT_BINARY_BLOCK_SIZE (256 * 1024)
+
+/**
+ * @brief Largest raw length of a block.
+ *
+ * A block is written out once it reaches REPORT_BINARY_BLOCK_SIZE, so only a
+ * block with a very long record comes near this.
+ */
+#define REPORT_BINARY_BLOCK_MAX (16 * 1024 * 1024)
+
+/**
+ * @brief Longest string that goes into the string table.
+ *
+ * Longer strings, like most result descriptions, are written inline.
+ */
+#define REPORT_BINARY_INTERN_MAX 1024
+
+/**
+ * @brief Largest number of strings in the string table.
+ *
+ * Once the table is full the writer writes new strings inline.
+ */
+#define REPORT_BINARY_STRINGS_MAX 65536
+
+/**
+ * @brief Largest binary report that is imported, in bytes.
+ */
+#define REPORT_BINARY_IMPORT_MAX (1024 * 1024 * 1024)
+
+/**
+ * @brief Flag marking an inline string reference.
+ */
+#define REPORT_BINARY_INLINE 0x80000000
+
+/**
+ * @brief Binary report record types.
+ */
+typedef enum
+{
+  REPORT_BINARY_RECORD_END = 0,
+  REPORT_BINARY_RECORD_STRING = 1,
+  REPORT_BINARY_RECORD_REPORT = 2,
+  REPORT_BINARY_RECORD_HOST = 3,
+  REPORT_BINARY_RECORD_RESULT = 4,
+  REPORT_BINARY_RECORD_DETAIL = 5,
+  REPORT_BINARY_RECORD_NOTE = 6,
+  REPORT_BINARY_RECORD_OVERRIDE = 7
+} report_binary_record_t;
+
+
+
+/**
+ * @brief Binary report reader state.
+ */
+struct report_binary_reader
+{
+  GByteArray *input;       ///< Input that has not been decoded yet.
+  int header;              ///< Whether the header has been read.
+  int done;                ///< Whether the end of the report has been read.
+  int error;               ///< 0, 1 unsupported version, -1 invalid.
+  gsize length;            ///< Length of input so far.
+  FILE *spool;             ///< Copy of the input.
+  gchar *spool_path;       ///< Path of copy of the input.
+  GPtrArray *strings;      ///< String table.
+  int result_count;        ///< Number of results read.
+  gchar *scan_start;       ///< Scan start time.
+  gchar *scan_end;         ///< Scan end time.
+};
+
+/**
+ * @brief Records decoded from a block.
+ */
+typedef struct
+{
+  array_t *results;        ///< Results.
+  array_t *host_starts;    ///< Host starts.
+  array_t *host_ends;      ///< Host ends.
+  array_t *details;        ///< Host details.
+  gchar *scan_start;       ///< Scan start time, if block has REPORT record.
+  gchar *scan_end;         ///< Scan end time, if block has REPORT record.
+} report_binary_records_t;
+
+
+/* Writer. */
+
+/**
+ * @brief Binary report writer state.
+ */
+typedef struct
+{
+  FILE *file;              ///< Output file.
+  GString *block;          ///< Records of the current block.
+  GString *record;         ///< Payload of the current record.
+  GHashTable *strings;     ///< String table, string to index.
+  guint32 string_count;    ///< Number of strings in string table.
+} report_binary_writer_t;
+
+/**
+ * @brief Append a 32 bit integer to a buffer.
+ *
+ * @param[in]  buffer  Buffer.
+ * @param[in]  value   Value.
+ */
+static void
+put_u32 (GString *buffer, guint32 value)
+{
+  value = GUINT32_TO_LE (value);
+  g_string_append_len (buffer, (const gchar *) &value, 4);
+}
+
+/**
+ * @brief Compress and write out the current block.
+ *
+ * @param[in]  writer  Writer.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+writer_flush (report_binary_writer_t *writer)
+{
+  Bytef *compressed;
+  uLongf compressed_len;
+  GString *header;
+  int ret;
+
+  if (writer->block->len == 0)
+    return 0;
+
+  compressed_len = compressBound (writer->block->len);
+  compressed = g_malloc (compressed_len);
+  if (compress2 (compressed, &compressed_len,
+                 (const Bytef *) writer->block->str, writer->block->len,
+                 Z_DEFAULT_COMPRESSION)
+      != Z_OK)
+    {
+      g_warning ("%s: failed to compress block", __FUNCTION__);
+      g_free (compressed);
+      return -1;
+    }
+
+  header = g_string_new ("");
+  put_u32 (header, writer->block->len);
+  put_u32 (header, compressed_len);
+
+  ret = 0;
+  if (fwrite (header->str, 1, header->len, writer->file) != header->len
+      || fwrite (compressed, 1, compressed_len, writer->file)
+         != compressed_len)
+    {
+      g_warning ("%s: failed to write block: %s",
+                 __FUNCTION__,
+                 strerror (errno));
+      ret = -1;
+    }
+
+  g_string_free (header, TRUE);
+  g_free (compressed);
+  g_string_truncate (writer->block, 0);
+  return ret;
+}
+
+/**
+ * @brief Add a string to the current record.
+ *
+ * Short strings are added to the string table, defining them in the block
+ * first if they are new.  Once the table is full, new strings are written
+ * inline.
+ *
+ * @param[in]  writer  Writer.
+ * @param[in]  string  String, or NULL.
+ */
+static void
+writer_string (report_binary_writer_t *writer, const char *string)
+{
+  gsize length;
+  gpointer index;
+
+  if (string == NULL)
+    {
+      put_u32 (writer->record, 0);
+      return;
+    }
+
+  length = strlen (string);
+  if (length > REPORT_BINARY_INTERN_MAX
+      || (writer->string_count >= REPORT_BINARY_STRINGS_MAX
+          && g_hash_table_lookup (writer->strings, string) == NULL))
+    {
+      put_u32 (writer->record, REPORT_BINARY_INLINE | length);
+      g_string_append_len (writer->record, string, length);
+      return;
+    }
+
+  index = g_hash_table_lookup (writer->strings, string);
+  if (index == NULL)
+    {
+      index = GUINT_TO_POINTER (++writer->string_count);
+      g_hash_table_insert (writer->strings, g_strdup (string), index);
+      g_string_append_c (writer->block, REPORT_BINARY_RECORD_STRING);
+      put_u32 (writer->block, length);
+      g_string_append_len (writer->block, string, length);
+    }
+  put_u32 (writer->record, GPOINTER_TO_UINT (index));
+}
+
+/**
+ * @brief Add a time string to the current record.
+ *
+ * @param[in]  writer  Writer.
+ * @param[in]  time    ISO time, or NULL or "" if unknown.
+ */
+static void
+writer_time (report_binary_writer_t *writer, const char *time)
+{
+  writer_string (writer, (time && strlen (time)) ? time : NULL);
+}
+
+/**
+ * @brief Add the current record to the block.
+ *
+ * @param[in]  writer  Writer.
+ * @param[in]  type    Type of record.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+writer_record (report_binary_writer_t *writer, report_binary_record_t type)
+{
+  if (writer->record->len + 5 > REPORT_BINARY_BLOCK_MAX)
+    {
+      g_warning ("%s: record too long", __FUNCTION__);
+      return -1;
+    }
+
+  if (writer->block->len + writer->record->len + 5 > REPORT_BINARY_BLOCK_MAX
+      && writer_flush (writer))
+    return -1;
+
+  g_string_append_c (writer->block, type);
+  put_u32 (writer->block, writer->record->len);
+  g_string_append_len (writer->block, writer->record->str,
+                       writer->record->len);
+  g_string_truncate (writer->record, 0);
+
+  if (writer->block->len >= REPORT_BINARY_BLOCK_SIZE)
+    return writer_flush (writer);
+  return 0;
+}
+
+/**
+ * @brief Write the references to notes or overrides of a report.
+ *
+ * @param[in]  writer  Writer.
+ * @param[in]  report  Report.
+ * @param[in]  table   "notes" or "overrides".
+ * @param[in]  type    Record type.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+writer_annotations (report_binary_writer_t *writer, report_t report,
+                    const char *table, report_binary_record_t type)
+{
+  iterator_t annotations;
+
+  init_iterator (&annotations,
+                 "SELECT uuid,"
+                 "       (SELECT uuid FROM results"
+                 "        WHERE results.id = %s.result),"
+                 "       nvt"
+                 " FROM %s"
+                 " WHERE result IN (SELECT id FROM results"
+                 "                  WHERE report = %llu)"
+                 " OR ((result = 0 OR result IS NULL)"
+                 "     AND task = (SELECT task FROM reports"
+                 "                 WHERE id = %llu));",
+                 table,
+                 table,
+                 report,
+                 report);
+  while (next (&annotations))
+    {
+      writer_string (writer, iterator_string (&annotations, 0));
+      writer_string (writer, iterator_string (&annotations, 1));
+      writer_string (writer, iterator_string (&annotations, 2));
+      if (writer_record (writer, type))
+        {
+          cleanup_iterator (&annotations);
+          return -1;
+        }
+    }
+  cleanup_iterator (&annotations);
+  return 0;
+}
+
+/**
+ * @brief Get whether a report filter limits hosts to those with results.
+ *
+ * @param[in]  get  GET data for report.
+ *
+ * @return 1 if only hosts with results, 0 if all hosts, -1 error.
+ */
+static int
+writer_result_hosts_only (const get_data_t *get)
+{
+  gchar *term, *sort_field, *min_qod, *levels, *delta_states, *search_phrase;
+  gchar *zone;
+  int first_result, max_results, sort_order, result_hosts_only;
+  int search_phrase_exact, autofp, notes, overrides, apply_overrides;
+
+  if (get->filt_id && strlen (get->filt_id)
+      && strcmp (get->filt_id, FILT_ID_NONE))
+    {
+      term = filter_term (get->filt_id);
+      if (term == NULL)
+        return -1;
+    }
+  else
+    term = g_strdup (get->filter ? get->filter : "");
+
+  manage_report_filter_controls (term, &first_result, &max_results,
+                                 &sort_field, &sort_order, &result_hosts_only,
+                                 &min_qod, &levels, &delta_states,
+                                 &search_phrase, &search_phrase_exact,
+                                 &autofp, &notes, &overrides,
+                                 &apply_overrides, &zone);
+  g_free (term);
+  g_free (sort_field);
+  g_free (min_qod);
+  g_free (levels);
+  g_free (delta_states);
+  g_free (search_phrase);
+  g_free (zone);
+  return result_hosts_only ? 1 : 0;
+}
+
+/**
+ * @brief Write the records of a report.
+ *
+ * Results come from the result iterator, so the filter, overrides and QoD
+ * of the GET data apply as they do to the XML report.  Hosts follow the
+ * results so that result_hosts_only can be applied to them.
+ *
+ * @param[in]  writer  Writer.
+ * @param[in]  report  Report.
+ * @param[in]  get     GET data for report.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+writer_report (report_binary_writer_t *writer, report_t report,
+               const get_data_t *get)
+{
+  iterator_t results, hosts;
+  GHashTable *result_hosts;
+  task_t task;
+  char *uuid, *name, *comment, *start_time, *end_time;
+  int result_hosts_only;
+
+  /* Report. */
+
+  if (report_task (report, &task) || task == 0)
+    return -1;
+
+  result_hosts_only = writer_result_hosts_only (get);
+  if (result_hosts_only == -1)
+    return -1;
+
+  uuid = report_uuid (report);
+  name = task_name (task);
+  comment = task_comment (task);
+  start_time = scan_start_time (report);
+  end_time = scan_end_time (report);
+  writer_string (writer, uuid);
+  writer_string (writer, name);
+  writer_string (writer, comment);
+  writer_time (writer, start_time);
+  writer_time (writer, end_time);
+  free (uuid);
+  free (name);
+  free (comment);
+  free (start_time);
+  free (end_time);
+  if (writer_record (writer, REPORT_BINARY_RECORD_REPORT))
+    return -1;
+
+  /* Results. */
+
+  if (init_result_get_iterator (&results, get, report, NULL, NULL))
+    return -1;
+  result_hosts = result_hosts_only
+                  ? g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                           NULL)
+                  : NULL;
+  while (next (&results))
+    {
+      const char *host, *qod;
+
+      host = result_iterator_host (&results);
+      qod = result_iterator_qod (&results);
+      writer_string (writer, get_iterator_uuid (&results));
+      writer_string (writer, host);
+      writer_string (writer, result_iterator_hostname (&results));
+      writer_string (writer, result_iterator_port (&results));
+      writer_string (writer, result_iterator_nvt_oid (&results));
+      writer_string (writer, result_iterator_type (&results));
+      writer_string (writer, result_iterator_descr (&results));
+      writer_string (writer, result_iterator_scan_nvt_version (&results));
+      writer_string (writer, result_iterator_severity (&results));
+      put_u32 (writer->record, qod ? atoi (qod) : 0);
+      writer_string (writer, result_iterator_qod_type (&results));
+      if (writer_record (writer, REPORT_BINARY_RECORD_RESULT))
+        {
+          cleanup_iterator (&results);
+          if (result_hosts)
+            g_hash_table_destroy (result_hosts);
+          return -1;
+        }
+      if (result_hosts && host
+          && g_hash_table_contains (result_hosts, host) == FALSE)
+        g_hash_table_add (result_hosts, g_strdup (host));
+    }
+  cleanup_iterator (&results);
+
+  /* Hosts, each followed by its details. */
+
+  init_report_host_iterator (&hosts, report, NULL, 0);
+  while (next (&hosts))
+    {
+      iterator_t details;
+      const char *host;
+
+      host = host_iterator_host (&hosts);
+      if (result_hosts && g_hash_table_contains (result_hosts, host) == FALSE)
+        continue;
+
+      writer_string (writer, host);
+      writer_time (writer, host_iterator_start_time (&hosts));
+      writer_time (writer, host_iterator_end_time (&hosts));
+      if (writer_record (writer, REPORT_BINARY_RECORD_HOST))
+        break;
+
+      init_report_host_details_iterator (&details,
+                                         host_iterator_report_host (&hosts));
+      while (next (&details))
+        {
+          writer_string (writer, host);
+          writer_string (writer,
+                         report_host_details_iterator_source_type (&details));
+          writer_string (writer,
+                         report_host_details_iterator_source_name (&details));
+          writer_string (writer,
+                         report_host_details_iterator_source_desc (&details));
+          writer_string (writer,
+                         report_host_details_iterator_name (&details));
+          writer_string (writer,
+                         report_host_details_iterator_value (&details));
+          if (writer_record (writer, REPORT_BINARY_RECORD_DETAIL))
+            break;
+        }
+      if (details.done == FALSE)
+        {
+          cleanup_iterator (&details);
+          break;
+        }
+      cleanup_iterator (&details);
+    }
+  if (result_hosts)
+    g_hash_table_destroy (result_hosts);
+  if (hosts.done == FALSE)
+    {
+      cleanup_iterator (&hosts);
+      return -1;
+    }
+  cleanup_iterator (&hosts);
+
+  /* Notes and overrides. */
+
+  if (writer_annotations (writer, report, "notes", REPORT_BINARY_RECORD_NOTE)
+      || writer_annotations (writer, report, "overrides",
+                             REPORT_BINARY_RECORD_OVERRIDE))
+    return -1;
+
+  return writer_record (writer, REPORT_BINARY_RECORD_END);
+}
+
+/**
+ * @brief Write a report in the binary report format.
+ *
+ * The report is written to the file block by block, so the writer holds
+ * at most one block of the report in memory.
+ *
+ * @param[in]  report  Report.
+ * @param[in]  get     GET data for report.
+ * @param[in]  path    Path of output file.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+report_binary_write (report_t report, const get_data_t *get,
+                     const gchar *path)
+{
+  report_binary_writer_t writer;
+  GString *header;
+  int ret;
+
+  writer.file = fopen (path, "w");
+  if (writer.file == NULL)
+    {
+      g_warning ("%s: failed to open %s: %s",
+                 __FUNCTION__,
+                 path,
+                 strerror (errno));
+      return -1;
+    }
+
+  writer.block = g_string_new ("");
+  writer.record = g_string_new ("");
+  writer.strings = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                          NULL);
+  writer.string_count = 0;
+
+  header = g_string_new (REPORT_BINARY_MAGIC);
+  put_u32 (header, REPORT_BINARY_VERSION);
+  ret = 0;
+  if (fwrite (header->str, 1, header->len, writer.file) != header->len)
+    {
+      g_warning ("%s: failed to write header: %s",
+                 __FUNCTION__,
+                 strerror (errno));
+      ret = -1;
+    }
+  g_string_free (header, TRUE);
+
+  if (ret == 0)
+    ret = writer_report (&writer, report, get);
+  if (ret == 0)
+    ret = writer_flush (&writer);
+  if (ret == 0)
+    {
+      /* End of report. */
+      header = g_string_new ("");
+      put_u32 (header, 0);
+      put_u32 (header, 0);
+      if (fwrite (header->str, 1, header->len, writer.file) != header->len)
+        ret = -1;
+      g_string_free (header, TRUE);
+    }
+
+  g_hash_table_destroy (writer.strings);
+  g_string_free (writer.record, TRUE);
+  g_string_free (writer.block, TRUE);
+  if (fclose (writer.file))
+    {
+      g_warning ("%s: failed to close %s: %s",
+                 __FUNCTION__,
+                 path,
+                 strerror (errno));
+      return -1;
+    }
+  return ret;
+}
+
+
+/* Reader. */
+
+/**
+ * @brief Position in a record being decoded.
+ */
+typedef struct
+{
+  const guchar *position;  ///< Current position in record.
+  const guchar *end;       ///< End of record.
+  GPtrArray *strings;      ///< String table.
+} report_binary_record_reader_t;
+
+/**
+ * @brief Read a 32 bit integer.
+ *
+ * @param[in]   position  Position in buffer.
+ * @param[in]   end       End of buffer.
+ * @param[out]  value     Value.
+ *
+ * @return 0 success, -1 buffer too short.
+ */
+static int
+get_u32 (const guchar **position, const guchar *end, guint32 *value)
+{
+  guint32 raw;
+
+  if (end - *position < 4)
+    return -1;
+  memcpy (&raw, *position, 4);
+  *value = GUINT32_FROM_LE (raw);
+  *position += 4;
+  return 0;
+}
+
+/**
+ * @brief Read a string from the current record.
+ *
+ * @param[in]   reader  Record reader.
+ * @param[out]  string  Freshly allocated string, or NULL.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+reader_string (report_binary_record_reader_t *reader, gchar **string)
+{
+  guint32 reference;
+
+  *string = NULL;
+  if (get_u32 (&reader->position, reader->end, &reference))
+    return -1;
+
+  if (reference == 0)
+    return 0;
+
+  if (reference & REPORT_BINARY_INLINE)
+    {
+      reference &= ~REPORT_BINARY_INLINE;
+      if ((gsize) (reader->end - reader->position) < reference)
+        return -1;
+      *string = g_strndup ((const gchar *) reader->position, reference);
+      reader->position += reference;
+      return 0;
+    }
+
+  if (reference > reader->strings->len)
+    return -1;
+  *string = g_strdup (g_ptr_array_index (reader->strings, reference - 1));
+  return 0;
+}
+
+/**
+ * @brief Read a result record.
+ *
+ * @param[in]  reader   Record reader.
+ * @param[in]  results  Array to add result to.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+reader_result (report_binary_record_reader_t *reader, array_t *results)
+{
+  create_report_result_t *result;
+  gchar *uuid, *type;
+  guint32 qod;
+  int ret;
+
+  result = g_malloc0 (sizeof (create_report_result_t));
+  uuid = type = NULL;
+  ret = (reader_string (reader, &uuid)
+         || reader_string (reader, &result->host)
+         || reader_string (reader, &result->hostname)
+         || reader_string (reader, &result->port)
+         || reader_string (reader, &result->nvt_oid)
+         || reader_string (reader, &type)
+         || reader_string (reader, &result->description)
+         || reader_string (reader, &result->scan_nvt_version)
+         || reader_string (reader, &result->severity)
+         || get_u32 (&reader->position, reader->end, &qod)
+         || reader_string (reader, &result->qod_type));
+
+  g_free (uuid);
+  if (type)
+    {
+      /* All Alarm levels insert as "Alarm", so any of them will do. */
+      if (strcmp (type, "Alarm") == 0)
+        result->threat = "High";
+      else
+        result->threat = (char *) message_type_threat (type);
+      g_free (type);
+    }
+  result->qod = g_strdup_printf ("%u", ret ? 0 : qod);
+
+  /* Add even on error, so that the caller frees the result. */
+  array_add (results, result);
+  return ret ? -1 : 0;
+}
+
+/**
+ * @brief Read a host detail record.
+ *
+ * @param[in]  reader   Record reader.
+ * @param[in]  details  Array to add detail to.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+reader_detail (report_binary_record_reader_t *reader, array_t *details)
+{
+  host_detail_t *detail;
+
+  detail = g_malloc0 (sizeof (host_detail_t));
+  array_add (details, detail);
+  if (reader_string (reader, &detail->ip)
+      || reader_string (reader, &detail->source_type)
+      || reader_string (reader, &detail->source_name)
+      || reader_string (reader, &detail->source_desc)
+      || reader_string (reader, &detail->name)
+      || reader_string (reader, &detail->value))
+    return -1;
+  return 0;
+}
+
+/**
+ * @brief Read a host record.
+ *
+ * A host without a start time is still added, with a NULL time.
+ *
+ * @param[in]  reader   Record reader.
+ * @param[in]  records  Records to add host start and end to.
+ *
+ * @return 0 success, -1 error.
+ */
+static int
+reader_host (report_binary_record_reader_t *reader,
+             report_binary_records_t *records)
+{
+  create_report_result_t *start, *end;
+  gchar *host, *start_time, *end_time;
+
+  start_time = end_time = NULL;
+  if (reader_string (reader, &host)
+      || host == NULL
+      || reader_string (reader, &start_time)
+      || reader_string (reader, &end_time))
+    {
+      g_free (host);
+      g_free (start_time);
+      return -1;
+    }
+
+  start = g_malloc0 (sizeof (create_report_result_t));
+  start->host = host;
+  start->description = start_time;
+  array_add (records->host_starts, start);
+
+  end = g_malloc0 (sizeof (create_report_result_t));
+  end->host = g_strdup (host);
+  end->description = end_time;
+  array_add (records->host_ends, end);
+
+  return 0;
+}
+
+/**
+ * @brief Read the records of one block.
+ *
+ * @param[in]  strings  String table.
+ * @param[in]  data     Block data.
+ * @param[in]  length   Length of data.
+ * @param[in]  records  Records to add to.
+ *
+ * @return 0 success, 1 end of report, -1 error.
+ */
+static int
+reader_block (GPtrArray *strings, const guchar *data, gsize length,
+              report_binary_records_t *records)
+{
+  report_binary_record_reader_t reader;
+  const guchar *position, *end;
+
+  reader.strings = strings;
+  position = data;
+  end = data + length;
+  while (position < end)
+    {
+      guint8 type;
+      guint32 record_length;
+
+      type = *position++;
+      if (get_u32 (&position, end, &record_length)
+          || (gsize) (end - position) < record_length)
+        return -1;
+
+      reader.position = position;
+      reader.end = position + record_length;
+      position += record_length;
+
+      switch (type)
+        {
+          case REPORT_BINARY_RECORD_END:
+            return 1;
+
+          case REPORT_BINARY_RECORD_STRING:
+            if (record_length > REPORT_BINARY_INTERN_MAX
+                || strings->len >= REPORT_BINARY_STRINGS_MAX)
+              return -1;
+            g_ptr_array_add (strings,
+                             g_strndup ((const gchar *) reader.position,
+                                        record_length));
+            break;
+
+          case REPORT_BINARY_RECORD_REPORT:
+            {
+              gchar *uuid, *task_name, *task_comment;
+
+              uuid = task_name = task_comment = NULL;
+              g_free (records->scan_start);
+              g_free (records->scan_end);
+              records->scan_start = records->scan_end = NULL;
+              if (reader_string (&reader, &uuid)
+                  || reader_string (&reader, &task_name)
+                  || reader_string (&reader, &task_comment)
+                  || reader_string (&reader, &records->scan_start)
+                  || reader_string (&reader, &records->scan_end))
+                {
+                  g_free (uuid);
+                  g_free (task_name);
+                  g_free (task_comment);
+                  return -1;
+                }
+              g_free (uuid);
+              g_free (task_name);
+              g_free (task_comment);
+              break;
+            }
+
+          case REPORT_BINARY_RECORD_HOST:
+            if (reader_host (&reader, records))
+              return -1;
+            break;
+
+          case REPORT_BINARY_RECORD_RESULT:
+            if (reader_result (&reader, records->results))
+              return -1;
+            break;
+
+          case REPORT_BINARY_RECORD_DETAIL:
+            if (reader_detail (&reader, records->details))
+              return -1;
+            break;
+
+          default:
+            /* Notes and overrides refer to resources on the Manager that
+             * wrote the report, so they are skipped, as are any record
+             * types added later in this version. */
+            break;
+        }
+    }
+  return 0;
+}
+
+/**
+ * @brief Check the lengths in a block header.
+ *
+ * @param[in]  raw_length         Raw length of block.
+ * @param[in]  compressed_length  Compressed length of block.
+ *
+ * @return 0 if acceptable, -1 if the block is too large.
+ */
+static int
+reader_block_check (guint32 raw_length, guint32 compressed_length)
+{
+  if (raw_length > REPORT_BINARY_BLOCK_MAX
+      || compressed_length > compressBound (raw_length))
+    return -1;
+  return 0;
+}
+
+/**
+ * @brief Decompress a block.
+ *
+ * The output is limited to the raw length from the block header, so a block
+ * that expands further is rejected instead of being decompressed.
+ *
+ * @param[in]  compressed         Compressed block data.
+ * @param[in]  compressed_length  Length of compressed data.
+ * @param[in]  raw_length         Raw length from block header.
+ *
+ * @return Freshly allocated block data of length raw_length, or NULL on
+ *         error.
+ */
+static guchar *
+reader_inflate (const guchar *compressed, guint32 compressed_length,
+                guint32 raw_length)
+{
+  z_stream stream;
+  guchar *block;
+  int ret;
+
+  memset (&stream, 0, sizeof (stream));
+  if (inflateInit (&stream) != Z_OK)
+    return NULL;
+
+  block = g_malloc (raw_length);
+  stream.next_in = (Bytef *) compressed;
+  stream.avail_in = compressed_length;
+  stream.next_out = block;
+  stream.avail_out = raw_length;
+  ret = inflate (&stream, Z_FINISH);
+  inflateEnd (&stream);
+
+  if (ret != Z_STREAM_END || stream.total_out != raw_length)
+    {
+      g_free (block);
+      return NULL;
+    }
+  return block;
+}
+
+/**
+ * @brief Initialise records for decoding a block into.
+ *
+ * @param[in]  records  Records.
+ */
+static void
+records_init (report_binary_records_t *records)
+{
+  records->results = make_array ();
+  records->host_starts = make_array ();
+  records->host_ends = make_array ();
+  records->details = make_array ();
+  records->scan_start = NULL;
+  records->scan_end = NULL;
+}
+
+/**
+ * @brief Free host starts or ends.
+ *
+ * @param[in]  hosts  Array of create_report_result_t host starts or ends.
+ */
+static void
+records_free_hosts (array_t *hosts)
+{
+  guint index;
+
+  for (index = 0; index < hosts->len; index++)
+    {
+      create_report_result_t *host;
+
+      host = g_ptr_array_index (hosts, index);
+      if (host)
+        {
+          g_free (host->host);
+          g_free (host->description);
+        }
+    }
+  array_free (hosts);
+}
+
+/**
+ * @brief Free decoded records.
+ *
+ * @param[in]  records  Records.
+ */
+static void
+records_free (report_binary_records_t *records)
+{
+  guint index;
+
+  for (index = 0; index < records->results->len; index++)
+    {
+      create_report_result_t *result;
+
+      result = g_ptr_array_index (records->results, index);
+      if (result)
+        {
+          g_free (result->description);
+          g_free (result->host);
+          g_free (result->hostname);
+          g_free (result->nvt_oid);
+          g_free (result->scan_nvt_version);
+          g_free (result->port);
+          g_free (result->qod);
+          g_free (result->qod_type);
+          g_free (result->severity);
+        }
+    }
+  array_free (records->results);
+
+  records_free_hosts (records->host_starts);
+  records_free_hosts (records->host_ends);
+
+  for (index = 0; index < records->details->len; index++)
+    {
+      host_detail_t *detail;
+
+      detail = g_ptr_array_index (records->details, index);
+      if (detail)
+        host_detail_free (detail);
+    }
+  array_free (records->details);
+
+  g_free (records->scan_start);
+  g_free (records->scan_end);
+}
+
+/**
+ * @brief Create a reader for a binary report that arrives in pieces.
+ *
+ * The input is checked a block at a time as it arrives, and copied to a
+ * temporary file for report_binary_import.
+ *
+ * @return Reader, or NULL on error.
+ */
+report_binary_reader_t *
+report_binary_reader_new ()
+{
+  report_binary_reader_t *reader;
+  GError *error;
+  gint fd;
+
+  reader = g_malloc0 (sizeof (report_binary_reader_t));
+
+  error = NULL;
+  fd = g_file_open_tmp ("gvmd-report-XXXXXX", &reader->spool_path, &error);
+  if (fd == -1)
+    {
+      g_warning ("%s: failed to create spool file: %s",
+                 __FUNCTION__,
+                 error->message);
+      g_error_free (error);
+      g_free (reader);
+      return NULL;
+    }
+  reader->spool = fdopen (fd, "w");
+  if (reader->spool == NULL)
+    {
+      g_warning ("%s: fdopen failed: %s", __FUNCTION__, strerror (errno));
+      close (fd);
+      unlink (reader->spool_path);
+      g_free (reader->spool_path);
+      g_free (reader);
+      return NULL;
+    }
+
+  reader->input = g_byte_array_new ();
+  reader->strings = g_ptr_array_new_with_free_func (g_free);
+  return reader;
+}
+
+/**
+ * @brief Free a binary report reader.
+ *
+ * The temporary copy of the input is removed, unless it has been taken by
+ * report_binary_reader_finish.
+ *
+ * @param[in]  reader  Reader.
+ */
+void
+report_binary_reader_free (report_binary_reader_t *reader)
+{
+  if (reader == NULL)
+    return;
+
+  if (reader->spool)
+    fclose (reader->spool);
+  if (reader->spool_path)
+    {
+      unlink (reader->spool_path);
+      g_free (reader->spool_path);
+    }
+  g_byte_array_free (reader->input, TRUE);
+  g_ptr_array_free (reader->strings, TRUE);
+  g_free (reader->scan_start);
+  g_free (reader->scan_end);
+  g_free (reader);
+}
+
+/**
+ * @brief Give a binary report reader the next piece of the report.
+ *
+ * Each complete block is decompressed and decoded right away, and dropped
+ * once it has been checked.  Only the result count and scan times are kept.
+ *
+ * @param[in]  reader  Reader.
+ * @param[in]  data    Next piece of binary report.
+ * @param[in]  length  Length of data.
+ *
+ * @return 0 success, 1 not a binary report or unsupported version, -1 error.
+ */
+int
+report_binary_reader_feed (report_binary_reader_t *reader,
+                           const guchar *data, gsize length)
+{
+  if (reader->error || reader->done)
+    return reader->error;
+
+  reader->length += length;
+  if (reader->length > REPORT_BINARY_IMPORT_MAX)
+    {
+      g_warning ("%s: binary report is larger than %i bytes",
+                 __FUNCTION__,
+                 REPORT_BINARY_IMPORT_MAX);
+      reader->error = -1;
+      return -1;
+    }
+
+  if (fwrite (data, 1, length, reader->spool) != length)
+    {
+      g_warning ("%s: failed to write spool file: %s",
+                 __FUNCTION__,
+                 strerror (errno));
+      reader->error = -1;
+      return -1;
+    }
+  g_byte_array_append (reader->input, data, length);
+
+  if (reader->header == 0)
+    {
+      const guchar *position;
+      guint32 version;
+
+      if (reader->input->len < strlen (REPORT_BINARY_MAGIC) + 4)
+        return 0;
+      if (memcmp (reader->input->data, REPORT_BINARY_MAGIC,
+                  strlen (REPORT_BINARY_MAGIC)))
+        {
+          reader->error = 1;
+          return 1;
+        }
+      position = reader->input->data + strlen (REPORT_BINARY_MAGIC);
+      get_u32 (&position, position + 4, &version);
+      if (version != REPORT_BINARY_VERSION)
+        {
+          reader->error = 1;
+          return 1;
+        }
+      g_byte_array_remove_range (reader->input, 0,
+                                 strlen (REPORT_BINARY_MAGIC) + 4);
+      reader->header = 1;
+    }
+
+  while (reader->input->len >= 8)
+    {
+      report_binary_records_t records;
+      const guchar *position;
+      guint32 raw_length, compressed_length;
+      guchar *block;
+      int ret;
+
+      position = reader->input->data;
+      get_u32 (&position, position + 4, &raw_length);
+      get_u32 (&position, position + 4, &compressed_length);
+
+      if (raw_length == 0)
+        {
+          reader->done = 1;
+          break;
+        }
+
+      if (reader_block_check (raw_length, compressed_length))
+        {
+          reader->error = -1;
+          break;
+        }
+
+      if (reader->input->len - 8 < compressed_length)
+        break;
+
+      block = reader_inflate (position, compressed_length, raw_length);
+      if (block == NULL)
+        {
+          reader->error = -1;
+          break;
+        }
+
+      records_init (&records);
+      ret = reader_block (reader->strings, block, raw_length, &records);
+      g_free (block);
+      reader->result_count += records.results->len;
+      if (records.scan_start || records.scan_end)
+        {
+          g_free (reader->scan_start);
+          g_free (reader->scan_end);
+          reader->scan_start = records.scan_start;
+          reader->scan_end = records.scan_end;
+          records.scan_start = records.scan_end = NULL;
+        }
+      records_free (&records);
+      g_byte_array_remove_range (reader->input, 0, 8 + compressed_length);
+
+      if (ret == -1)
+        reader->error = -1;
+      else if (ret == 1)
+        reader->done = 1;
+      if (ret)
+        break;
+    }
+
+  if (reader->error)
+    g_warning ("%s: invalid binary report", __FUNCTION__);
+  return reader->error;
+}
+
+/**
+ * @brief Finish reading a binary report.
+ *
+ * @param[in]   reader        Reader.
+ * @param[out]  path          Path of the copy of the report, for
+ *                            report_binary_import.  Caller must remove the
+ *                            file and free the path.
+ * @param[out]  result_count  Number of results in the report.
+ * @param[out]  scan_start    Freshly allocated scan start time, or NULL.
+ * @param[out]  scan_end      Freshly allocated scan end time, or NULL.
+ *
+ * @return 0 success, 1 not a binary report or unsupported version, -1 error.
+ */
+int
+report_binary_reader_finish (report_binary_reader_t *reader, gchar **path,
+                             int *result_count, gchar **scan_start,
+                             gchar **scan_end)
+{
+  if (reader->error)
+    return reader->error;
+
+  if (reader->header == 0)
+    return 1;
+
+  if (reader->done == 0)
+    {
+      g_warning ("%s: binary report is truncated", __FUNCTION__);
+      return -1;
+    }
+
+  if (fclose (reader->spool))
+    {
+      g_warning ("%s: failed to close spool file: %s",
+                 __FUNCTION__,
+                 strerror (errno));
+      reader->spool = NULL;
+      return -1;
+    }
+  reader->spool = NULL;
+
+  *path = reader->spool_path;
+  reader->spool_path = NULL;
+  *result_count = reader->result_count;
+  *scan_start = reader->scan_start;
+  reader->scan_start = NULL;
+  *scan_end = reader->scan_end;
+  reader->scan_end = NULL;
+  return 0;
+}
+
+/**
+ * @brief Import a binary report that has been checked by a reader.
+ *
+ * The report is decompressed and decoded a block at a time.  The records of
+ * each block are passed to the insert callback in the arrays that
+ * create_report takes, and freed before the next block is read.
+ *
+ * @param[in]  path    Path of report, from report_binary_reader_finish.
+ * @param[in]  insert  Function that inserts the results, host starts, host
+ *                     ends and host details of a block.
+ * @param[in]  data    Data for insert.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+report_binary_import (const gchar *path,
+                      int (*insert) (array_t *, array_t *, array_t *,
+                                     array_t *, void *),
+                      void *data)
+{
+  GPtrArray *strings;
+  FILE *file;
+  GStatBuf state;
+  guchar header[8];
+  long size;
+  int ret;
+
+  file = fopen (path, "r");
+  if (file == NULL)
+    {
+      g_warning ("%s: failed to open %s: %s",
+                 __FUNCTION__,
+                 path,
+                 strerror (errno));
+      return -1;
+    }
+
+  /* Check each block length against the rest of the file before
+   * allocating the block. */
+  if (g_stat (path, &state))
+    {
+      g_warning ("%s: failed to stat %s: %s",
+                 __FUNCTION__,
+                 path,
+                 strerror (errno));
+      fclose (file);
+      return -1;
+    }
+  size = state.st_size;
+
+  strings = g_ptr_array_new_with_free_func (g_free);
+  ret = -1;
+  if (fread (header, 1, strlen (REPORT_BINARY_MAGIC) + 4, file)
+      == strlen (REPORT_BINARY_MAGIC) + 4)
+    while (1)
+      {
+        report_binary_records_t records;
+        const guchar *position;
+        guint32 raw_length, compressed_length;
+        guchar *compressed, *block;
+        int status;
+
+        if (fread (header, 1, 8, file) != 8)
+          break;
+        position = header;
+        get_u32 (&position, header + 8, &raw_length);
+        get_u32 (&position, header + 8, &compressed_length);
+
+        if (raw_length == 0)
+          {
+            ret = 0;
+            break;
+          }
+
+        if (reader_block_check (raw_length, compressed_length)
+            || compressed_length > size - ftell (file))
+          break;
+
+        compressed = g_malloc (compressed_length);
+        if (fread (compressed, 1, compressed_length, file)
+            != compressed_length)
+          {
+            g_free (compressed);
+            break;
+          }
+        block = reader_inflate (compressed, compressed_length, raw_length);
+        g_free (compressed);
+        if (block == NULL)
+          break;
+
+        records_init (&records);
+        status = reader_block (strings, block, raw_length, &records);
+        g_free (block);
+        if (status >= 0)
+          {
+            array_terminate (records.results);
+            array_terminate (records.host_starts);
+            array_terminate (records.host_ends);
+            array_terminate (records.details);
+            if (insert (records.results, records.host_starts,
+                        records.host_ends, records.details, data))
+              status = -1;
+          }
+        records_free (&records);
+
+        if (status)
+          {
+            if (status == 1)
+              ret = 0;
+            break;
+          }
+      }
+
+  g_ptr_array_free (strings, TRUE);
+  fclose (file);
+  if (ret)
+    g_warning ("%s: failed to import binary report", __FUNCTION__);
+  return ret;
+}
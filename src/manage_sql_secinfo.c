@@ -30,6 +30,7 @@
 #define _GNU_SOURCE
 
 #include "manage_sql.h"
+#include "manage_sql_nvts.h"
 #include "manage_sql_secinfo.h"
 #include "sql.h"
 #include "utils.h"
@@ -64,6 +65,18 @@
  */
 static int secinfo_commit_size = SECINFO_COMMIT_SIZE_DEFAULT;
 
+/**
+ * @brief Alert check time that the current sync compares items against.
+ *
+ * 0 when changes are not being logged.
+ */
+static int change_log_check_time = 0;
+
+/**
+ * @brief Feed timestamp of the current sync, used as the sync ID in the log.
+ */
+static int change_log_sync = 0;
+
 
 /* Headers. */
 
@@ -1112,6 +1125,95 @@ init_nvt_dfn_cert_adv_iterator (iterator_t *iterator, const char *oid,
 
 /* All SecInfo data. */
 
+/**
+ * @brief Check whether the unified SecInfo index covers all feeds.
+ *
+ * Until each feed has been indexed once, All SecInfo falls back to the
+ * UNION over the SecInfo tables.
+ *
+ * @return 1 if the index is ready, else 0.
+ */
+int
+secinfo_index_ready ()
+{
+  return sql_int ("SELECT count (*) = 3 FROM meta"
+                  " WHERE name IN ('secinfo_index_nvts',"
+                  "                'secinfo_index_scap',"
+                  "                'secinfo_index_cert');");
+}
+
+/**
+ * @brief Refresh the unified SecInfo index for one feed.
+ *
+ * Caller must organise a transaction.
+ *
+ * @param[in]  feed  Feed: "nvts", "scap" or "cert".
+ */
+void
+secinfo_index_refresh (const char *feed)
+{
+  if (strcmp (feed, "nvts") == 0)
+    {
+      sql ("DELETE FROM secinfo_index WHERE type = 'nvt';");
+      sql ("INSERT INTO secinfo_index"
+           " (type, uuid, name, comment, created, modified, extra, severity)"
+           " SELECT 'nvt', uuid, name, comment, creation_time,"
+           "        modification_time, tag, CAST (cvss_base AS float)"
+           " FROM nvts;");
+    }
+  else if (strcmp (feed, "scap") == 0)
+    {
+      sql ("DELETE FROM secinfo_index"
+           " WHERE type IN ('cve', 'cpe', 'ovaldef');");
+      sql ("INSERT INTO secinfo_index"
+           " (type, uuid, name, comment, created, modified, extra, severity)"
+           " SELECT 'cve', uuid, name, comment, creation_time,"
+           "        modification_time, description, cvss"
+           " FROM scap.cves;");
+      sql ("INSERT INTO secinfo_index"
+           " (type, uuid, name, comment, created, modified, extra, severity)"
+           " SELECT 'cpe', uuid, name, comment, creation_time,"
+           "        modification_time, title, max_cvss"
+           " FROM scap.cpes;");
+      sql ("INSERT INTO secinfo_index"
+           " (type, uuid, name, comment, created, modified, extra, severity)"
+           " SELECT 'ovaldef', uuid, name, comment, creation_time,"
+           "        modification_time, title, max_cvss"
+           " FROM scap.ovaldefs;");
+    }
+  else if (strcmp (feed, "cert") == 0)
+    {
+      sql ("DELETE FROM secinfo_index"
+           " WHERE type IN ('cert_bund_adv', 'dfn_cert_adv');");
+      sql ("INSERT INTO secinfo_index"
+           " (type, uuid, name, comment, created, modified, extra, severity)"
+           " SELECT 'cert_bund_adv', uuid, name, comment, creation_time,"
+           "        modification_time, title, max_cvss"
+           " FROM cert.cert_bund_advs;");
+      sql ("INSERT INTO secinfo_index"
+           " (type, uuid, name, comment, created, modified, extra, severity)"
+           " SELECT 'dfn_cert_adv', uuid, name, comment, creation_time,"
+           "        modification_time, title, max_cvss"
+           " FROM cert.dfn_cert_advs;");
+    }
+  else
+    {
+      g_warning ("%s: unknown feed: %s", __FUNCTION__, feed);
+      return;
+    }
+
+  if (sql_int ("SELECT EXISTS (SELECT * FROM meta"
+               "               WHERE name = 'secinfo_index_%s');",
+               feed))
+    sql ("UPDATE meta SET value = m_now ()"
+         " WHERE name = 'secinfo_index_%s';",
+         feed);
+  else
+    sql ("INSERT INTO meta (name, value)"
+         " VALUES ('secinfo_index_%s', m_now ());",
+         feed);
+}
+
 /**
  * @brief Count number of SecInfo entries.
  *
@@ -1156,6 +1258,10 @@ total_info_count (const get_data_t *get, int filtered)
       clause = filter_clause ("allinfo", filter ? filter : get->filter,
                               filter_columns, select_columns, NULL, get->trash,
                               NULL, NULL, NULL, NULL, NULL);
+      if (clause && secinfo_index_ready ())
+        return sql_int ("SELECT count (id) FROM secinfo_index AS allinfo"
+                        " WHERE %s;",
+                        clause);
       if (clause)
         return sql_int ("SELECT count (id) FROM"
                         ALL_INFO_UNION_COLUMNS
@@ -1163,6 +1269,9 @@ total_info_count (const get_data_t *get, int filtered)
                         clause);
     }
 
+  if (secinfo_index_ready ())
+    return sql_int ("SELECT count (*) FROM secinfo_index;");
+
   return sql_int ("SELECT (SELECT count (*) FROM cves)"
                   " + (SELECT count (*) FROM cpes)"
                   " + (SELECT count (*) FROM nvts)"
@@ -1232,6 +1341,28 @@ init_all_info_iterator (iterator_t* iterator, get_data_t *get,
                           &order, &first, &max, NULL, NULL);
   columns = columns_build_select (select_columns);
 
+  if (secinfo_index_ready ())
+    {
+      /* One query on the index, so the database can page properly. */
+      init_iterator (iterator,
+                     "SELECT %s"
+                     " FROM secinfo_index AS allinfo"
+                     " %s%s"
+                     " %s"
+                     " LIMIT %s OFFSET %i;",
+                     columns,
+                     clause ? "WHERE " : "",
+                     clause ? clause : "",
+                     order,
+                     sql_select_limit (max),
+                     first);
+      g_free (order);
+      g_free (filter);
+      g_free (columns);
+      g_free (clause);
+      return 0;
+    }
+
   subselect_limit_clause = g_strdup_printf ("LIMIT %s",
                                             sql_select_limit (max + first));
 
@@ -1373,6 +1504,108 @@ init_ovaldi_file_iterator (iterator_t* iterator)
  */
 DEF_ACCESS (ovaldi_file_iterator_name, 0);
 
+
+/* SecInfo change log.
+ *
+ * While syncing, each item that was created or modified since the last
+ * SecInfo alert check is recorded in secinfo_changes, so that the alert
+ * checks only have to read the log instead of the whole SecInfo tables. */
+
+/**
+ * @brief Start logging the changes of a SecInfo sync.
+ *
+ * Nothing is logged if there has not been an alert check yet, because the
+ * first check only records the check time.
+ *
+ * @param[in]  check_time_name  Name of meta entry holding the check time.
+ * @param[in]  sync             Feed timestamp of the sync.
+ */
+static void
+change_log_init (const char *check_time_name, int sync)
+{
+  change_log_check_time
+   = sql_int ("SELECT coalesce (CAST ((SELECT value FROM meta"
+              "                        WHERE name = '%s')"
+              "                       AS INTEGER),"
+              "                 0);",
+              check_time_name);
+  change_log_sync = sync;
+}
+
+/**
+ * @brief Log a SecInfo item that was merged during a sync.
+ *
+ * @param[in]  type         Item type, for example "cve".
+ * @param[in]  quoted_uuid  SQL quoted UUID of item.
+ * @param[in]  created      Creation time of item.
+ * @param[in]  modified     Modification time of item.
+ */
+static void
+change_log_add (const char *type, const gchar *quoted_uuid, int created,
+                int modified)
+{
+  if (change_log_check_time == 0
+      || (created <= change_log_check_time
+          && modified <= change_log_check_time))
+    return;
+
+  sql ("INSERT INTO secinfo_changes (type, uuid, change, item_time, sync)"
+       " SELECT '%s', '%s', %i, %i, %i"
+       " WHERE NOT EXISTS (SELECT * FROM secinfo_changes"
+       "                   WHERE type = '%s' AND uuid = '%s');",
+       type,
+       quoted_uuid,
+       created > change_log_check_time
+        ? SECINFO_CHANGE_NEW
+        : SECINFO_CHANGE_UPDATED,
+       MAX (created, modified),
+       change_log_sync,
+       type,
+       quoted_uuid);
+}
+
+/**
+ * @brief Recheck the logged items of a type against their final times.
+ *
+ * For items whose times are adjusted after they are merged, like the
+ * placeholder CPEs.
+ *
+ * @param[in]  type   Item type, for example "cpe".
+ * @param[in]  table  Table holding the items.
+ */
+static void
+change_log_recheck (const char *type, const char *table)
+{
+  if (change_log_check_time == 0)
+    return;
+
+  sql ("DELETE FROM secinfo_changes"
+       " WHERE type = '%s'"
+       " AND NOT EXISTS (SELECT * FROM %s"
+       "                 WHERE uuid = secinfo_changes.uuid"
+       "                 AND (creation_time > %i"
+       "                      OR modification_time > %i));",
+       type,
+       table,
+       change_log_check_time,
+       change_log_check_time);
+
+  sql ("UPDATE secinfo_changes"
+       " SET change = (SELECT CASE WHEN creation_time > %i"
+       "                      THEN %i ELSE %i END"
+       "               FROM %s WHERE uuid = secinfo_changes.uuid),"
+       "     item_time = (SELECT %s (creation_time, modification_time)"
+       "                  FROM %s WHERE uuid = secinfo_changes.uuid)"
+       " WHERE type = '%s';",
+       change_log_check_time,
+       SECINFO_CHANGE_NEW,
+       SECINFO_CHANGE_UPDATED,
+       table,
+       sql_greatest (),
+       table,
+       type);
+}
+
 
 /* CERT update: DFN-CERT. */
 
@@ -1523,6 +1756,9 @@ update_dfn_xml (const gchar *xml_path, int last_cert_update,
                    quoted_title,
                    quoted_summary,
                    cve_refs);
+              change_log_add ("dfn_cert_adv", quoted_refnum,
+                              parse_iso_time (entity_text (published)),
+                              parse_iso_time (entity_text (updated)));
               increment_transaction_size (&transaction_size);
               g_free (quoted_title);
               g_free (quoted_summary);
@@ -1809,6 +2045,9 @@ update_bund_xml (const gchar *xml_path, int last_cert_update,
                    quoted_title,
                    quoted_summary,
                    cve_refs);
+              change_log_add ("cert_bund_adv", quoted_refnum,
+                              parse_iso_time (entity_text (date)),
+                              parse_iso_time (entity_text (date)));
               increment_transaction_size (&transaction_size);
               g_free (quoted_title);
               g_free (quoted_summary);
@@ -2103,6 +2342,9 @@ update_scap_cpes (int last_scap_update)
                    quoted_status,
                    deprecated ? deprecated : "NULL",
                    quoted_nvd_id);
+              change_log_add ("cpe", quoted_name,
+                              parse_iso_time (modification_date),
+                              parse_iso_time (modification_date));
               increment_transaction_size (&transaction_size);
               g_free (quoted_title);
               g_free (quoted_name);
@@ -2408,6 +2650,7 @@ update_cve_xml (const gchar *xml_path, int last_scap_update,
                    quoted_integrity_impact,
                    quoted_availability_impact,
                    quoted_software);
+              change_log_add ("cve", quoted_id, time_published, time_modified);
               increment_transaction_size (&transaction_size);
               g_free (quoted_summary);
               g_free (quoted_access_vector);
@@ -2452,6 +2695,10 @@ update_cve_xml (const gchar *xml_path, int last_scap_update,
                               sql ("SELECT merge_cpe_name ('%s', '%s', %i, %i)",
                                    quoted_product, quoted_product, time_published,
                                    time_modified);
+                              /* May be an existing CPE, so the times are
+                               * rechecked at the end of the sync. */
+                              change_log_add ("cpe", quoted_product,
+                                              time_published, time_modified);
                               sql ("SELECT merge_affected_product"
                                    "        (%llu,"
                                    "         (SELECT id FROM cpes"
@@ -3069,6 +3316,13 @@ update_ovaldef_xml (gchar **file_and_date, int last_scap_update,
                        quoted_xml_basename,
                        quoted_status,
                        cve_count);
+                  change_log_add ("ovaldef", quoted_id,
+                                  definition_date_oldest == 0
+                                   ? file_timestamp
+                                   : definition_date_newest,
+                                  definition_date_oldest == 0
+                                   ? file_timestamp
+                                   : definition_date_oldest);
                   increment_transaction_size (&transaction_size);
                   g_free (quoted_id);
                   g_free (quoted_class);
@@ -3934,6 +4188,38 @@ update_cvss_cert_bund (int updated_cert_bund, int last_cert_update,
     g_info ("Updating CERT-Bund CVSS max succeeded (nothing to do).");
 }
 
+/**
+ * @brief Update the CERT advisory flags of all NVTs.
+ *
+ * The result iterator reads these flags instead of searching the CERT
+ * advisories for each result.  Without the CERT database all flags are 0.
+ *
+ * Caller must organise transaction.
+ */
+void
+update_nvt_cert_flags ()
+{
+  if (manage_cert_loaded () == 0)
+    {
+      sql ("UPDATE nvts SET has_cert_bunds = 0, has_dfn_certs = 0;");
+      return;
+    }
+
+  sql ("UPDATE nvts"
+       " SET has_cert_bunds"
+       "       = (SELECT CASE WHEN EXISTS"
+       "                  (SELECT * FROM cert.cert_bund_cves"
+       "                   WHERE cve_name IN (SELECT cve_name FROM nvt_cves"
+       "                                      WHERE nvt_cves.oid = nvts.oid))"
+       "          THEN 1 ELSE 0 END),"
+       "     has_dfn_certs"
+       "       = (SELECT CASE WHEN EXISTS"
+       "                  (SELECT * FROM cert.dfn_cert_cves"
+       "                   WHERE cve_name IN (SELECT cve_name FROM nvt_cves"
+       "                                      WHERE nvt_cves.oid = nvts.oid))"
+       "          THEN 1 ELSE 0 END);");
+}
+
 /**
  * @brief Sync the CERT DB.
  *
@@ -4008,6 +4294,8 @@ sync_cert (int lockfile)
   if (manage_update_cert_db_init ())
     goto fail;
 
+  change_log_init ("cert_check_time", last_feed_update);
+
   g_info ("%s: Updating data from feed", __FUNCTION__);
 
   g_debug ("%s: update dfn", __FUNCTION__);
@@ -4040,6 +4328,25 @@ sync_cert (int lockfile)
   update_cvss_dfn_cert (updated_dfn_cert, last_cert_update, last_scap_update);
   update_cvss_cert_bund (updated_cert_bund, last_cert_update, last_scap_update);
 
+  g_debug ("%s: update index", __FUNCTION__);
+
+  sql_begin_immediate ();
+  secinfo_index_refresh ("cert");
+  sql_commit ();
+
+  g_debug ("%s: update NVT flags", __FUNCTION__);
+
+  sql_begin_immediate ();
+  update_nvt_cert_flags ();
+  sql_commit ();
+
+  g_debug ("%s: update NVT XML caches", __FUNCTION__);
+
+  /* The cached NVT XML includes CERT references. */
+  sql_begin_immediate ();
+  rebuild_nvt_xml_caches ();
+  sql_commit ();
+
   g_debug ("%s: update timestamp", __FUNCTION__);
 
   if (update_cert_timestamp ())
@@ -4115,6 +4422,7 @@ check_scap_db_version ()
       case 12:
       case 13:
       case 14:
+      case 15:
        g_info ("Reinitialization of the database necessary");
        return manage_db_reinit ("scap");
        break;
@@ -4222,6 +4530,33 @@ update_scap_cvss (int updated_cves, int updated_cpes, int updated_ovaldefs)
             " skipping CVSS recount for OVAL definitions.");
 }
 
+/**
+ * @brief Rebuild the CPE to CVE index used for prognostic results.
+ *
+ * The index keeps the CVEs of each CPE with a numeric CVSS, so that
+ * prognosis can look up and order the CVEs of a CPE without casting.
+ *
+ * @param[in]  updated_cves  Whether CVEs were updated.
+ * @param[in]  updated_cpes  Whether CPEs were updated.
+ */
+static void
+update_scap_cpe_cves (int updated_cves, int updated_cpes)
+{
+  if (updated_cves || updated_cpes)
+    {
+      g_info ("Updating CPE to CVE index");
+      sql ("DELETE FROM scap.cpe_cves;");
+      sql ("INSERT INTO scap.cpe_cves (cpe, cpe_name, cve, cve_name, cvss)"
+           " SELECT cpes.id, cpes.name, cves.id, cves.name,"
+           "        CAST (cves.cvss AS FLOAT)"
+           " FROM scap.affected_products, scap.cpes, scap.cves"
+           " WHERE cpes.id = affected_products.cpe"
+           " AND cves.id = affected_products.cve;");
+    }
+  else
+    g_info ("No CPEs or CVEs updated, skipping CPE to CVE index update.");
+}
+
 /**
  * @brief Update SCAP placeholder CVES.
  *
@@ -4327,6 +4662,8 @@ sync_scap (int lockfile)
   if (manage_update_scap_db_init ())
      goto fail;
 
+  change_log_init ("scap_check_time", last_feed_update);
+
   g_info ("%s: Updating data from feed", __FUNCTION__);
 
   g_debug ("%s: update cpes", __FUNCTION__);
@@ -4375,6 +4712,14 @@ sync_scap (int lockfile)
   update_scap_cvss (updated_scap_cves, updated_scap_cpes,
                     updated_scap_ovaldefs);
   update_scap_placeholders (updated_scap_cves);
+  update_scap_cpe_cves (updated_scap_cves, updated_scap_cpes);
+  change_log_recheck ("cpe", "scap.cpes");
+
+  g_debug ("%s: update index", __FUNCTION__);
+
+  sql_begin_immediate ();
+  secinfo_index_refresh ("scap");
+  sql_commit ();
 
   g_debug ("%s: update timestamp", __FUNCTION__);
 
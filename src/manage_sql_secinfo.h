@@ -28,20 +28,14 @@
 /**
  * @brief SQL to check if a result has CERT Bunds.
  */
-#define SECINFO_SQL_RESULT_HAS_CERT_BUNDS                          \
- "(SELECT EXISTS (SELECT * FROM cert_bund_cves"                    \
- "                WHERE cve_name IN (SELECT cve_name"              \
- "                                   FROM nvt_cves"                \
- "                                   WHERE oid = results.nvt)))"
+#define SECINFO_SQL_RESULT_HAS_CERT_BUNDS \
+ "coalesce ((SELECT has_cert_bunds FROM nvts WHERE nvts.oid = results.nvt), 0)"
 
 /**
  * @brief SQL to check if a result has CERT Bunds.
  */
-#define SECINFO_SQL_RESULT_HAS_DFN_CERTS                           \
- "(SELECT EXISTS (SELECT * FROM dfn_cert_cves"                     \
- "                WHERE cve_name IN (SELECT cve_name"              \
- "                                   FROM nvt_cves"                \
- "                                   WHERE oid = results.nvt)))"
+#define SECINFO_SQL_RESULT_HAS_DFN_CERTS \
+ "coalesce ((SELECT has_dfn_certs FROM nvts WHERE nvts.oid = results.nvt), 0)"
 
 /**
  * @brief Filter columns for CVE iterator.
@@ -323,6 +317,16 @@
  */
 #define SECINFO_COMMIT_SIZE_DEFAULT 0
 
+/**
+ * @brief SecInfo change log entry for an item created since the last check.
+ */
+#define SECINFO_CHANGE_NEW 1
+
+/**
+ * @brief SecInfo change log entry for an item modified since the last check.
+ */
+#define SECINFO_CHANGE_UPDATED 2
+
 void
 manage_sync_scap (sigset_t *);
 
@@ -338,7 +342,16 @@ check_cert_db_version ();
 int
 get_secinfo_commit_size ();
 
+int
+secinfo_index_ready ();
+
+void
+secinfo_index_refresh (const char *);
+
 void
 set_secinfo_commit_size (int);
 
+void
+update_nvt_cert_flags ();
+
 #endif /* not _GVMD_MANAGE_SQL_SECINFO_H */
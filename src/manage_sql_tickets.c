@@ -1482,13 +1482,23 @@ empty_trashcan_tickets ()
 /**
  * @brief Check if tickets have been resolved.
  *
+ * Sets all open and fixed tickets of the task to Fix Verified if the last
+ * report scanned the ticket host and no longer has a result for the ticket
+ * NVT on that host.  The tickets are selected with a single query and
+ * updated with a single statement.
+ *
  * @param[in]  task  Task.
+ *
+ * @return Array of the tickets that were set to Fix Verified, or NULL.
+ *         Caller must free with g_array_free.
  */
-void
+GArray *
 check_tickets (task_t task)
 {
   report_t report;
   iterator_t tickets;
+  GArray *verified;
+  GString *ids;
 
   if (task_last_report (task, &report))
     {
@@ -1496,62 +1506,69 @@ check_tickets (task_t task)
                  " skipping ticket check",
                  __FUNCTION__,
                  task);
-      return;
+      return NULL;
     }
 
+  if (report == 0)
+    return NULL;
+
+  /* Only if there were no login failures. */
+
+  if (sql_int ("SELECT EXISTS (SELECT * FROM results"
+               "               WHERE report = %llu"
+               /*              SSH Login Failed For Authenticated Checks. */
+               "               AND (nvt = '1.3.6.1.4.1.25623.1.0.105936'"
+               /*              SMB Login Failed For Authenticated Checks. */
+               "                    OR nvt = '1.3.6.1.4.1.25623.1.0.106091'));",
+               report))
+    return NULL;
+
+  verified = g_array_new (TRUE, TRUE, sizeof (ticket_t));
+  ids = g_string_new ("");
+
   init_iterator (&tickets,
                  "SELECT id FROM tickets"
                  " WHERE task = %llu"
                  " AND (status = %i"
                  "      OR status = %i)"
                  /* Only if the same host was scanned. */
-                 " AND EXISTS (SELECT * FROM report_hosts"
-                 "             WHERE report = %llu"
-                 "             AND report_hosts.host = tickets.host)"
-                 /* Only if the problem result is gone. */
-                 " AND NOT EXISTS (SELECT * FROM results"
-                 "                 WHERE report = %llu"
-                 "                 AND nvt = (SELECT nvt FROM results"
-                 "                            WHERE id = (SELECT result"
-                 "                                        FROM ticket_results"
-                 "                                        WHERE ticket = tickets.id"
-                 "                                        AND result_location = %i"
-                 "                                        LIMIT 1)))"
-                 /* Only if there were no login failures. */
-                 " AND NOT EXISTS (SELECT * FROM results"
-                 "                 WHERE report = %llu"
-                 /*                SSH Login Failed For Authenticated Checks. */
-                 "                 AND nvt = '1.3.6.1.4.1.25623.1.0.105936')"
+                 " AND host IN (SELECT host FROM report_hosts"
+                 "              WHERE report = %llu)"
+                 /* Only if the problem result is gone from the host. */
                  " AND NOT EXISTS (SELECT * FROM results"
-                 "                 WHERE report = %llu"
-                 /*                SMB Login Failed For Authenticated Checks. */
-                 "                 AND nvt = '1.3.6.1.4.1.25623.1.0.106091');",
+                 "                 WHERE results.report = %llu"
+                 "                 AND results.host = tickets.host"
+                 "                 AND results.nvt = tickets.nvt);",
                  task,
                  TICKET_STATUS_OPEN,
                  TICKET_STATUS_FIXED,
                  report,
-                 LOCATION_TABLE,
-                 report,
                  report);
   while (next (&tickets))
     {
       ticket_t ticket;
 
       ticket = iterator_int64 (&tickets, 0);
-
-      sql ("UPDATE tickets"
-           " SET status = %i,"
-           "     fix_verified_time = m_now (),"
-           "     fix_verified_report = %llu"
-           " WHERE id = %llu;",
-           TICKET_STATUS_FIX_VERIFIED,
-           report,
-           ticket);
-
-      event (EVENT_OWNED_TICKET_CHANGED, NULL, ticket, 0);
-      event (EVENT_ASSIGNED_TICKET_CHANGED, NULL, ticket, 0);
+      g_array_append_val (verified, ticket);
+      g_string_append_printf (ids, "%s%llu",
+                              verified->len > 1 ? ", " : "",
+                              ticket);
     }
   cleanup_iterator (&tickets);
+
+  if (verified->len)
+    sql ("UPDATE tickets"
+         " SET status = %i,"
+         "     fix_verified_time = m_now (),"
+         "     fix_verified_report = %llu"
+         " WHERE id IN (%s);",
+         TICKET_STATUS_FIX_VERIFIED,
+         report,
+         ids->str);
+
+  g_string_free (ids, TRUE);
+
+  return verified;
 }
 
 /**
@@ -30,13 +30,15 @@
 
 /**
  * @brief SQL to check if a result may have tickets.
+ *
+ * Every ticket_results row belongs to a live ticket, so this is a lookup on
+ * the ticket_results_by_result index.
  */
 #define TICKET_SQL_RESULT_MAY_HAVE_TICKETS                                     \
- "(SELECT EXISTS (SELECT * FROM tickets"                                       \
- "                WHERE id IN (SELECT ticket FROM ticket_results"              \
- "                             WHERE result = results.id"                      \
- "                             AND result_location"                            \
- "                                 = " G_STRINGIFY (LOCATION_TABLE) ")))"
+ "(SELECT EXISTS (SELECT * FROM ticket_results"                                \
+ "                WHERE result = results.id"                                   \
+ "                AND result_location"                                         \
+ "                    = " G_STRINGIFY (LOCATION_TABLE) "))"
 
 user_t
 ticket_owner (ticket_t);
@@ -56,8 +58,8 @@ restore_ticket (const char *);
 void
 empty_trashcan_tickets ();
 
-void
-check_tickets ();
+GArray *
+check_tickets (task_t);
 
 void
 delete_tickets_user (user_t);
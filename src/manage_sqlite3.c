@@ -34,12 +34,14 @@
 
 #include "sql.h"
 #include "manage.h"
+#include "manage_sql.h"
 #include "manage_utils.h"
 #include "manage_acl.h"
 
 #include <assert.h>
 #include <errno.h>
 #include <sqlite3.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
@@ -286,6 +288,59 @@ sql_order_inet (sqlite3_context *context, int argc, sqlite3_value** argv)
     }
 }
 
+/**
+ * @brief Convert a host into its binary address, for the host_inet columns.
+ *
+ * This is a callback for a scalar SQL function of one argument.
+ *
+ * @param[in]  context  SQL context.
+ * @param[in]  argc     Number of arguments.
+ * @param[in]  argv     Argument array.
+ */
+void
+sql_host_inet (sqlite3_context *context, int argc, sqlite3_value** argv)
+{
+  const char *host;
+  unsigned char key[16];
+
+  assert (argc == 1);
+
+  host = (const char *) sqlite3_value_text (argv[0]);
+  if (host_inet_key (host, key))
+    sqlite3_result_null (context);
+  else
+    sqlite3_result_blob (context, key, sizeof (key), SQLITE_TRANSIENT);
+}
+
+/**
+ * @brief Calculate the MD5 hash of a string, like md5 in Postgres.
+ *
+ * This is a callback for a scalar SQL function of one argument.
+ *
+ * @param[in]  context  SQL context.
+ * @param[in]  argc     Number of arguments.
+ * @param[in]  argv     Argument array.
+ */
+void
+sql_md5 (sqlite3_context *context, int argc, sqlite3_value** argv)
+{
+  const char *string;
+  gchar *hash;
+
+  assert (argc == 1);
+
+  string = (const char *) sqlite3_value_text (argv[0]);
+  if (string == NULL)
+    {
+      sqlite3_result_null (context);
+      return;
+    }
+
+  hash = g_compute_checksum_for_string (G_CHECKSUM_MD5, string, -1);
+  sqlite3_result_text (context, hash, -1, SQLITE_TRANSIENT);
+  g_free (hash);
+}
+
 /**
  * @brief Convert a message type into an integer for sorting.
  *
@@ -2817,6 +2872,34 @@ manage_create_sql_functions ()
       return -1;
     }
 
+  if (sqlite3_create_function (gvmd_db,
+                               "host_inet",
+                               1,               /* Number of args. */
+                               SQLITE_UTF8,
+                               NULL,            /* Callback data. */
+                               sql_host_inet,
+                               NULL,            /* xStep. */
+                               NULL)            /* xFinal. */
+      != SQLITE_OK)
+    {
+      g_warning ("%s: failed to create host_inet", __FUNCTION__);
+      return -1;
+    }
+
+  if (sqlite3_create_function (gvmd_db,
+                               "md5",
+                               1,               /* Number of args. */
+                               SQLITE_UTF8,
+                               NULL,            /* Callback data. */
+                               sql_md5,
+                               NULL,            /* xStep. */
+                               NULL)            /* xFinal. */
+      != SQLITE_OK)
+    {
+      g_warning ("%s: failed to create md5", __FUNCTION__);
+      return -1;
+    }
+
   if (sqlite3_create_function (gvmd_db,
                                "order_message_type",
                                1,               /* Number of args. */
@@ -3495,32 +3578,239 @@ manage_create_sql_functions ()
 
 /* Creation. */
 
+/**
+ * @brief Check whether an index exists.
+ *
+ * @param[in]  name  Name of index.
+ *
+ * @return 1 if the index exists, else 0.
+ */
+int
+manage_index_exists (const char *name)
+{
+  return sql_int ("SELECT count (*) FROM sqlite_master"
+                  " WHERE type = 'index' AND name = '%s';",
+                  name)
+         > 0;
+}
+
+/**
+ * @brief Check whether a column is the leading column of an index.
+ *
+ * @param[in]  table   Table.
+ * @param[in]  column  Column.
+ *
+ * @return 1 if an index starts with the column, 0 if not, -1 if the table
+ *         has no such column.
+ */
+int
+manage_column_indexed (const char *table, const char *column)
+{
+  iterator_t rows;
+  array_t *indexes;
+  int found, index;
+
+  /* The pragma_* table-valued functions need SQLite 3.16, so use the PRAGMA
+   * statements instead. */
+
+  found = 0;
+  init_iterator (&rows, "PRAGMA table_info (%s);", table);
+  while (found == 0 && next (&rows))
+    found = (strcmp (iterator_string (&rows, 1), column) == 0);
+  cleanup_iterator (&rows);
+  if (found == 0)
+    return -1;
+
+  indexes = make_array ();
+  init_iterator (&rows, "PRAGMA index_list (%s);", table);
+  while (next (&rows))
+    array_add (indexes, g_strdup (iterator_string (&rows, 1)));
+  cleanup_iterator (&rows);
+
+  found = 0;
+  for (index = 0; found == 0 && index < indexes->len; index++)
+    {
+      init_iterator (&rows, "PRAGMA index_info (%s);",
+                     (gchar*) g_ptr_array_index (indexes, index));
+      while (found == 0 && next (&rows))
+        found = (iterator_int (&rows, 0) == 0
+                 && iterator_string (&rows, 2)
+                 && strcmp (iterator_string (&rows, 2), column) == 0);
+      cleanup_iterator (&rows);
+    }
+  array_free (indexes);
+
+  return found;
+}
+
+/**
+ * @brief Check whether indexes on expressions are supported.
+ *
+ * SQLite supports them from version 3.9.0.
+ *
+ * @return 1 if supported, else 0.
+ */
+int
+manage_expression_indexes ()
+{
+  return sqlite3_libversion_number () >= 3009000;
+}
+
+/**
+ * @brief Check whether the current transaction is read only.
+ *
+ * @return 1 if read only, else 0.
+ */
+int
+manage_transaction_read_only ()
+{
+  return sql_int ("PRAGMA query_only;");
+}
+
+/**
+ * @brief Create an index if it does not exist yet.
+ *
+ * SQLite cannot build indexes concurrently, so the flag only means that
+ * errors are returned instead of aborting.
+ *
+ * @param[in]  name          Name of index.
+ * @param[in]  table         Table.
+ * @param[in]  columns       Indexed columns or expressions.
+ * @param[in]  concurrently  Whether to build the index concurrently.
+ *
+ * @return 0 success, -1 error.
+ */
+int
+manage_create_index (const char *name, const char *table,
+                     const char *columns, int concurrently)
+{
+  if (concurrently == 0)
+    {
+      sql ("CREATE INDEX IF NOT EXISTS %s ON %s (%s);", name, table, columns);
+      return 0;
+    }
+
+  if (sql_error ("CREATE INDEX IF NOT EXISTS %s ON %s (%s);",
+                 name, table, columns))
+    {
+      g_warning ("%s: failed to create index %s", __FUNCTION__, name);
+      return -1;
+    }
+  return 0;
+}
+
+/**
+ * @brief Create a list of indexes.
+ *
+ * @param[in]  indexes  Indexes, terminated by an entry with a NULL name.
+ */
+static void
+create_indexes (const db_index_t *indexes)
+{
+  while (indexes->name)
+    {
+      manage_create_index (indexes->name, indexes->table, indexes->columns,
+                           0);
+      indexes++;
+    }
+}
+
+/**
+ * @brief Indexes on the results table.
+ */
+static const db_index_t result_indexes[] =
+  {
+    { "results_by_uuid", "results", "uuid" },
+    { "results_by_host", "results", "host" },
+    { "results_by_host_and_qod", "results", "host, qod" },
+    { "results_by_host_inet", "results", "host_inet" },
+    { "results_by_report_host_inet", "results", "report, host_inet" },
+    { "results_by_nvt", "results", "nvt" },
+    { "results_by_report", "results", "report" },
+    { "results_by_report_host", "results", "report, host" },
+    { "results_by_task", "results", "task" },
+    { "results_by_task_qod_severity", "results", "task, qod, severity" },
+    { "results_by_type", "results", "type" },
+    { NULL, NULL, NULL }
+  };
+
 /**
  * @brief Create result indexes.
  */
 void
 manage_create_result_indexes ()
 {
-  sql ("CREATE INDEX IF NOT EXISTS results_by_uuid"
-       " ON results (uuid);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_host"
-       " ON results (host);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_host_and_qod"
-       " ON results (host, qod);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_nvt"
-       " ON results (nvt);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_report"
-       " ON results (report);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_report_host"
-       " ON results (report, host);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_task"
-       " ON results (task);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_task_qod_severity"
-       " ON results (task, qod, severity);");
-  sql ("CREATE INDEX IF NOT EXISTS results_by_type"
-       " ON results (type);");
+  create_indexes (result_indexes);
 }
 
+/**
+ * @brief Indexes created by create_tables, apart from the result indexes.
+ */
+static const db_index_t table_indexes[] =
+  {
+    { "host_details_by_host", "host_details", "host" },
+    { "host_identifiers_by_host", "host_identifiers", "host" },
+    { "host_identifiers_by_value", "host_identifiers", "value" },
+    { "notes_by_nvt_and_result", "notes", "nvt, result" },
+    { "notes_by_result", "notes", "result" },
+    { "nvt_cves_by_oid", "nvt_cves", "oid" },
+    { "nvt_selectors_by_family_or_nvt", "nvt_selectors",
+      "type, family_or_nvt" },
+    { "nvt_selectors_by_name", "nvt_selectors", "name" },
+    { "nvt_xml_caches_by_oid", "nvt_xml_caches", "oid" },
+    { "nvts_by_creation_time", "nvts", "creation_time" },
+    { "nvts_by_cvss_base", "nvts", "cvss_base" },
+    { "nvts_by_family", "nvts", "family" },
+    { "nvts_by_modification_time", "nvts", "modification_time" },
+    { "nvts_by_name", "nvts", "name" },
+    { "nvts_by_oid", "nvts", "oid" },
+    { "nvts_by_solution_type", "nvts", "solution_type" },
+    { "overrides_by_nvt_and_result", "overrides", "nvt, result" },
+    { "overrides_by_result", "overrides", "result" },
+    { "port_list_intervals_by_port_list", "port_list_intervals",
+      "port_list, type, start" },
+    { "port_list_intervals_trash_by_port_list", "port_list_intervals_trash",
+      "port_list" },
+    { "report_counts_by_report_and_override", "report_counts",
+      "report, override" },
+    { "report_counts_refresh_by_report", "report_counts_refresh",
+      "report, user" },
+    { "report_host_detail_rows_by_report_host_and_name",
+      "report_host_detail_rows",
+      "report_host, name" },
+    { "report_host_detail_rows_by_value_id", "report_host_detail_rows",
+      "value_id" },
+    { "report_host_detail_values_by_hash", "report_host_detail_values",
+      "hash" },
+    { "report_hosts_by_host", "report_hosts", "host" },
+    { "report_hosts_by_report", "report_hosts", "report" },
+    { "report_hosts_by_report_and_host_inet", "report_hosts",
+      "report, host_inet" },
+    { "reports_by_task", "reports", "task" },
+    { "result_nvt_reports_by_report", "result_nvt_reports", "report" },
+    { "secinfo_changes_by_type_and_uuid", "secinfo_changes", "type, uuid" },
+    { "secinfo_index_by_created", "secinfo_index", "created" },
+    { "secinfo_index_by_modified", "secinfo_index", "modified" },
+    { "secinfo_index_by_name", "secinfo_index", "name" },
+    { "secinfo_index_by_severity", "secinfo_index", "severity" },
+    { "secinfo_index_by_type_and_uuid", "secinfo_index", "type, uuid" },
+    { "slow_filter_queries_by_table_and_shape", "slow_filter_queries",
+      "table_name, shape" },
+    { "tag_resources_by_resource", "tag_resources",
+      "resource_type, resource, resource_location" },
+    { "tag_resources_by_resource_uuid", "tag_resources",
+      "resource_type, resource_uuid" },
+    { "tag_resources_by_tag", "tag_resources", "tag" },
+    { "tag_resources_trash_by_tag", "tag_resources_trash", "tag" },
+    { "tags_by_name", "tags", "name" },
+    { "task_report_summaries_by_report", "task_report_summaries",
+      "report, user, override, min_qod" },
+    { "task_report_summaries_by_task", "task_report_summaries", "task" },
+    { "ticket_results_by_result", "ticket_results",
+      "result, result_location" },
+    { NULL, NULL, NULL }
+  };
+
 /**
  * @brief Create all tables.
  */
@@ -3547,6 +3837,9 @@ create_tables ()
   sql ("CREATE TABLE IF NOT EXISTS config_preferences_trash"
        " (id INTEGER PRIMARY KEY, config INTEGER, type, name, value,"
        "  default_value, hr_name TEXT);");
+  sql ("CREATE TABLE IF NOT EXISTS config_otp_caches"
+       " (id INTEGER PRIMARY KEY, config INTEGER, modification_time INTEGER,"
+       "  feed_version, plugins TEXT, server_prefs TEXT, plugins_prefs TEXT);");
   sql ("CREATE TABLE IF NOT EXISTS configs"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner INTEGER, name,"
        "  nvt_selector, comment, family_count INTEGER, nvt_count INTEGER,"
@@ -3613,10 +3906,6 @@ create_tables ()
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, host INTEGER, owner INTEGER, name,"
        "  comment, value, source_type, source_id, source_data, creation_time,"
        "  modification_time);");
-  sql ("CREATE INDEX IF NOT EXISTS host_identifiers_by_host"
-       " ON host_identifiers (host);");
-  sql ("CREATE INDEX IF NOT EXISTS host_identifiers_by_value"
-       " ON host_identifiers (value);");
   sql ("CREATE TABLE IF NOT EXISTS oss"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner INTEGER, name, comment,"
        "  creation_time, modification_time);");
@@ -3638,12 +3927,16 @@ create_tables ()
        "  detail_source_description,"
        "  name,"
        "  value);");
-  sql ("CREATE INDEX IF NOT EXISTS host_details_by_host"
-       " ON host_details (host);");
   sql ("CREATE TABLE IF NOT EXISTS auth_cache"
        " (id INTEGER PRIMARY KEY, username, hash, method, creation_time);");
   sql ("CREATE TABLE IF NOT EXISTS meta"
        " (id INTEGER PRIMARY KEY, name UNIQUE, value);");
+  sql ("CREATE TABLE IF NOT EXISTS secinfo_changes"
+       " (id INTEGER PRIMARY KEY, type, uuid, change INTEGER,"
+       "  item_time INTEGER, sync INTEGER);");
+  sql ("CREATE TABLE IF NOT EXISTS secinfo_index"
+       " (id INTEGER PRIMARY KEY, type, uuid, name, comment, created INTEGER,"
+       "  modified INTEGER, extra, severity REAL);");
   sql ("CREATE TABLE IF NOT EXISTS notes"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner INTEGER, nvt,"
        "  creation_time, modification_time, text, hosts, port, severity,"
@@ -3659,33 +3952,17 @@ create_tables ()
   sql ("CREATE TABLE IF NOT EXISTS nvt_selectors"
        " (id INTEGER PRIMARY KEY, name, exclude INTEGER, type INTEGER,"
        "  family_or_nvt, family);");
-  sql ("CREATE INDEX IF NOT EXISTS nvt_selectors_by_name"
-       " ON nvt_selectors (name);");
-  sql ("CREATE INDEX IF NOT EXISTS nvt_selectors_by_family_or_nvt"
-       " ON nvt_selectors (type, family_or_nvt);");
   sql ("CREATE TABLE IF NOT EXISTS nvts"
        " (id INTEGER PRIMARY KEY, uuid, oid, name, comment,"
        "  cve, bid, xref, tag, category INTEGER, family, cvss_base,"
        "  creation_time, modification_time, solution_type TEXT, qod INTEGER,"
-       "  qod_type TEXT);");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_oid"
-       " ON nvts (oid);");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_name"
-       " ON nvts (name);");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_family"
-       " ON nvts (family);");
+       "  qod_type TEXT, has_cert_bunds INTEGER DEFAULT 0,"
+       "  has_dfn_certs INTEGER DEFAULT 0);");
   sql ("CREATE TABLE IF NOT EXISTS nvt_cves"
        " (nvt, oid, cve_name)");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_creation_time"
-       " ON nvts (creation_time);");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_modification_time"
-       " ON nvts (modification_time);");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_cvss_base"
-       " ON nvts (cvss_base);");
-  sql ("CREATE INDEX IF NOT EXISTS nvts_by_solution_type"
-       " ON nvts (solution_type);");
-  sql ("CREATE INDEX IF NOT EXISTS nvt_cves_by_oid"
-       " ON nvt_cves (oid);");
+  sql ("CREATE TABLE IF NOT EXISTS nvt_xml_caches"
+       " (id INTEGER PRIMARY KEY, oid, modification_time INTEGER, xml TEXT,"
+       "  default_timeout, cert_loaded INTEGER);");
   sql ("CREATE TABLE IF NOT EXISTS overrides"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner INTEGER, nvt, result_nvt,"
        "  creation_time, modification_time, text, hosts, port, severity,"
@@ -3725,19 +4002,30 @@ create_tables ()
   sql ("CREATE TABLE IF NOT EXISTS port_ranges_trash"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, port_list INTEGER, type, start,"
        "  end, comment, exclude);");
-  sql ("CREATE TABLE IF NOT EXISTS report_host_details"
+  sql ("CREATE TABLE IF NOT EXISTS port_list_intervals"
+       " (id INTEGER PRIMARY KEY, port_list INTEGER, type INTEGER,"
+       "  start INTEGER, end INTEGER);");
+  sql ("CREATE TABLE IF NOT EXISTS port_list_intervals_trash"
+       " (id INTEGER PRIMARY KEY, port_list INTEGER, type INTEGER,"
+       "  start INTEGER, end INTEGER);");
+  sql ("CREATE TABLE IF NOT EXISTS report_host_detail_values"
+       " (id INTEGER PRIMARY KEY, hash, value);");
+  sql ("CREATE TABLE IF NOT EXISTS report_host_detail_rows"
        " (id INTEGER PRIMARY KEY, report_host INTEGER, source_type, source_name,"
-       "  source_description, name, value);");
-  sql ("CREATE INDEX IF NOT EXISTS"
-       " report_host_details_by_report_host_and_name_and_value"
-       " ON report_host_details (report_host, name, value);");
+       "  source_description, name, value_id INTEGER);");
+  sql ("CREATE TABLE IF NOT EXISTS report_host_detail_values_sweep"
+       " (id INTEGER PRIMARY KEY, value_id INTEGER);");
+  sql ("DROP VIEW IF EXISTS report_host_details;");
+  sql ("CREATE VIEW report_host_details AS"
+       " SELECT report_host_detail_rows.id AS id, report_host, source_type,"
+       "        source_name, source_description, name,"
+       "        report_host_detail_values.value AS value"
+       " FROM report_host_detail_rows"
+       " JOIN report_host_detail_values"
+       " ON report_host_detail_values.id = report_host_detail_rows.value_id;");
   sql ("CREATE TABLE IF NOT EXISTS report_hosts"
        " (id INTEGER PRIMARY KEY, report INTEGER, host, start_time, end_time,"
-       "  current_port, max_port);");
-  sql ("CREATE INDEX IF NOT EXISTS report_hosts_by_host"
-       " ON report_hosts (host);");
-  sql ("CREATE INDEX IF NOT EXISTS report_hosts_by_report"
-       " ON report_hosts (report);");
+       "  current_port, max_port, host_inet BLOB);");
   sql ("CREATE TABLE IF NOT EXISTS report_format_param_options"
        " (id INTEGER PRIMARY KEY, report_format_param, value);");
   sql ("CREATE TABLE IF NOT EXISTS report_format_param_options_trash"
@@ -3762,33 +4050,34 @@ create_tables ()
        "  task INTEGER, date INTEGER, start_time, end_time, nbefile, comment,"
        "  scan_run_status INTEGER, slave_progress, slave_task_uuid,"
        "  slave_uuid, slave_name, slave_host, slave_port, source_iface,"
-       "  flags INTEGER);");
-  sql ("CREATE INDEX IF NOT EXISTS reports_by_task"
-       " ON reports (task);");
+       "  flags INTEGER, progress_sum INTEGER, progress_dead INTEGER,"
+       "  progress_max_hosts INTEGER, port_count INTEGER);");
   sql ("CREATE TABLE IF NOT EXISTS report_counts"
        " (id INTEGER PRIMARY KEY, report INTEGER, user INTEGER,"
        "  severity, count, override, end_time INTEGER, min_qod INTEGER);");
-  sql ("CREATE INDEX IF NOT EXISTS report_counts_by_report_and_override"
-       " ON report_counts (report, override);");
+  sql ("CREATE TABLE IF NOT EXISTS task_report_summaries"
+       " (id INTEGER PRIMARY KEY, task INTEGER, report INTEGER, user INTEGER,"
+       "  override INTEGER, min_qod INTEGER, date INTEGER, high INTEGER,"
+       "  medium INTEGER, low INTEGER, log INTEGER, false_positive INTEGER,"
+       "  severity REAL, end_time INTEGER);");
+  sql ("CREATE TABLE IF NOT EXISTS report_counts_refresh"
+       " (id INTEGER PRIMARY KEY, report INTEGER, user INTEGER);");
   sql ("CREATE TABLE IF NOT EXISTS resources_predefined"
        " (id INTEGER PRIMARY KEY, resource_type, resource INTEGER)");
   sql ("CREATE TABLE IF NOT EXISTS results"
        " (id INTEGER PRIMARY KEY, uuid, task INTEGER, host, port, nvt,"
        "  result_nvt, type, description, report, nvt_version, severity REAL,"
        "  qod INTEGER, qod_type TEXT, owner INTEGER, date INTEGER,"
-       "  hostname TEXT)");
+       "  hostname TEXT, host_inet BLOB)");
   sql ("CREATE TABLE IF NOT EXISTS results_trash"
        " (id INTEGER PRIMARY KEY, uuid, task INTEGER, host, port, nvt,"
        "  result_nvt, type, description, report, nvt_version, severity REAL,"
        "  qod INTEGER, qod_type TEXT, owner INTEGER, date INTEGER,"
        "  hostname TEXT)");
-  manage_create_result_indexes ();
   sql ("CREATE TABLE IF NOT EXISTS result_nvts"
        " (id SERIAL PRIMARY KEY, nvt text UNIQUE NOT NULL);");
   sql ("CREATE TABLE IF NOT EXISTS result_nvt_reports"
        " (result_nvt INTEGER, report INTEGER);");
-  sql ("CREATE INDEX IF NOT EXISTS result_nvt_reports_by_report"
-       " ON result_nvt_reports (report);");
   sql ("CREATE TABLE IF NOT EXISTS roles"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner INTEGER, name, comment,"
        "  creation_time, modification_time);");
@@ -3835,23 +4124,21 @@ create_tables ()
        "  initial_offset, creation_time, modification_time, icalendar);");
   sql ("CREATE TABLE IF NOT EXISTS settings"
        " (id INTEGER PRIMARY KEY, uuid, owner INTEGER, name, comment, value);");
+  sql ("CREATE TABLE IF NOT EXISTS slow_filter_queries"
+       " (id INTEGER PRIMARY KEY, table_name, shape, duration INTEGER,"
+       "  time INTEGER);");
+  sql ("CREATE TABLE IF NOT EXISTS advised_indexes"
+       " (id INTEGER PRIMARY KEY, name UNIQUE NOT NULL, table_name, shape,"
+       "  creation_time INTEGER, slow_count INTEGER, slow_duration INTEGER);");
   sql ("CREATE TABLE IF NOT EXISTS tags"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner, name, comment,"
        "  creation_time, modification_time, resource_type,"
        "  active, value);");
-  sql ("CREATE INDEX IF NOT EXISTS tags_by_name"
-       " ON tags (name);");
   sql ("CREATE UNIQUE INDEX IF NOT EXISTS tags_by_uuid"
        " ON tags (uuid);");
   sql ("CREATE TABLE IF NOT EXISTS tag_resources"
        " (tag INTEGER, resource_type text, resource INTEGER,"
        "  resource_uuid TEXT, resource_location INTEGER);");
-  sql ("CREATE INDEX IF NOT EXISTS tag_resources_by_resource"
-       " ON tag_resources (resource_type, resource, resource_location);");
-  sql ("CREATE INDEX IF NOT EXISTS tag_resources_by_resource_uuid"
-       " ON tag_resources (resource_type, resource_uuid);");
-  sql ("CREATE INDEX IF NOT EXISTS tag_resources_by_tag"
-       " ON tag_resources (tag);");
   sql ("CREATE TABLE IF NOT EXISTS tags_trash"
        " (id INTEGER PRIMARY KEY, uuid UNIQUE, owner, name, comment,"
        "  creation_time, modification_time, resource_type,"
@@ -3859,8 +4146,6 @@ create_tables ()
   sql ("CREATE TABLE IF NOT EXISTS tag_resources_trash"
        " (tag INTEGER, resource_type text, resource INTEGER,"
        "  resource_uuid TEXT, resource_location INTEGER);");
-  sql ("CREATE INDEX IF NOT EXISTS tag_resources_trash_by_tag"
-       " ON tag_resources_trash (tag);");
   sql ("CREATE TABLE IF NOT EXISTS targets"
        " (id INTEGER PRIMARY KEY, uuid text UNIQUE NOT NULL,"
        "  owner integer, name text NOT NULL,"
@@ -4061,6 +4346,11 @@ create_tables ()
 
   /* Vulnerabilities view is created in manage_session_init because
      it must be temporary to allow using the attached SCAP database */
+
+  /* Create indexes. */
+
+  create_indexes (table_indexes);
+  manage_create_result_indexes ();
 }
 
 /**
@@ -4287,6 +4577,7 @@ manage_db_init (const gchar *name)
       sql ("DROP TABLE IF EXISTS scap.cves;");
       sql ("DROP TABLE IF EXISTS scap.cpes;");
       sql ("DROP TABLE IF EXISTS scap.affected_products;");
+      sql ("DROP TABLE IF EXISTS scap.cpe_cves;");
       sql ("DROP TABLE IF EXISTS scap.oval_def;");
       sql ("DROP TABLE IF EXISTS scap.ovaldefs;");
       sql ("DROP TABLE IF EXISTS scap.ovalfiles;");
@@ -4356,6 +4647,16 @@ manage_db_init (const gchar *name)
       sql ("CREATE INDEX scap.afp_cve_idx"
            " ON affected_products (cve);");
 
+      sql ("CREATE TABLE scap.cpe_cves"
+           " (id INTEGER PRIMARY KEY AUTOINCREMENT,"
+           "  cpe INTEGER,"
+           "  cpe_name,"
+           "  cve INTEGER,"
+           "  cve_name,"
+           "  cvss FLOAT DEFAULT 0);");
+      sql ("CREATE INDEX scap.cpe_cves_by_cpe_name"
+           " ON cpe_cves (cpe_name, cvss);");
+
       sql ("CREATE TABLE scap.ovaldefs"
            " (id INTEGER PRIMARY KEY AUTOINCREMENT,"
            "  uuid UNIQUE,"
@@ -4422,7 +4723,7 @@ manage_db_init (const gchar *name)
       /* Init tables. */
 
       sql ("INSERT INTO scap.meta (name, value)"
-           " VALUES ('database_version', '15');");
+           " VALUES ('database_version', '16');");
       sql ("INSERT INTO scap.meta (name, value)"
            " VALUES ('last_update', '0');");
     }
@@ -4844,9 +5145,33 @@ manage_update_scap_db_cleanup ()
 
 /* Backup. */
 
+/**
+ * @brief Number of pages to copy in each backup step.
+ */
+#define BACKUP_STEP_PAGES 1000
+
+/**
+ * @brief Pause between backup steps, in milliseconds.
+ *
+ * This leaves other gvmd processes some I/O while the backup runs.
+ */
+#define BACKUP_STEP_PAUSE 10
+
+/**
+ * @brief Number of times a backup may restart before it gives up.
+ */
+#define BACKUP_MAX_RESTARTS 5
+
 /**
  * @brief Backup the database to a file.
  *
+ * The backup is written to a temporary file, which is checked and then
+ * renamed to the backup file.
+ *
+ * The backup holds a read transaction on the database for the whole copy.
+ * With the WAL journal other processes can keep writing, and their writes
+ * do not restart the copy, because it reads a single snapshot.
+ *
  * @param[in]   database         Database to backup.
  * @param[out]  backup_file_arg  Location for freshly allocated name of backup
  *                               file, or NULL.  Only set on success.
@@ -4856,13 +5181,16 @@ manage_update_scap_db_cleanup ()
 static int
 backup_db (const gchar *database, gchar **backup_file_arg)
 {
-  gchar *backup_file;
+  gchar *backup_file, *part_file, *check;
   sqlite3 *backup_db, *actual_gvmd_db;
   sqlite3_backup *backup;
+  int last_percent, last_remaining, restarts;
 
   backup_file = g_strdup_printf ("%s.bak", database);
+  part_file = g_strdup_printf ("%s.part", backup_file);
+  unlink (part_file);
 
-  if (sqlite3_open (backup_file, &backup_db) != SQLITE_OK)
+  if (sqlite3_open (part_file, &backup_db) != SQLITE_OK)
     {
       g_warning ("%s: sqlite3_open failed: %s",
                  __FUNCTION__,
@@ -4876,24 +5204,69 @@ backup_db (const gchar *database, gchar **backup_file_arg)
   sql ("PRAGMA journal_mode=DELETE;");
   gvmd_db = actual_gvmd_db;
 
+  /* Read the whole copy from one snapshot. */
+  sql ("BEGIN;");
+  sql ("SELECT count (*) FROM sqlite_master;");
+
   backup = sqlite3_backup_init (backup_db, "main", gvmd_db, "main");
   if (backup == NULL)
     {
       g_warning ("%s: sqlite3_backup_init failed: %s",
                  __FUNCTION__,
                  sqlite3_errmsg (backup_db));
+      sql_rollback ();
       goto fail;
     }
 
+  last_percent = -1;
+  last_remaining = -1;
+  restarts = 0;
   while (1)
     {
-      int ret;
+      int ret, pages, remaining;
 
-      ret = sqlite3_backup_step (backup, 20 /* pages */);
+      ret = sqlite3_backup_step (backup, BACKUP_STEP_PAGES);
       if (ret == SQLITE_DONE)
         break;
+
+      /* The copy starts again if the source changed under it. */
+      remaining = sqlite3_backup_remaining (backup);
+      if (last_remaining >= 0 && remaining > last_remaining)
+        {
+          restarts++;
+          if (restarts > BACKUP_MAX_RESTARTS)
+            {
+              g_warning ("%s: backup restarted %i times because the"
+                         " database kept changing, giving up",
+                         __FUNCTION__,
+                         restarts);
+              sqlite3_backup_finish (backup);
+              sql_rollback ();
+              goto fail;
+            }
+          g_info ("   Backup restarted, because the database changed.");
+          last_percent = -1;
+        }
+      last_remaining = remaining;
+
+      pages = sqlite3_backup_pagecount (backup);
+      if (pages > 0)
+        {
+          int percent;
+
+          percent = ((pages - remaining) * 100) / pages;
+          if (percent / 10 > last_percent / 10)
+            {
+              g_info ("   Backed up %i%% (%i pages).", percent, pages);
+              last_percent = percent;
+            }
+        }
+
       if (ret == SQLITE_OK)
-        continue;
+        {
+          sqlite3_sleep (BACKUP_STEP_PAUSE);
+          continue;
+        }
       if (ret == SQLITE_BUSY || ret == SQLITE_LOCKED)
         {
           sqlite3_sleep (250);
@@ -4903,10 +5276,40 @@ backup_db (const gchar *database, gchar **backup_file_arg)
                  __FUNCTION__,
                  sqlite3_errmsg (backup_db));
       sqlite3_backup_finish (backup);
+      sql_rollback ();
       goto fail;
     }
   sqlite3_backup_finish (backup);
+  sql_rollback ();
+
+  /* Check the copy. */
+
+  actual_gvmd_db = gvmd_db;
+  gvmd_db = backup_db;
+  check = sql_string ("PRAGMA quick_check;");
+  gvmd_db = actual_gvmd_db;
+  if (check == NULL || strcmp (check, "ok"))
+    {
+      g_warning ("%s: check of backup failed: %s",
+                 __FUNCTION__,
+                 check ? check : "no result");
+      g_free (check);
+      goto fail;
+    }
+  g_free (check);
+
   sqlite3_close (backup_db);
+  backup_db = NULL;
+
+  if (rename (part_file, backup_file))
+    {
+      g_warning ("%s: failed to rename %s: %s",
+                 __FUNCTION__,
+                 part_file,
+                 strerror (errno));
+      goto fail;
+    }
+  g_free (part_file);
 
   if (backup_file_arg)
     *backup_file_arg = backup_file;
@@ -4916,6 +5319,8 @@ backup_db (const gchar *database, gchar **backup_file_arg)
 
  fail:
   sqlite3_close (backup_db);
+  unlink (part_file);
+  g_free (part_file);
   g_free (backup_file);
   return -1;
 }
@@ -24,6 +24,7 @@
 
 #include "manage_utils.h"
 
+#include <arpa/inet.h> /* for inet_pton */
 #include <assert.h> /* for assert */
 #include <stdlib.h> /* for getenv */
 #include <stdio.h>  /* for sscanf */
@@ -749,6 +750,95 @@ hosts_str_contains (const char* hosts_str, const char* find_host_str,
   return ret;
 }
 
+/**
+ * @brief Get the binary form of a host, for the host_inet columns.
+ *
+ * IPv4 addresses are mapped into IPv6 (::ffff:a.b.c.d), so that all
+ * addresses compare correctly as 16 byte strings.
+ *
+ * @param[in]   host  Host.
+ * @param[out]  key   Binary address.
+ *
+ * @return 0 if host is an IP address, -1 otherwise.
+ */
+int
+host_inet_key (const char *host, unsigned char *key)
+{
+  struct in_addr ipv4;
+
+  if (host == NULL)
+    return -1;
+
+  if (inet_pton (AF_INET, host, &ipv4) == 1)
+    {
+      memset (key, 0, 10);
+      key[10] = 0xff;
+      key[11] = 0xff;
+      memcpy (key + 12, &ipv4.s_addr, 4);
+      return 0;
+    }
+
+  if (inet_pton (AF_INET6, host, key) == 1)
+    return 0;
+
+  return -1;
+}
+
+/**
+ * @brief Get the lowest and highest binary addresses in a host range.
+ *
+ * @param[in]   range  Address or CIDR network, like 10.0.0.0/8.
+ * @param[out]  low    Lowest binary address.
+ * @param[out]  high   Highest binary address.
+ *
+ * @return 0 if range is an address or CIDR network, -1 otherwise.
+ */
+int
+host_inet_range (const char *range, unsigned char *low, unsigned char *high)
+{
+  gchar **split;
+  int prefix, ret, index;
+
+  if (range == NULL)
+    return -1;
+
+  split = g_strsplit (range, "/", 2);
+  ret = host_inet_key (split[0], low);
+  prefix = 128;
+  if (ret == 0 && split[1])
+    {
+      char *end;
+
+      prefix = strtol (split[1], &end, 10);
+      if (*split[1] == '\0' || *end != '\0' || prefix < 0
+          || prefix > (strchr (split[0], ':') ? 128 : 32))
+        ret = -1;
+      else if (strchr (split[0], ':') == NULL)
+        prefix += 96;
+    }
+  g_strfreev (split);
+  if (ret)
+    return -1;
+
+  for (index = 0; index < 16; index++)
+    {
+      int bits;
+      unsigned char mask;
+
+      bits = prefix - index * 8;
+      if (bits >= 8)
+        mask = 0xff;
+      else if (bits <= 0)
+        mask = 0;
+      else
+        mask = 0xff << (8 - bits);
+      low[index] &= mask;
+      high[index] = low[index] | (unsigned char) ~mask;
+    }
+
+  return 0;
+}
+
 /**
  * @brief Check whether a resource type table name is valid.
  *
@@ -76,6 +76,12 @@ valid_db_resource_type (const char*);
 int
 hosts_str_contains (const char*, const char*, int);
 
+int
+host_inet_key (const char *, unsigned char *);
+
+int
+host_inet_range (const char *, unsigned char *, unsigned char *);
+
 icalcomponent *
 icalendar_from_old_schedule_data (time_t, time_t, time_t, time_t, int,
                                   const char *);
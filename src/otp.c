@@ -755,6 +755,32 @@ parse_scanner_loading (char *messages)
     from_scanner_start += str - messages;
 }
 
+/**
+ * @brief Check whether a task status at the end of a scan means the scan
+ * @brief finished normally.
+ *
+ * @param[in]  status  Run status of the task.
+ *
+ * @return 1 if finished normally, else 0.
+ */
+static int
+scan_end_status_done (task_status_t status)
+{
+  switch (status)
+    {
+      case TASK_STATUS_INTERRUPTED:
+      case TASK_STATUS_STOP_REQUESTED:
+      case TASK_STATUS_STOP_WAITING:
+      case TASK_STATUS_DELETE_REQUESTED:
+      case TASK_STATUS_DELETE_WAITING:
+      case TASK_STATUS_DELETE_ULTIMATE_REQUESTED:
+      case TASK_STATUS_DELETE_ULTIMATE_WAITING:
+        return 0;
+      default:
+        return 1;
+    }
+}
+
 /**
  * @brief Process any lines available in \ref from_scanner.
  *
@@ -1580,19 +1606,27 @@ process_otp_scanner_input ()
                 {
                   if (current_scanner_task)
                     {
+                      task_status_t run_status;
+
                       /* Stop transaction now, because delete_task_lock and
                        * set_scan_end_time_otp run transactions themselves. */
                       manage_transaction_stop (TRUE);
+                      run_status = task_run_status (current_scanner_task);
                       if (global_current_report)
                         {
-                          hosts_set_identifiers (global_current_report);
-                          hosts_set_max_severity (global_current_report,
-                                                  NULL,
-                                                  NULL);
-                          hosts_set_details (global_current_report);
+                          /* A scan that finishes normally adds its results
+                           * to the assets in the scan end jobs. */
+                          if (scan_end_status_done (run_status) == 0)
+                            {
+                              hosts_set_identifiers (global_current_report);
+                              hosts_set_max_severity (global_current_report,
+                                                      NULL,
+                                                      NULL);
+                              hosts_set_details (global_current_report);
+                            }
                           set_scan_end_time_otp (global_current_report, field);
                         }
-                      switch (task_run_status (current_scanner_task))
+                      switch (run_status)
                         {
                           case TASK_STATUS_INTERRUPTED:
                             break;
@@ -1618,8 +1652,8 @@ process_otp_scanner_input ()
                           default:
                             set_task_end_time (current_scanner_task,
                                                g_strdup (field));
-                            set_task_run_status (current_scanner_task,
-                                                 TASK_STATUS_DONE);
+                            set_task_run_status_done (current_scanner_task,
+                                                      1);
                         }
                       clear_duration_schedules (current_scanner_task);
                       update_duration_schedule_periods (current_scanner_task);
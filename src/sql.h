@@ -77,6 +77,9 @@ sql_changes ();
 resource_t
 sql_last_insert_id ();
 
+long long int
+sql_copy_out (const char *, int (*) (const char *, int, void *), void *);
+
 gchar *
 sql_nquote (const char *, size_t);
 
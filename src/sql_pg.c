@@ -416,6 +416,76 @@ sql_last_insert_id ()
   return sql_int ("SELECT LASTVAL ();");
 }
 
+/**
+ * @brief Run a COPY TO STDOUT statement, passing each row to a callback.
+ *
+ * The rows are streamed from the server, so the whole result is never held
+ * in memory.
+ *
+ * @param[in]  copy      COPY ... TO STDOUT statement.
+ * @param[in]  callback  Function called with each row, in COPY text format
+ *                       including the trailing newline.  Returns 0 to
+ *                       continue, else error.
+ * @param[in]  data      Data for callback.
+ *
+ * @return Number of rows copied, or -1 on error.
+ */
+long long int
+sql_copy_out (const char *copy, int (*callback) (const char *, int, void *),
+              void *data)
+{
+  PGresult *result;
+  char *buffer;
+  int len, failed;
+  long long int rows;
+
+  result = PQexec (conn, copy);
+  if (PQresultStatus (result) != PGRES_COPY_OUT)
+    {
+      g_warning ("%s: PQexec failed: %s (%i)",
+                 __FUNCTION__,
+                 PQresultErrorMessage (result),
+                 PQresultStatus (result));
+      g_warning ("%s: SQL: %s", __FUNCTION__, copy);
+      PQclear (result);
+      return -1;
+    }
+  PQclear (result);
+
+  rows = 0;
+  failed = 0;
+  while ((len = PQgetCopyData (conn, &buffer, 0)) > 0)
+    {
+      /* After a failure keep reading, to leave the connection usable. */
+      if (failed == 0 && callback (buffer, len, data))
+        failed = 1;
+      PQfreemem (buffer);
+      rows++;
+    }
+
+  if (len == -2)
+    {
+      g_warning ("%s: PQgetCopyData failed: %s",
+                 __FUNCTION__,
+                 PQerrorMessage (conn));
+      failed = 1;
+    }
+
+  while ((result = PQgetResult (conn)))
+    {
+      if (PQresultStatus (result) != PGRES_COMMAND_OK)
+        {
+          g_warning ("%s: COPY failed: %s",
+                     __FUNCTION__,
+                     PQresultErrorMessage (result));
+          failed = 1;
+        }
+      PQclear (result);
+    }
+
+  return failed ? -1 : rows;
+}
+
 /**
  * @brief Perform an SQL statement, retrying if database is busy or locked.
  *
@@ -331,6 +331,25 @@ sql_last_insert_id ()
   return sqlite3_last_insert_rowid (gvmd_db);
 }
 
+/**
+ * @brief Run a COPY TO STDOUT statement.
+ *
+ * Not supported by SQLite.
+ *
+ * @param[in]  copy      COPY statement.
+ * @param[in]  callback  Row callback.
+ * @param[in]  data      Data for callback.
+ *
+ * @return -1.
+ */
+long long int
+sql_copy_out (const char *copy, int (*callback) (const char *, int, void *),
+              void *data)
+{
+  g_warning ("%s: COPY is not supported by SQLite", __FUNCTION__);
+  return -1;
+}
+
 /**
  * @brief Perform an SQL statement, retrying if database is busy or locked.
  *